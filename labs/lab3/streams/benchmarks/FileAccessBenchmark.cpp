@@ -0,0 +1,83 @@
+#include "../src/lib/FileTransformer.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t k_fileSize = 64 << 20;
+
+class TransformFiles
+{
+public:
+	TransformFiles()
+		: m_directory(std::filesystem::temp_directory_path() / "lab3_file_access_benchmark")
+	{
+		std::filesystem::create_directories(m_directory);
+		std::vector<char> data(k_fileSize);
+		for (size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = static_cast<char>(i * 31 / 7);
+		}
+		std::ofstream(GetInput(), std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	TransformFiles(const TransformFiles&) = delete;
+	TransformFiles& operator=(const TransformFiles&) = delete;
+
+	~TransformFiles()
+	{
+		std::filesystem::remove_all(m_directory);
+	}
+
+	std::string GetInput() const
+	{
+		return (m_directory / "input.bin").string();
+	}
+
+	std::string GetOutput() const
+	{
+		return (m_directory / "output.bin").string();
+	}
+
+private:
+	std::filesystem::path m_directory;
+};
+
+void Transform(std::vector<std::string> arguments)
+{
+	arguments.insert(arguments.begin(), "transform");
+	std::vector<char*> args;
+	for (auto& argument : arguments)
+	{
+		args.push_back(argument.data());
+	}
+	FileTransformer().Transform(static_cast<int>(args.size()), args.data());
+}
+
+// Runs the transformer over a 64 MiB file that stays in the page cache, so
+// the numbers compare the access paths and not the disk. bytes/s counts
+// input bytes.
+void RunTransform(benchmark::State& state, std::vector<std::string> options)
+{
+	TransformFiles files;
+	options.push_back(files.GetInput());
+	options.push_back(files.GetOutput());
+	for (auto _ : state)
+	{
+		Transform(options);
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(k_fileSize));
+}
+
+BENCHMARK_CAPTURE(RunTransform, Copy_Buffered, std::vector<std::string>{})->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(RunTransform, Copy_Mapped, std::vector<std::string>{ "--mmap" })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(RunTransform, Decrypt_Buffered, std::vector<std::string>{ "--decrypt", "3" })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(RunTransform, Decrypt_Mapped, std::vector<std::string>{ "--mmap", "--decrypt", "3" })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(RunTransform, Encrypt_Buffered, std::vector<std::string>{ "--encrypt", "3" })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(RunTransform, Encrypt_Mapped, std::vector<std::string>{ "--mmap", "--encrypt", "3" })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,70 @@
+#include "../src/lib/ByteSubstitution.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+SubstitutionTable MakeTable()
+{
+	SubstitutionTable table;
+	std::iota(table.begin(), table.end(), 0);
+	std::shuffle(table.begin(), table.end(), std::mt19937(42));
+	return table;
+}
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	std::mt19937 random(7);
+	std::generate(data.begin(), data.end(), [&] { return static_cast<uint8_t>(random()); });
+	return data;
+}
+
+// The argument is the block size; bytes/s in the report counts input bytes.
+void RunKernel(benchmark::State& state, ByteSubstitution::Kernel kernel)
+{
+	const auto table = MakeTable();
+	const auto src = MakeData(static_cast<size_t>(state.range(0)));
+	std::vector<uint8_t> dst(src.size());
+	for (auto _ : state)
+	{
+		kernel(table, src.data(), dst.data(), src.size());
+		benchmark::DoNotOptimize(dst.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SubstitutionScalar(benchmark::State& state)
+{
+	RunKernel(state, &ByteSubstitution::ApplyScalar);
+}
+BENCHMARK(BM_SubstitutionScalar)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
+void BM_SubstitutionAvx2(benchmark::State& state)
+{
+#ifdef BYTE_SUBSTITUTION_X86
+	if (ByteSubstitution::IsAvx2Supported())
+	{
+		RunKernel(state, &ByteSubstitution::ApplyAvx2);
+		return;
+	}
+#endif
+	state.SkipWithError("AVX2 is not available");
+}
+BENCHMARK(BM_SubstitutionAvx2)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
+// What the decorators call: the kernel picked at run time.
+void BM_SubstitutionDispatched(benchmark::State& state)
+{
+	RunKernel(state, [](const SubstitutionTable& table, const uint8_t* src, uint8_t* dst, size_t size) {
+		ByteSubstitution::Apply(table, src, dst, size);
+	});
+}
+BENCHMARK(BM_SubstitutionDispatched)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
+} // namespace
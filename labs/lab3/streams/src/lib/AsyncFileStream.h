@@ -0,0 +1,380 @@
+#ifndef ASYNCFILESTREAM_H
+#define ASYNCFILESTREAM_H
+
+#include "InputStream.h"
+#include "OutputStream.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// File streams whose I/O runs on a worker thread, so reading or writing the
+// disk overlaps with the decorators on the caller's thread. io_uring would save
+// the thread, but liburing is not a dependency of this project; a worker
+// issuing plain pread/pwrite gives the same overlap.
+
+// Keeps up to readAhead blocks in flight ahead of the reader. A block holding
+// zero bytes marks the end of the file. A read error stops the worker, and
+// every read after it throws again.
+class AsyncFileInputStream : public IInputStream
+{
+public:
+	static constexpr size_t k_defaultBlockSize = 256 * 1024;
+	static constexpr size_t k_defaultReadAhead = 4;
+
+	AsyncFileInputStream(const std::string& fileName,
+		size_t blockSize = k_defaultBlockSize, size_t readAhead = k_defaultReadAhead)
+		: m_blocks(std::max<size_t>(readAhead, 1))
+	{
+		if (blockSize == 0)
+		{
+			throw std::invalid_argument("Block size must be positive");
+		}
+		m_fd = ::open(fileName.c_str(), O_RDONLY);
+		if (m_fd < 0)
+		{
+			throw std::runtime_error("Failed to open file: " + fileName);
+		}
+		for (auto& block : m_blocks)
+		{
+			block.data.resize(blockSize);
+		}
+		m_worker = std::thread([this] { FetchBlocks(); });
+	}
+
+	AsyncFileInputStream(const AsyncFileInputStream&) = delete;
+	AsyncFileInputStream& operator=(const AsyncFileInputStream&) = delete;
+
+	~AsyncFileInputStream() override
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_changed.notify_all();
+		m_worker.join();
+		::close(m_fd);
+	}
+
+	bool IsEOF() override
+	{
+		return m_position == m_size && !NextBlock();
+	}
+
+	uint8_t ReadByte() override
+	{
+		if (m_position == m_size && !NextBlock())
+		{
+			throw std::runtime_error("ReadByte failed");
+		}
+		return m_data[m_position++];
+	}
+
+	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
+	{
+		auto* dst = static_cast<uint8_t*>(dstBuffer);
+		auto remaining = static_cast<size_t>(size);
+		while (remaining > 0 && (m_position < m_size || NextBlock()))
+		{
+			size_t count = std::min(remaining, m_size - m_position);
+			std::memcpy(dst, m_data + m_position, count);
+			m_position += count;
+			dst += count;
+			remaining -= count;
+		}
+		return size - static_cast<std::streamsize>(remaining);
+	}
+
+private:
+	struct Block
+	{
+		std::vector<uint8_t> data;
+		size_t size = 0;
+		bool isFilled = false;
+		bool hasFailed = false;
+	};
+
+	void FetchBlocks()
+	{
+		off_t offset = 0;
+		for (size_t index = 0;; index = (index + 1) % m_blocks.size())
+		{
+			Block& block = m_blocks[index];
+			{
+				std::unique_lock lock(m_mutex);
+				m_changed.wait(lock, [&] { return m_isStopped || !block.isFilled; });
+				if (m_isStopped)
+				{
+					return;
+				}
+			}
+
+			ssize_t bytesRead;
+			do
+			{
+				bytesRead = ::pread(m_fd, block.data.data(), block.data.size(), offset);
+			} while (bytesRead < 0 && errno == EINTR);
+			{
+				std::lock_guard lock(m_mutex);
+				block.hasFailed = bytesRead < 0;
+				block.size = bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+				block.isFilled = true;
+			}
+			m_changed.notify_all();
+			if (bytesRead <= 0)
+			{
+				return;
+			}
+			offset += bytesRead;
+		}
+	}
+
+	// Hands the current block back to the worker and waits for the next one.
+	// Returns false at the end of the file.
+	bool NextBlock()
+	{
+		if (m_isAtEnd)
+		{
+			return false;
+		}
+		if (m_hasFailed)
+		{
+			throw std::runtime_error("ReadBlock failed");
+		}
+
+		std::unique_lock lock(m_mutex);
+		if (m_data)
+		{
+			m_blocks[m_readIndex].isFilled = false;
+			m_readIndex = (m_readIndex + 1) % m_blocks.size();
+			m_changed.notify_all();
+		}
+
+		Block& block = m_blocks[m_readIndex];
+		m_changed.wait(lock, [&] { return block.isFilled; });
+		if (block.hasFailed)
+		{
+			m_hasFailed = true;
+			throw std::runtime_error("ReadBlock failed");
+		}
+
+		m_data = block.data.data();
+		m_size = block.size;
+		m_position = 0;
+		m_isAtEnd = m_size == 0;
+		return !m_isAtEnd;
+	}
+
+	int m_fd = -1;
+	std::vector<Block> m_blocks;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	bool m_isStopped = false;
+	std::thread m_worker;
+
+	// Reader side; only touched by the thread that reads from the stream.
+	size_t m_readIndex = 0;
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_position = 0;
+	bool m_isAtEnd = false;
+	bool m_hasFailed = false;
+};
+
+// Double-buffered: the caller fills one buffer while the worker writes the
+// other. Write errors surface on the next hand-over or on Close.
+class AsyncFileOutputStream : public IOutputStream
+{
+public:
+	static constexpr size_t k_defaultBlockSize = 256 * 1024;
+
+	AsyncFileOutputStream(const std::string& fileName, size_t blockSize = k_defaultBlockSize)
+	{
+		if (blockSize == 0)
+		{
+			throw std::invalid_argument("Block size must be positive");
+		}
+		m_fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (m_fd < 0)
+		{
+			throw std::runtime_error("Failed to open file: " + fileName);
+		}
+		m_active.resize(blockSize);
+		m_pending.resize(blockSize);
+		m_worker = std::thread([this] { WriteBlocks(); });
+	}
+
+	AsyncFileOutputStream(const AsyncFileOutputStream&) = delete;
+	AsyncFileOutputStream& operator=(const AsyncFileOutputStream&) = delete;
+
+	~AsyncFileOutputStream() override
+	{
+		try
+		{
+			Close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void WriteByte(uint8_t data) override
+	{
+		CheckNotClosed();
+		if (m_size == m_active.size())
+		{
+			Submit();
+		}
+		m_active[m_size++] = data;
+	}
+
+	void WriteBlock(const void* srcData, std::streamsize size) override
+	{
+		CheckNotClosed();
+		auto* src = static_cast<const uint8_t*>(srcData);
+		auto remaining = static_cast<size_t>(size);
+		while (remaining > 0)
+		{
+			if (m_size == m_active.size())
+			{
+				Submit();
+			}
+			size_t count = std::min(remaining, m_active.size() - m_size);
+			std::memcpy(m_active.data() + m_size, src, count);
+			m_size += count;
+			src += count;
+			remaining -= count;
+		}
+	}
+
+	void Close() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		m_isClosed = true;
+
+		bool hasFailed = false;
+		try
+		{
+			if (m_size > 0)
+			{
+				Submit();
+			}
+			WaitForPending();
+		}
+		catch (...)
+		{
+			hasFailed = true;
+		}
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_changed.notify_all();
+		m_worker.join();
+
+		if (::close(m_fd) != 0 || hasFailed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+	}
+
+private:
+	void WriteBlocks()
+	{
+		std::unique_lock lock(m_mutex);
+		while (true)
+		{
+			m_changed.wait(lock, [&] { return m_isStopped || m_pendingSize > 0; });
+			if (m_pendingSize == 0)
+			{
+				return;
+			}
+
+			size_t size = m_pendingSize;
+			lock.unlock();
+			bool isWritten = WriteAll(m_pending.data(), size);
+			lock.lock();
+
+			m_hasFailed = m_hasFailed || !isWritten;
+			m_pendingSize = 0;
+			m_changed.notify_all();
+		}
+	}
+
+	bool WriteAll(const uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			ssize_t written = ::write(m_fd, data, size);
+			if (written < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (written < 0)
+			{
+				return false;
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	// Waits for the worker to finish the previous buffer, then swaps buffers.
+	void Submit()
+	{
+		WaitForPending();
+		{
+			std::lock_guard lock(m_mutex);
+			std::swap(m_active, m_pending);
+			m_pendingSize = m_size;
+		}
+		m_changed.notify_all();
+		m_size = 0;
+	}
+
+	void WaitForPending()
+	{
+		std::unique_lock lock(m_mutex);
+		m_changed.wait(lock, [&] { return m_pendingSize == 0; });
+		if (m_hasFailed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+	}
+
+	void CheckNotClosed() const
+	{
+		if (m_isClosed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+	}
+
+	int m_fd = -1;
+	std::vector<uint8_t> m_active;
+	size_t m_size = 0;
+	bool m_isClosed = false;
+
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::vector<uint8_t> m_pending;
+	size_t m_pendingSize = 0;
+	bool m_hasFailed = false;
+	bool m_isStopped = false;
+	std::thread m_worker;
+};
+
+#endif /* ASYNCFILESTREAM_H */
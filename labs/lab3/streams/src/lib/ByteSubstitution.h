@@ -0,0 +1,118 @@
+#ifndef BYTESUBSTITUTION_H
+#define BYTESUBSTITUTION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BYTE_SUBSTITUTION_X86
+#include <immintrin.h>
+#endif
+
+using SubstitutionTable = std::array<uint8_t, 256>;
+
+class ByteSubstitution
+{
+public:
+	// Kernels read from src and write to dst; the two may be the same buffer.
+	using Kernel = void (*)(const SubstitutionTable&, const uint8_t*, uint8_t*, size_t);
+
+	static void Apply(const SubstitutionTable& table, uint8_t* data, size_t size)
+	{
+		Apply(table, data, data, size);
+	}
+
+	static void Apply(const SubstitutionTable& table, const uint8_t* src, uint8_t* dst, size_t size)
+	{
+		static const Kernel kernel = SelectKernel();
+		kernel(table, src, dst, size);
+	}
+
+	static void ApplyScalar(const SubstitutionTable& table, const uint8_t* src, uint8_t* dst, size_t size)
+	{
+		size_t i = 0;
+		for (; i + 4 <= size; i += 4)
+		{
+			dst[i] = table[src[i]];
+			dst[i + 1] = table[src[i + 1]];
+			dst[i + 2] = table[src[i + 2]];
+			dst[i + 3] = table[src[i + 3]];
+		}
+		for (; i < size; ++i)
+		{
+			dst[i] = table[src[i]];
+		}
+	}
+
+	static bool IsAvx2Supported()
+	{
+#ifdef BYTE_SUBSTITUTION_X86
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+#ifdef BYTE_SUBSTITUTION_X86
+	// The table is split into sixteen 16-byte rows addressed by the low nibble
+	// with pshufb. Row k holds row[k] ^ row[k + 1] within each half of the
+	// table, and a saturating add keeps pshufb lanes enabled only for rows
+	// k >= high nibble, so the XOR over all lookups telescopes to row[high].
+	// A 128-bit variant of this kernel lost to the scalar loop, so there is none.
+	__attribute__((target("avx2"))) static void ApplyAvx2(
+		const SubstitutionTable& table, const uint8_t* src, uint8_t* dst, size_t size)
+	{
+		__m256i rows[16];
+		for (int row = 0; row < 16; ++row)
+		{
+			rows[row] = _mm256_broadcastsi128_si256(LoadTelescopedRow(table, row));
+		}
+
+		const __m256i flip = _mm256_set1_epi8(static_cast<char>(0x80));
+		size_t i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			__m256i lowHalf = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			__m256i highHalf = _mm256_xor_si256(lowHalf, flip);
+
+			__m256i result = _mm256_setzero_si256();
+			for (int row = 0; row < 8; ++row)
+			{
+				__m256i bias = _mm256_set1_epi8(static_cast<char>(0x70 - 16 * row));
+				result = _mm256_xor_si256(result, _mm256_shuffle_epi8(rows[row], _mm256_adds_epu8(lowHalf, bias)));
+				result = _mm256_xor_si256(result, _mm256_shuffle_epi8(rows[row + 8], _mm256_adds_epu8(highHalf, bias)));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), result);
+		}
+		ApplyScalar(table, src + i, dst + i, size - i);
+	}
+#endif
+
+private:
+#ifdef BYTE_SUBSTITUTION_X86
+	static __m128i LoadTelescopedRow(const SubstitutionTable& table, int row)
+	{
+		__m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data() + row * 16));
+		if (row % 8 == 7)
+		{
+			return current;
+		}
+		__m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data() + (row + 1) * 16));
+		return _mm_xor_si128(current, next);
+	}
+#endif
+
+	static Kernel SelectKernel()
+	{
+#ifdef BYTE_SUBSTITUTION_X86
+		if (IsAvx2Supported())
+		{
+			return &ApplyAvx2;
+		}
+#endif
+		return &ApplyScalar;
+	}
+};
+
+#endif /* BYTESUBSTITUTION_H */
@@ -1,10 +1,12 @@
 #ifndef DATAPROCESSOR_H
 #define DATAPROCESSOR_H
+#include "ByteSubstitution.h"
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <memory>
 #include <random>
+#include <span>
 #include <vector>
 
 class IDataProcessor;
@@ -17,100 +19,128 @@ public:
 	virtual ~IDataProcessor() = default;
 	virtual uint8_t ProcessByte(uint8_t data) = 0;
 	virtual std::streamsize ProcessDataBlock(void* buffer, std::streamsize size) = 0;
+
+	// Processes src into dst and returns the number of bytes written. dst must
+	// be at least as large as ProcessDataBlock would need for src in place.
+	virtual std::streamsize TransformBlock(std::span<const uint8_t> src, std::span<uint8_t> dst)
+	{
+		if (src.data() != dst.data())
+		{
+			std::memcpy(dst.data(), src.data(), src.size());
+		}
+		return ProcessDataBlock(dst.data(), static_cast<std::streamsize>(src.size()));
+	}
+
+	// True when each output byte depends only on the input byte at the same
+	// position and processing keeps no state. Any range of such a stream can be
+	// processed on its own, from any thread.
+	virtual bool IsPositionIndependent() const
+	{
+		return false;
+	}
 };
 
-class DecodingDataProcessor : public IDataProcessor
+// Maps every byte through a 256-entry table. Two substitutions applied one
+// after another are again a substitution, which lets decorators merge them.
+class SubstitutionDataProcessor : public IDataProcessor
 {
 private:
-	std::vector<uint8_t> m_decodeTable;
-	int m_key;
+	alignas(64) SubstitutionTable m_table;
 
 public:
-	DecodingDataProcessor(int key)
-		: m_key(key)
+	SubstitutionDataProcessor(const SubstitutionTable& table)
+		: m_table(table)
 	{
-		GenerateDecodeTable();
 	}
 
 	uint8_t ProcessByte(uint8_t data) override
 	{
-		return m_decodeTable[data];
+		return m_table[data];
 	}
 
 	std::streamsize ProcessDataBlock(void* buffer, std::streamsize size) override
 	{
-		uint8_t* data = static_cast<uint8_t*>(buffer);
-		for (std::streamsize i = 0; i < size; ++i)
+		ByteSubstitution::Apply(m_table, static_cast<uint8_t*>(buffer), static_cast<size_t>(size));
+		return size;
+	}
+
+	std::streamsize TransformBlock(std::span<const uint8_t> src, std::span<uint8_t> dst) override
+	{
+		ByteSubstitution::Apply(m_table, src.data(), dst.data(), src.size());
+		return static_cast<std::streamsize>(src.size());
+	}
+
+	bool IsPositionIndependent() const override
+	{
+		return true;
+	}
+
+	const SubstitutionTable& GetTable() const
+	{
+		return m_table;
+	}
+
+	// Returns a processor equivalent to running first and then second.
+	static std::shared_ptr<SubstitutionDataProcessor> Compose(
+		const SubstitutionDataProcessor& first, const SubstitutionDataProcessor& second)
+	{
+		SubstitutionTable table;
+		for (int i = 0; i < 256; ++i)
 		{
-			data[i] = m_decodeTable[data[i]];
+			table[i] = second.m_table[first.m_table[i]];
 		}
-		return size;
+		return std::make_shared<SubstitutionDataProcessor>(table);
 	}
 
-private:
-	void GenerateDecodeTable()
+protected:
+	static SubstitutionTable GenerateEncodeTable(int key)
 	{
-		std::vector<uint8_t> encodeTable(256);
+		SubstitutionTable encodeTable;
 		for (int i = 0; i < 256; ++i)
 		{
 			encodeTable[i] = static_cast<uint8_t>(i);
 		}
 
-		std::mt19937 gen(m_key);
+		std::mt19937 gen(key);
 		std::shuffle(encodeTable.begin(), encodeTable.end(), gen);
+		return encodeTable;
+	}
 
-		m_decodeTable.resize(256);
+	static SubstitutionTable GenerateDecodeTable(int key)
+	{
+		SubstitutionTable encodeTable = GenerateEncodeTable(key);
+		SubstitutionTable decodeTable;
 		for (int i = 0; i < 256; ++i)
 		{
-			m_decodeTable[encodeTable[i]] = static_cast<uint8_t>(i);
+			decodeTable[encodeTable[i]] = static_cast<uint8_t>(i);
 		}
+		return decodeTable;
 	}
 };
 
-class EncodingDataProcessor : public IDataProcessor
+class DecodingDataProcessor : public SubstitutionDataProcessor
 {
-private:
-	std::vector<uint8_t> m_encodeTable;
-	int m_key;
-
 public:
-	EncodingDataProcessor(int key)
-		: m_key(key)
-	{
-		GenerateEncodeTable();
-	}
-
-	uint8_t ProcessByte(uint8_t data) override
-	{
-		return m_encodeTable[data];
-	}
-
-	std::streamsize ProcessDataBlock(void* buffer, std::streamsize size) override
+	DecodingDataProcessor(int key)
+		: SubstitutionDataProcessor(GenerateDecodeTable(key))
 	{
-		uint8_t* data = static_cast<uint8_t*>(buffer);
-		for (std::streamsize i = 0; i < size; ++i)
-		{
-			data[i] = m_encodeTable[data[i]];
-		}
-		return size;
 	}
+};
 
-private:
-	void GenerateEncodeTable()
+class EncodingDataProcessor : public SubstitutionDataProcessor
+{
+public:
+	EncodingDataProcessor(int key)
+		: SubstitutionDataProcessor(GenerateEncodeTable(key))
 	{
-		m_encodeTable.resize(256);
-		for (int i = 0; i < 256; ++i)
-		{
-			m_encodeTable[i] = static_cast<uint8_t>(i);
-		}
-
-		std::mt19937 gen(m_key);
-		std::shuffle(m_encodeTable.begin(), m_encodeTable.end(), gen);
 	}
 };
 
 class PackingDataProcessor : public IDataProcessor
 {
+private:
+	std::vector<uint8_t> m_compressedData;
+
 public:
 	uint8_t ProcessByte(uint8_t data) override
 	{
@@ -125,7 +155,8 @@ public:
 		}
 
 		auto* data = static_cast<uint8_t*>(buffer);
-		std::vector<uint8_t> compressedData;
+		auto& compressedData = m_compressedData;
+		compressedData.clear();
 		compressedData.reserve(static_cast<size_t>(size));
 
 		for (std::streamsize i = 0; i < size;)
@@ -172,6 +203,9 @@ public:
 
 class UnpackingDataProcessor : public IDataProcessor
 {
+private:
+	std::vector<uint8_t> m_decompressedData;
+
 public:
 	uint8_t ProcessByte(uint8_t data) override
 	{
@@ -186,7 +220,8 @@ public:
 		}
 
 		auto* input = static_cast<uint8_t*>(buffer);
-		std::vector<uint8_t> decompressed;
+		auto& decompressed = m_decompressedData;
+		decompressed.clear();
 		decompressed.reserve(static_cast<size_t>(size) * 2);
 
 		std::streamsize i = 0;
@@ -1,8 +1,12 @@
 #ifndef FILETRANSFORMER_H
 #define FILETRANSFORMER_H
 
+#include "lib/AsyncFileStream.h"
 #include "lib/MakeDecorator.h"
+#include "lib/PipelinedTransfer.h"
+#include "lib/RleContainer.h"
 #include "lib/StreamDecorator.h"
+#include <algorithm>
 #include <cstddef>
 #include <string>
 #include <vector>
@@ -14,6 +18,13 @@ public:
 	IOutputStreamPtr m_outputStream;
 };
 
+enum class FileAccess
+{
+	Buffered,
+	Mapped,
+	Async,
+};
+
 class FileTransformer
 {
 public:
@@ -23,9 +34,20 @@ public:
 		auto fileNames = ExtractFileNames(argc, args);
 		auto arguments = ExtractArguments(argc, args);
 
-		StreamsData streams = CreateStreams(fileNames.first, fileNames.second);
-		DecorateStreams(streams, arguments);
-		TransferData(streams);
+		StreamsData streams = CreateStreams(fileNames.first, fileNames.second, SelectFileAccess(arguments));
+		bool usePipeline = std::ranges::find(arguments, k_pipelineArg) != arguments.end();
+		DecorateStreams(streams, arguments, usePipeline);
+		if (usePipeline)
+		{
+			PipelinedTransfer().Run(*streams.m_inputStream, *streams.m_outputStream);
+		}
+		else
+		{
+			TransferData(streams);
+		}
+		// Buffered data, packing trailers and chunk indexes are written here;
+		// the destructors would only try and swallow the errors.
+		streams.m_outputStream->Close();
 	}
 
 private:
@@ -33,6 +55,11 @@ private:
 	const std::string k_decryptArg{ "--decrypt" };
 	const std::string k_compressArg{ "--compress" };
 	const std::string k_decompressArg{ "--decompress" };
+	const std::string k_compressChunkedArg{ "--compress-chunked" };
+	const std::string k_decompressChunkedArg{ "--decompress-chunked" };
+	const std::string k_mmapArg{ "--mmap" };
+	const std::string k_pipelineArg{ "--pipeline" };
+	const std::string k_asyncArg{ "--async" };
 
 	void ValidateArguments(int argc, char* args[]) const
 	{
@@ -75,7 +102,12 @@ private:
 			arg != k_encryptArg
 			&& arg != k_decompressArg
 			&& arg != k_compressArg
-			&& arg != k_decryptArg)
+			&& arg != k_decryptArg
+			&& arg != k_compressChunkedArg
+			&& arg != k_decompressChunkedArg
+			&& arg != k_mmapArg
+			&& arg != k_pipelineArg
+			&& arg != k_asyncArg)
 		{
 
 			throw std::runtime_error("Unknown argument: " + arg);
@@ -110,8 +142,42 @@ private:
 		return arguments;
 	}
 
-	StreamsData CreateStreams(const std::string& inputFileName, const std::string& outputFileName)
+	FileAccess SelectFileAccess(const std::vector<std::string>& arguments) const
+	{
+		bool useMapping = std::ranges::find(arguments, k_mmapArg) != arguments.end();
+		bool useAsync = std::ranges::find(arguments, k_asyncArg) != arguments.end();
+		if (useMapping && useAsync)
+		{
+			throw std::runtime_error(k_mmapArg + " and " + k_asyncArg + " cannot be combined");
+		}
+		if (useMapping)
+		{
+			return FileAccess::Mapped;
+		}
+		return useAsync ? FileAccess::Async : FileAccess::Buffered;
+	}
+
+	StreamsData CreateStreams(const std::string& inputFileName, const std::string& outputFileName, FileAccess access)
 	{
+		if (access == FileAccess::Mapped)
+		{
+			// The output is sized from the input, so a transform that keeps the
+			// size maps it once.
+			auto inputStream = std::make_unique<MappedFileInputStream>(inputFileName);
+			const std::streamsize expectedSize = inputStream->Size();
+			StreamsData streams;
+			streams.m_inputStream = std::move(inputStream);
+			streams.m_outputStream = std::make_unique<MappedFileOutputStream>(outputFileName, expectedSize);
+			return streams;
+		}
+		if (access == FileAccess::Async)
+		{
+			StreamsData streams;
+			streams.m_inputStream = std::make_unique<AsyncFileInputStream>(inputFileName);
+			streams.m_outputStream = std::make_unique<AsyncFileOutputStream>(outputFileName);
+			return streams;
+		}
+
 		auto inputFile = std::make_unique<std::ifstream>(inputFileName, std::ios::binary);
 		auto outputFile = std::make_unique<std::ofstream>(outputFileName, std::ios::binary);
 
@@ -122,11 +188,33 @@ private:
 		return streams;
 	}
 
-	void DecorateStreams(StreamsData& streams, const std::vector<std::string>& args)
+	// With a pipeline every decorator gets a thread of its own: a stage is put
+	// between it and the stream it wraps. Consecutive substitutions are left
+	// together, since they fuse into one table and cost a single pass anyway.
+	void DecorateStreams(StreamsData& streams, const std::vector<std::string>& args, bool usePipeline)
 	{
+		std::string lastInputArg;
+		std::string lastOutputArg;
 		for (size_t i = 0; i < args.size(); ++i)
 		{
 			const std::string& arg = args[i];
+			if (arg == k_encryptArg || arg == k_compressArg || arg == k_compressChunkedArg)
+			{
+				if (usePipeline && !(arg == k_encryptArg && lastOutputArg == k_encryptArg))
+				{
+					streams.m_outputStream = std::make_unique<PipelinedOutputStream>(std::move(streams.m_outputStream));
+				}
+				lastOutputArg = arg;
+			}
+			else if (arg == k_decryptArg || arg == k_decompressArg || arg == k_decompressChunkedArg)
+			{
+				if (usePipeline && !(arg == k_decryptArg && lastInputArg == k_decryptArg))
+				{
+					streams.m_inputStream = std::make_unique<PipelinedInputStream>(std::move(streams.m_inputStream));
+				}
+				lastInputArg = arg;
+			}
+
 			if (arg == k_encryptArg)
 			{
 				int key = std::stoi(args[++i]);
@@ -145,11 +233,31 @@ private:
 			{
 				streams.m_inputStream = std::move(streams.m_inputStream) << MakeDecorator<UnpackingInputStreamDecorator>();
 			}
+			else if (arg == k_compressChunkedArg)
+			{
+				streams.m_outputStream = std::move(streams.m_outputStream) << MakeDecorator<ChunkedPackingOutputStreamDecorator>();
+			}
+			else if (arg == k_decompressChunkedArg)
+			{
+				streams.m_inputStream = std::move(streams.m_inputStream) << MakeDecorator<ChunkedUnpackingInputStreamDecorator>();
+			}
 		}
 	}
 
 	void TransferData(StreamsData& streams)
 	{
+		if (auto* borrowingInput = dynamic_cast<IBorrowingInputStream*>(streams.m_inputStream.get()))
+		{
+			TransferBorrowedData(*streams.m_inputStream, *borrowingInput, *streams.m_outputStream);
+			return;
+		}
+		auto* reservingOutput = dynamic_cast<IReservingOutputStream*>(streams.m_outputStream.get());
+		if (reservingOutput && reservingOutput->CanReserve())
+		{
+			TransferIntoReservedData(*streams.m_inputStream, *reservingOutput);
+			return;
+		}
+
 		std::vector<uint8_t> buffer(4096);
 		while (!streams.m_inputStream->IsEOF())
 		{
@@ -160,5 +268,28 @@ private:
 			}
 		}
 	}
+
+	// An undecorated mapped input hands its pages to the output chain, which
+	// transforms them straight into its destination.
+	void TransferBorrowedData(IInputStream& inputStream, IBorrowingInputStream& borrowingInput, IOutputStream& outputStream)
+	{
+		while (!inputStream.IsEOF())
+		{
+			auto block = borrowingInput.BorrowBlock(k_mappedBlockSize);
+			outputStream.WriteBlock(block.data(), static_cast<std::streamsize>(block.size()));
+		}
+	}
+
+	// A mapped output lets the input chain read straight into the mapping.
+	void TransferIntoReservedData(IInputStream& inputStream, IReservingOutputStream& reservingOutput)
+	{
+		while (!inputStream.IsEOF())
+		{
+			auto block = reservingOutput.Reserve(k_mappedBlockSize);
+			reservingOutput.Commit(inputStream.ReadBlock(block.data(), static_cast<std::streamsize>(block.size())));
+		}
+	}
+
+	static constexpr std::streamsize k_mappedBlockSize = 1 << 20;
 };
 #endif /* FILETRANSFORMER_H */
@@ -1,11 +1,20 @@
 #ifndef INPUTSTREAM_H
 #define INPUTSTREAM_H
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 class IInputStream
 {
@@ -16,36 +25,141 @@ public:
 	virtual std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) = 0;
 };
 
-class FileInputStream : public IInputStream
+// A stream with a known size and random access. Seek moves the position used by
+// ReadByte and ReadBlock. ReadAt leaves it alone and may be called from several
+// threads at once.
+class ISeekableInputStream : public IInputStream
+{
+public:
+	virtual std::streamsize Size() = 0;
+	virtual void Seek(std::streamsize position) = 0;
+	virtual std::streamsize ReadAt(std::streamsize offset, std::span<uint8_t> buffer) = 0;
+
+	// Wrappers implement this interface unconditionally and report here whether
+	// the stream they wrap actually supports it.
+	virtual bool IsSeekable() const
+	{
+		return true;
+	}
+};
+
+// A stream that can lend its own memory instead of copying into the caller's
+// buffer. A borrowed block is read-only and stays valid while the stream lives.
+class IBorrowingInputStream
+{
+public:
+	virtual ~IBorrowingInputStream() = default;
+	virtual std::span<const uint8_t> BorrowBlock(std::streamsize size) = 0;
+};
+
+inline void CheckSeekPosition(std::streamsize position, std::streamsize size)
+{
+	if (position < 0 || position > size)
+	{
+		throw std::runtime_error("Seek position is out of range");
+	}
+}
+
+inline std::streamsize CopyRange(
+	const uint8_t* data, std::streamsize size, std::streamsize offset, std::span<uint8_t> buffer)
+{
+	if (offset < 0 || offset >= size)
+	{
+		return 0;
+	}
+	auto count = static_cast<size_t>(std::min<std::streamsize>(
+		static_cast<std::streamsize>(buffer.size()), size - offset));
+	std::memcpy(buffer.data(), data + offset, count);
+	return static_cast<std::streamsize>(count);
+}
+
+// Reads the file through an inline window, so ReadByte and IsEOF touch the
+// ifstream only once per window instead of once per byte. An ifstream has a
+// single file position, so ReadAt calls are serialized by a mutex.
+class FileInputStream : public ISeekableInputStream
 {
 public:
 	FileInputStream(std::unique_ptr<std::ifstream> file)
 		: m_file(std::move(file))
 	{
+		m_bufferOffset = std::max<std::streamsize>(m_file->tellg(), 0);
+		if (m_file->seekg(0, std::ios::end))
+		{
+			m_fileSize = m_file->tellg();
+			m_file->seekg(m_bufferOffset);
+		}
+		m_file->clear();
+	}
+
+	std::streamsize Size() override
+	{
+		return m_fileSize;
+	}
+
+	void Seek(std::streamsize position) override
+	{
+		CheckSeekPosition(position, m_fileSize);
+		std::lock_guard lock(m_mutex);
+		m_file->clear();
+		m_file->seekg(position);
+		m_bufferOffset = position;
+		m_position = 0;
+		m_size = 0;
+	}
+
+	std::streamsize ReadAt(std::streamsize offset, std::span<uint8_t> buffer) override
+	{
+		std::lock_guard lock(m_mutex);
+		m_file->clear();
+		m_file->seekg(offset);
+		m_file->read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		std::streamsize bytesRead = m_file->gcount();
+		// The sequential position is right after the window, so it is restored
+		// without asking the ifstream where it was.
+		m_file->clear();
+		m_file->seekg(m_bufferOffset + static_cast<std::streamsize>(m_size));
+		return bytesRead;
 	}
 
 	bool IsEOF() override
 	{
-		return m_file->peek() == EOF;
+		return m_position == m_size && !FillBuffer();
 	}
 
 	uint8_t ReadByte() override
 	{
-		char byte;
-		if (!m_file->get(byte))
+		if (m_position == m_size && !FillBuffer())
 		{
 			throw std::runtime_error("ReadByte failed");
 		}
-		return static_cast<uint8_t>(byte);
+		return m_buffer[m_position++];
 	}
 
 	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
 	{
-		if (!m_file->read(static_cast<char*>(dstBuffer), size))
+		auto* dst = static_cast<char*>(dstBuffer);
+		std::streamsize bytesRead = TakeFromBuffer(dst, size);
+		if (bytesRead == size)
+		{
+			return size;
+		}
+
+		// Large reads bypass the window instead of copying through it.
+		if (size - bytesRead >= static_cast<std::streamsize>(m_buffer.size()))
 		{
-			return m_file->gcount();
+			std::lock_guard lock(m_mutex);
+			m_file->read(dst + bytesRead, size - bytesRead);
+			std::streamsize directRead = m_file->gcount();
+			m_bufferOffset += static_cast<std::streamsize>(m_size) + directRead;
+			m_position = 0;
+			m_size = 0;
+			return bytesRead + directRead;
 		}
-		return size;
+		if (FillBuffer())
+		{
+			bytesRead += TakeFromBuffer(dst + bytesRead, size - bytesRead);
+		}
+		return bytesRead;
 	}
 
 	void Close()
@@ -57,10 +171,37 @@ public:
 	}
 
 private:
+	static constexpr size_t k_bufferSize = 16 * 1024;
+
+	bool FillBuffer()
+	{
+		std::lock_guard lock(m_mutex);
+		m_bufferOffset += static_cast<std::streamsize>(m_size);
+		m_file->read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+		m_size = static_cast<size_t>(m_file->gcount());
+		m_position = 0;
+		return m_size > 0;
+	}
+
+	std::streamsize TakeFromBuffer(char* dst, std::streamsize size)
+	{
+		size_t count = std::min(static_cast<size_t>(size), m_size - m_position);
+		std::memcpy(dst, m_buffer.data() + m_position, count);
+		m_position += count;
+		return static_cast<std::streamsize>(count);
+	}
+
 	std::unique_ptr<std::ifstream> m_file;
+	std::mutex m_mutex;
+	std::streamsize m_fileSize = 0;
+	// File offset of m_buffer[0].
+	std::streamsize m_bufferOffset = 0;
+	std::array<uint8_t, k_bufferSize> m_buffer;
+	size_t m_position = 0;
+	size_t m_size = 0;
 };
 
-class MemoryInputStream : public IInputStream
+class MemoryInputStream : public ISeekableInputStream
 {
 public:
 	MemoryInputStream(const uint8_t* data, std::streamsize size)
@@ -97,10 +238,144 @@ public:
 		return bytesToRead;
 	}
 
+	std::streamsize Size() override
+	{
+		return m_size;
+	}
+
+	void Seek(std::streamsize position) override
+	{
+		CheckSeekPosition(position, m_size);
+		m_position = position;
+	}
+
+	std::streamsize ReadAt(std::streamsize offset, std::span<uint8_t> buffer) override
+	{
+		return CopyRange(m_data, m_size, offset, buffer);
+	}
+
 private:
 	const uint8_t* m_data;
 	std::streamsize m_size;
 	std::streamsize m_position;
 };
 
+class MappedFileInputStream
+	: public ISeekableInputStream
+	, public IBorrowingInputStream
+{
+public:
+	MappedFileInputStream(const std::string& fileName)
+	{
+		m_fd = ::open(fileName.c_str(), O_RDONLY);
+		if (m_fd == -1)
+		{
+			throw std::runtime_error("Failed to open " + fileName);
+		}
+
+		struct stat info{};
+		if (::fstat(m_fd, &info) == -1)
+		{
+			Close();
+			throw std::runtime_error("Failed to stat " + fileName);
+		}
+		m_size = info.st_size;
+
+		if (m_size > 0)
+		{
+			// Read-only, so borrowed pages are never copied on write; readers
+			// transform them straight into their destination instead.
+			void* data = ::mmap(nullptr, static_cast<size_t>(m_size),
+				PROT_READ, MAP_PRIVATE, m_fd, 0);
+			if (data == MAP_FAILED)
+			{
+				Close();
+				throw std::runtime_error("Failed to map " + fileName);
+			}
+			m_data = static_cast<const uint8_t*>(data);
+			::madvise(const_cast<uint8_t*>(m_data), static_cast<size_t>(m_size), MADV_SEQUENTIAL);
+		}
+	}
+
+	MappedFileInputStream(const MappedFileInputStream&) = delete;
+	MappedFileInputStream& operator=(const MappedFileInputStream&) = delete;
+
+	~MappedFileInputStream() override
+	{
+		Close();
+	}
+
+	bool IsEOF() override
+	{
+		return m_position >= m_size;
+	}
+
+	uint8_t ReadByte() override
+	{
+		if (m_position >= m_size)
+		{
+			throw std::runtime_error("ReadByte failed");
+		}
+		return m_data[m_position++];
+	}
+
+	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
+	{
+		auto block = BorrowBlock(size);
+		std::memcpy(dstBuffer, block.data(), block.size());
+		return static_cast<std::streamsize>(block.size());
+	}
+
+	std::streamsize Size() override
+	{
+		return m_size;
+	}
+
+	void Seek(std::streamsize position) override
+	{
+		CheckSeekPosition(position, m_size);
+		m_position = position;
+	}
+
+	std::streamsize ReadAt(std::streamsize offset, std::span<uint8_t> buffer) override
+	{
+		return CopyRange(m_data, m_size, offset, buffer);
+	}
+
+	std::span<const uint8_t> BorrowBlock(std::streamsize size) override
+	{
+		if (m_position >= m_size)
+		{
+			return {};
+		}
+
+		std::streamsize bytesToBorrow = std::min(size, m_size - m_position);
+		std::span<const uint8_t> block(m_data + m_position, static_cast<size_t>(bytesToBorrow));
+		m_position += bytesToBorrow;
+		return block;
+	}
+
+	void Close()
+	{
+		if (m_data)
+		{
+			::munmap(const_cast<uint8_t*>(m_data), static_cast<size_t>(m_size));
+			m_data = nullptr;
+		}
+		if (m_fd != -1)
+		{
+			::close(m_fd);
+			m_fd = -1;
+		}
+		m_size = 0;
+		m_position = 0;
+	}
+
+private:
+	int m_fd = -1;
+	const uint8_t* m_data = nullptr;
+	std::streamsize m_size = 0;
+	std::streamsize m_position = 0;
+};
+
 #endif /* INPUTSTREAM_H */
@@ -1,6 +1,7 @@
 #ifndef MAKEDECORATOR_H
 #define MAKEDECORATOR_H
 
+#include <concepts>
 #include <memory>
 #include <utility>
 
@@ -14,7 +15,8 @@ auto MakeDecorator(const Args&... args)
 }
 
 template <typename Component, typename Decorator>
-auto operator<<(Component&& component, const Decorator& decorate)
+	requires std::invocable<const Decorator&, Component&&>
+decltype(auto) operator<<(Component&& component, const Decorator& decorate)
 {
 	return decorate(std::forward<Component>(component));
 }
@@ -1,11 +1,18 @@
 #ifndef OUTPUTSTREAM_H
 #define OUTPUTSTREAM_H
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <memory>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <vector>
 
 class IOutputStream
@@ -17,11 +24,35 @@ public:
 	virtual void Close() = 0;
 };
 
+// A stream that lets the caller produce data straight into its own memory.
+// Reserve returns a writable block of at least one and at most size bytes,
+// and Commit appends the first count bytes of the last reserved block to the
+// stream. Like IsSeekable, CanReserve lets wrappers report whether the stream
+// they wrap supports this.
+class IReservingOutputStream
+{
+public:
+	virtual ~IReservingOutputStream() = default;
+	virtual std::span<uint8_t> Reserve(std::streamsize size) = 0;
+	virtual void Commit(std::streamsize count) = 0;
+
+	virtual bool CanReserve() const
+	{
+		return true;
+	}
+};
+
+// Collects writes in an inline window and hands them to the ofstream in
+// large pieces. Close flushes the window; so does the destructor, best effort.
 class FileOutputStream : public IOutputStream
 {
 private:
+	static constexpr size_t k_bufferSize = 16 * 1024;
+
 	std::unique_ptr<std::ofstream> m_file;
 	bool m_isClosed;
+	std::array<uint8_t, k_bufferSize> m_buffer;
+	size_t m_size = 0;
 
 public:
 	FileOutputStream(std::unique_ptr<std::ofstream> file)
@@ -30,30 +61,82 @@ public:
 	{
 	}
 
+	FileOutputStream(const FileOutputStream&) = delete;
+	FileOutputStream& operator=(const FileOutputStream&) = delete;
+
+	~FileOutputStream() override
+	{
+		try
+		{
+			if (!m_isClosed)
+			{
+				Flush();
+			}
+		}
+		catch (...)
+		{
+		}
+	}
+
 	void WriteByte(uint8_t data) override
 	{
 		CheckFileNotClosed();
-		m_file->put(static_cast<char>(data));
-		CheckWriteGood();
+		if (m_size == m_buffer.size())
+		{
+			Flush();
+		}
+		m_buffer[m_size++] = data;
 	}
 
 	void WriteBlock(const void* srcData, std::streamsize size) override
 	{
 		CheckFileNotClosed();
+		auto count = static_cast<size_t>(size);
+		if (count <= m_buffer.size() - m_size)
+		{
+			std::memcpy(m_buffer.data() + m_size, srcData, count);
+			m_size += count;
+			return;
+		}
+
+		Flush();
+		if (count < m_buffer.size())
+		{
+			std::memcpy(m_buffer.data(), srcData, count);
+			m_size = count;
+			return;
+		}
 		m_file->write(static_cast<const char*>(srcData), size);
 		CheckWriteGood();
 	}
 
 	void Close() override
 	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		m_isClosed = true;
 		if (m_file)
 		{
+			Flush();
 			m_file->close();
+			CheckWriteGood();
 		}
-		m_isClosed = true;
 	}
 
 private:
+	void Flush()
+	{
+		if (m_size == 0)
+		{
+			return;
+		}
+		m_file->write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_size));
+		m_size = 0;
+		CheckWriteGood();
+	}
+
 	void CheckFileNotClosed()
 	{
 		if (m_isClosed)
@@ -115,4 +198,154 @@ private:
 		}
 	}
 };
+
+// Writes go straight into a shared mapping of the file. Given the expected
+// size, the file is sized and mapped once up front; past it the mapping grows
+// by doubling. Close trims the file to the data written.
+class MappedFileOutputStream
+	: public IOutputStream
+	, public IReservingOutputStream
+{
+private:
+	static constexpr std::streamsize k_minCapacity = 1 << 20;
+
+	int m_fd = -1;
+	uint8_t* m_data = nullptr;
+	std::streamsize m_size = 0;
+	std::streamsize m_capacity = 0;
+	bool m_isClosed = false;
+
+public:
+	MappedFileOutputStream(const std::string& fileName, std::streamsize expectedSize = 0)
+	{
+		m_fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (m_fd == -1)
+		{
+			throw std::runtime_error("Failed to open " + fileName);
+		}
+		if (expectedSize > 0)
+		{
+			try
+			{
+				Map(expectedSize);
+			}
+			catch (...)
+			{
+				::close(m_fd);
+				throw;
+			}
+		}
+	}
+
+	MappedFileOutputStream(const MappedFileOutputStream&) = delete;
+	MappedFileOutputStream& operator=(const MappedFileOutputStream&) = delete;
+
+	~MappedFileOutputStream() override
+	{
+		try
+		{
+			Close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void WriteByte(uint8_t data) override
+	{
+		Reserve(1)[0] = data;
+		Commit(1);
+	}
+
+	void WriteBlock(const void* srcData, std::streamsize size) override
+	{
+		if (size <= 0)
+		{
+			CheckFileNotClosed();
+			return;
+		}
+		auto* src = static_cast<const uint8_t*>(srcData);
+		while (size > 0)
+		{
+			auto block = Reserve(size);
+			std::memcpy(block.data(), src, block.size());
+			Commit(static_cast<std::streamsize>(block.size()));
+			src += block.size();
+			size -= static_cast<std::streamsize>(block.size());
+		}
+	}
+
+	// Hands out what is left of the mapping and grows it only when it is full,
+	// so writes that stay within the expected size never remap.
+	std::span<uint8_t> Reserve(std::streamsize size) override
+	{
+		CheckFileNotClosed();
+		if (m_size == m_capacity)
+		{
+			Map(std::max({ m_size + size, m_capacity * 2, k_minCapacity }));
+		}
+		return std::span<uint8_t>(m_data + m_size, static_cast<size_t>(std::min(size, m_capacity - m_size)));
+	}
+
+	void Commit(std::streamsize count) override
+	{
+		m_size += count;
+	}
+
+	void Close() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		m_isClosed = true;
+
+		Unmap();
+		bool truncated = ::ftruncate(m_fd, m_size) == 0;
+		::close(m_fd);
+		m_fd = -1;
+
+		if (!truncated)
+		{
+			throw std::runtime_error("Write failed");
+		}
+	}
+
+private:
+	void Map(std::streamsize capacity)
+	{
+		Unmap();
+		if (::ftruncate(m_fd, capacity) == -1)
+		{
+			throw std::runtime_error("Write failed");
+		}
+
+		void* data = ::mmap(nullptr, static_cast<size_t>(capacity),
+			PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+		if (data == MAP_FAILED)
+		{
+			throw std::runtime_error("Write failed");
+		}
+		m_data = static_cast<uint8_t*>(data);
+		m_capacity = capacity;
+	}
+
+	void Unmap()
+	{
+		if (m_data)
+		{
+			::munmap(m_data, static_cast<size_t>(m_capacity));
+			m_data = nullptr;
+			m_capacity = 0;
+		}
+	}
+
+	void CheckFileNotClosed()
+	{
+		if (m_isClosed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+	}
+};
 #endif /* OUTPUTSTREAM_H */
@@ -0,0 +1,418 @@
+#ifndef PIPELINEDTRANSFER_H
+#define PIPELINEDTRANSFER_H
+
+#include "InputStream.h"
+#include "OutputStream.h"
+#include "SpscQueue.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// A fixed pool of blocks shared by one producer thread and one consumer
+// thread: filled blocks go to the consumer, consumed blocks go back to the
+// producer, and the producer sleeps while all blocks are in flight. Cancel
+// wakes both sides and makes every later call fail.
+class BlockChannel
+{
+public:
+	static constexpr size_t k_blockSize = 64 * 1024;
+	static constexpr size_t k_blockCount = 8;
+	static constexpr size_t k_endOfStream = k_blockCount;
+
+	struct Block
+	{
+		std::array<uint8_t, k_blockSize> data;
+		std::streamsize size = 0;
+	};
+
+	BlockChannel()
+		: m_blocks(k_blockCount)
+	{
+		for (size_t i = 0; i < k_blockCount; ++i)
+		{
+			m_free.TryPush(i);
+		}
+	}
+
+	Block& operator[](size_t index)
+	{
+		return m_blocks[index];
+	}
+
+	bool AcquireFree(size_t& index)
+	{
+		return m_free.Pop(index);
+	}
+
+	bool SendFilled(size_t index)
+	{
+		return m_filled.Push(index);
+	}
+
+	// Yields k_endOfStream once the producer has called SendEnd.
+	bool ReceiveFilled(size_t& index)
+	{
+		return m_filled.Pop(index);
+	}
+
+	bool ReleaseFree(size_t index)
+	{
+		return m_free.Push(index);
+	}
+
+	bool SendEnd()
+	{
+		return m_filled.Push(k_endOfStream);
+	}
+
+	void Cancel()
+	{
+		m_free.Close();
+		m_filled.Close();
+	}
+
+private:
+	using BlockQueue = SpscQueue<size_t, k_blockCount * 2>;
+
+	std::vector<Block> m_blocks;
+	BlockQueue m_free;
+	BlockQueue m_filled;
+};
+
+// Runs the input chain on a reader thread and the output chain on the calling
+// thread. Stacking PipelinedInputStream and PipelinedOutputStream between
+// decorators splits the chains further, one thread per stage.
+class PipelinedTransfer
+{
+public:
+	void Run(IInputStream& input, IOutputStream& output)
+	{
+		std::exception_ptr readerError;
+		std::thread reader([&] {
+			try
+			{
+				ReadBlocks(input);
+			}
+			catch (...)
+			{
+				readerError = std::current_exception();
+				m_channel.SendEnd();
+			}
+		});
+
+		try
+		{
+			WriteBlocks(output);
+		}
+		catch (...)
+		{
+			m_channel.Cancel();
+			reader.join();
+			throw;
+		}
+
+		reader.join();
+		if (readerError)
+		{
+			std::rethrow_exception(readerError);
+		}
+	}
+
+private:
+	void ReadBlocks(IInputStream& input)
+	{
+		size_t index;
+		while (!input.IsEOF() && m_channel.AcquireFree(index))
+		{
+			auto& block = m_channel[index];
+			block.size = input.ReadBlock(block.data.data(), block.data.size());
+			m_channel.SendFilled(index);
+		}
+		m_channel.SendEnd();
+	}
+
+	void WriteBlocks(IOutputStream& output)
+	{
+		size_t index;
+		while (m_channel.ReceiveFilled(index) && index != BlockChannel::k_endOfStream)
+		{
+			auto& block = m_channel[index];
+			if (block.size > 0)
+			{
+				output.WriteBlock(block.data.data(), block.size);
+			}
+			m_channel.ReleaseFree(index);
+		}
+	}
+
+	BlockChannel m_channel;
+};
+
+// Moves the wrapped output stream to its own thread. Writes are gathered into
+// blocks that the worker hands on, so the caller only waits when all blocks
+// are in flight. A worker error surfaces on a later write or on Close.
+class PipelinedOutputStream : public IOutputStream
+{
+public:
+	explicit PipelinedOutputStream(std::unique_ptr<IOutputStream> outputStream)
+		: m_outputStream(std::move(outputStream))
+	{
+		m_worker = std::thread([this] { WriteBlocks(); });
+	}
+
+	PipelinedOutputStream(const PipelinedOutputStream&) = delete;
+	PipelinedOutputStream& operator=(const PipelinedOutputStream&) = delete;
+
+	~PipelinedOutputStream() override
+	{
+		try
+		{
+			Close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void WriteByte(uint8_t data) override
+	{
+		WriteBlock(&data, 1);
+	}
+
+	void WriteBlock(const void* srcData, std::streamsize size) override
+	{
+		CheckNotClosed();
+		auto* src = static_cast<const uint8_t*>(srcData);
+		auto remaining = static_cast<size_t>(size);
+		while (remaining > 0)
+		{
+			auto& block = CurrentBlock();
+			size_t count = std::min(remaining, block.data.size() - static_cast<size_t>(block.size));
+			std::memcpy(block.data.data() + block.size, src, count);
+			block.size += static_cast<std::streamsize>(count);
+			src += count;
+			remaining -= count;
+			if (static_cast<size_t>(block.size) == block.data.size())
+			{
+				Submit();
+			}
+		}
+	}
+
+	void Close() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		m_isClosed = true;
+		// A failed hand-over means the worker has stopped with an error, which
+		// is rethrown after the join.
+		if (m_current != BlockChannel::k_endOfStream)
+		{
+			m_channel.SendFilled(m_current);
+			m_current = BlockChannel::k_endOfStream;
+		}
+		m_channel.SendEnd();
+		m_worker.join();
+		if (m_workerError)
+		{
+			std::rethrow_exception(m_workerError);
+		}
+		m_outputStream->Close();
+	}
+
+private:
+	BlockChannel::Block& CurrentBlock()
+	{
+		if (m_current == BlockChannel::k_endOfStream)
+		{
+			if (!m_channel.AcquireFree(m_current))
+			{
+				m_current = BlockChannel::k_endOfStream;
+				RethrowWorkerError();
+			}
+			m_channel[m_current].size = 0;
+		}
+		return m_channel[m_current];
+	}
+
+	void Submit()
+	{
+		if (!m_channel.SendFilled(m_current))
+		{
+			RethrowWorkerError();
+		}
+		m_current = BlockChannel::k_endOfStream;
+	}
+
+	void WriteBlocks()
+	{
+		try
+		{
+			size_t index;
+			while (m_channel.ReceiveFilled(index) && index != BlockChannel::k_endOfStream)
+			{
+				auto& block = m_channel[index];
+				m_outputStream->WriteBlock(block.data.data(), block.size);
+				m_channel.ReleaseFree(index);
+			}
+		}
+		catch (...)
+		{
+			m_workerError = std::current_exception();
+			m_channel.Cancel();
+		}
+	}
+
+	// The channel is cancelled only by the worker, after it has stored the
+	// error, so a failed hand-over always finds it.
+	void RethrowWorkerError()
+	{
+		if (m_workerError)
+		{
+			std::rethrow_exception(m_workerError);
+		}
+		throw std::runtime_error("Write failed");
+	}
+
+	void CheckNotClosed() const
+	{
+		if (m_isClosed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+	}
+
+	std::unique_ptr<IOutputStream> m_outputStream;
+	BlockChannel m_channel;
+	size_t m_current = BlockChannel::k_endOfStream;
+	bool m_isClosed = false;
+	std::exception_ptr m_workerError;
+	std::thread m_worker;
+};
+
+// Moves reading from the wrapped input stream to its own thread, which keeps
+// up to a pool of blocks read ahead. A worker error is rethrown by the read
+// that reaches it.
+class PipelinedInputStream : public IInputStream
+{
+public:
+	explicit PipelinedInputStream(std::unique_ptr<IInputStream> inputStream)
+		: m_inputStream(std::move(inputStream))
+	{
+		m_worker = std::thread([this] { ReadBlocks(); });
+	}
+
+	PipelinedInputStream(const PipelinedInputStream&) = delete;
+	PipelinedInputStream& operator=(const PipelinedInputStream&) = delete;
+
+	~PipelinedInputStream() override
+	{
+		m_channel.Cancel();
+		m_worker.join();
+	}
+
+	bool IsEOF() override
+	{
+		return m_position == m_size && !NextBlock();
+	}
+
+	uint8_t ReadByte() override
+	{
+		if (m_position == m_size && !NextBlock())
+		{
+			throw std::runtime_error("ReadByte failed");
+		}
+		return m_channel[m_current].data[m_position++];
+	}
+
+	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
+	{
+		auto* dst = static_cast<uint8_t*>(dstBuffer);
+		auto remaining = static_cast<size_t>(size);
+		while (remaining > 0 && (m_position < m_size || NextBlock()))
+		{
+			size_t count = std::min(remaining, m_size - m_position);
+			std::memcpy(dst, m_channel[m_current].data.data() + m_position, count);
+			m_position += count;
+			dst += count;
+			remaining -= count;
+		}
+		return size - static_cast<std::streamsize>(remaining);
+	}
+
+private:
+	void ReadBlocks()
+	{
+		try
+		{
+			size_t index;
+			while (!m_inputStream->IsEOF() && m_channel.AcquireFree(index))
+			{
+				auto& block = m_channel[index];
+				block.size = m_inputStream->ReadBlock(block.data.data(), block.data.size());
+				m_channel.SendFilled(index);
+			}
+		}
+		catch (...)
+		{
+			m_workerError = std::current_exception();
+		}
+		m_channel.SendEnd();
+	}
+
+	// Returns the current block to the worker and takes the next one. Returns
+	// false at the end of the stream.
+	bool NextBlock()
+	{
+		if (m_isAtEnd)
+		{
+			return false;
+		}
+		if (m_current != BlockChannel::k_endOfStream)
+		{
+			m_channel.ReleaseFree(m_current);
+			m_current = BlockChannel::k_endOfStream;
+		}
+		m_position = 0;
+		m_size = 0;
+		while (m_size == 0)
+		{
+			if (!m_channel.ReceiveFilled(m_current) || m_current == BlockChannel::k_endOfStream)
+			{
+				m_current = BlockChannel::k_endOfStream;
+				m_isAtEnd = true;
+				if (m_workerError)
+				{
+					std::rethrow_exception(m_workerError);
+				}
+				return false;
+			}
+			m_size = static_cast<size_t>(m_channel[m_current].size);
+			if (m_size == 0)
+			{
+				m_channel.ReleaseFree(m_current);
+			}
+		}
+		return true;
+	}
+
+	std::unique_ptr<IInputStream> m_inputStream;
+	BlockChannel m_channel;
+	std::exception_ptr m_workerError;
+	std::thread m_worker;
+
+	// Reader side; only touched by the thread that reads from the stream.
+	size_t m_current = BlockChannel::k_endOfStream;
+	size_t m_position = 0;
+	size_t m_size = 0;
+	bool m_isAtEnd = false;
+};
+
+#endif /* PIPELINEDTRANSFER_H */
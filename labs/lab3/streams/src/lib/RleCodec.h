@@ -0,0 +1,202 @@
+#ifndef RLECODEC_H
+#define RLECODEC_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// Streaming form of the format used by PackingDataProcessor: a run is stored
+// either as literal bytes or as the triple 0xFF, value, count. 0xFF is always
+// escaped, so encoded data never needs a raw/compressed flag. Neither class
+// allocates; callers pass bounded spans that are advanced past the bytes that
+// were consumed or produced.
+class RleEncoder
+{
+public:
+	void Encode(std::span<const uint8_t>& input, std::span<uint8_t>& output)
+	{
+		while (DrainPending(output) && !input.empty())
+		{
+			if (m_runLength == 0)
+			{
+				m_runValue = input.front();
+			}
+
+			size_t limit = std::min(input.size(), k_maxRun - m_runLength);
+			size_t count = 0;
+			while (count < limit && input[count] == m_runValue)
+			{
+				++count;
+			}
+			m_runLength += count;
+			input = input.subspan(count);
+
+			if (!input.empty() || m_runLength == k_maxRun)
+			{
+				QueueRun(output);
+			}
+		}
+	}
+
+	// Emits the run still held in the encoder. Returns false while the output is
+	// too small to take everything, in which case it must be called again.
+	bool Finish(std::span<uint8_t>& output)
+	{
+		if (!DrainPending(output))
+		{
+			return false;
+		}
+		if (m_runLength > 0)
+		{
+			QueueRun(output);
+		}
+		return DrainPending(output);
+	}
+
+private:
+	static constexpr size_t k_maxRun = 255;
+	static constexpr uint8_t k_marker = 0xFF;
+
+	void QueueRun(std::span<uint8_t>& output)
+	{
+		if (m_runLength > 3 || m_runValue == k_marker)
+		{
+			m_pending = { k_marker, m_runValue, static_cast<uint8_t>(m_runLength) };
+			m_pendingSize = 3;
+		}
+		else
+		{
+			m_pending = { m_runValue, m_runValue, m_runValue };
+			m_pendingSize = m_runLength;
+		}
+		m_pendingPosition = 0;
+		m_runLength = 0;
+		DrainPending(output);
+	}
+
+	bool DrainPending(std::span<uint8_t>& output)
+	{
+		size_t count = std::min(m_pendingSize - m_pendingPosition, output.size());
+		std::memcpy(output.data(), m_pending.data() + m_pendingPosition, count);
+		output = output.subspan(count);
+		m_pendingPosition += count;
+		return m_pendingPosition == m_pendingSize;
+	}
+
+	uint8_t m_runValue = 0;
+	size_t m_runLength = 0;
+	std::array<uint8_t, 3> m_pending{};
+	size_t m_pendingSize = 0;
+	size_t m_pendingPosition = 0;
+};
+
+class RleDecoder
+{
+public:
+	void Decode(std::span<const uint8_t>& input, std::span<uint8_t>& output)
+	{
+		while (!output.empty())
+		{
+			if (m_tailPosition < m_tailSize)
+			{
+				output.front() = m_tail[m_tailPosition++];
+				output = output.subspan(1);
+				continue;
+			}
+			if (m_repeatCount > 0)
+			{
+				size_t count = std::min(m_repeatCount, output.size());
+				std::memset(output.data(), m_value, count);
+				output = output.subspan(count);
+				m_repeatCount -= count;
+				continue;
+			}
+			if (input.empty())
+			{
+				return;
+			}
+
+			switch (m_state)
+			{
+			case State::Literal:
+				CopyLiterals(input, output);
+				break;
+			case State::Value:
+				m_value = input.front();
+				input = input.subspan(1);
+				m_state = State::Count;
+				break;
+			case State::Count:
+				m_repeatCount = input.front();
+				input = input.subspan(1);
+				m_state = State::Literal;
+				break;
+			}
+		}
+	}
+
+	// Called once the input is exhausted. A marker cut short by the end of the
+	// stream is passed through as literal bytes, like UnpackingDataProcessor does.
+	void Finish(std::span<uint8_t>& output)
+	{
+		if (m_state == State::Value)
+		{
+			m_tail = { k_marker };
+			m_tailSize = 1;
+			m_tailPosition = 0;
+		}
+		else if (m_state == State::Count)
+		{
+			m_tail = { k_marker, m_value };
+			m_tailSize = 2;
+			m_tailPosition = 0;
+		}
+		m_state = State::Literal;
+
+		std::span<const uint8_t> noInput;
+		Decode(noInput, output);
+	}
+
+	bool HasPendingOutput() const
+	{
+		return m_repeatCount > 0 || m_state != State::Literal || m_tailPosition < m_tailSize;
+	}
+
+private:
+	enum class State
+	{
+		Literal,
+		Value,
+		Count,
+	};
+
+	static constexpr uint8_t k_marker = 0xFF;
+
+	void CopyLiterals(std::span<const uint8_t>& input, std::span<uint8_t>& output)
+	{
+		size_t limit = std::min(input.size(), output.size());
+		auto* marker = static_cast<const uint8_t*>(std::memchr(input.data(), k_marker, limit));
+		size_t count = marker ? static_cast<size_t>(marker - input.data()) : limit;
+
+		std::memcpy(output.data(), input.data(), count);
+		output = output.subspan(count);
+		input = input.subspan(count);
+
+		if (marker)
+		{
+			input = input.subspan(1);
+			m_state = State::Value;
+		}
+	}
+
+	State m_state = State::Literal;
+	uint8_t m_value = 0;
+	size_t m_repeatCount = 0;
+	std::array<uint8_t, 2> m_tail{};
+	size_t m_tailSize = 0;
+	size_t m_tailPosition = 0;
+};
+
+#endif /* RLECODEC_H */
@@ -0,0 +1,804 @@
+#ifndef RLECONTAINER_H
+#define RLECONTAINER_H
+
+#include "RleCodec.h"
+#include "StreamDecorator.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Chunked RLE container, version 1. All integers are little-endian.
+//
+//   header   "RLEC", version u8, 3 reserved bytes, chunk size u32
+//   chunk    raw size u32, packed size u32, checksum u32, packed bytes
+//   ...
+//   end      12 zero bytes
+//   index    per chunk: record offset u64, raw offset u64, raw size u32,
+//            packed size u32, checksum u32
+//   footer   index offset u64, chunk count u32, "RLEI"
+//
+// Every chunk is packed on its own, so chunks can be packed and unpacked in
+// parallel, and the index lets a reader start at any chunk.
+class RleContainerFormat
+{
+public:
+	static constexpr uint8_t k_version = 1;
+	static constexpr uint32_t k_defaultChunkSize = 64 * 1024;
+	static constexpr size_t k_headerSize = 12;
+	static constexpr size_t k_chunkHeaderSize = 12;
+	static constexpr size_t k_indexEntrySize = 28;
+	static constexpr size_t k_footerSize = 16;
+	static constexpr std::array<uint8_t, 4> k_headerMagic = { 'R', 'L', 'E', 'C' };
+	static constexpr std::array<uint8_t, 4> k_footerMagic = { 'R', 'L', 'E', 'I' };
+
+	struct ChunkInfo
+	{
+		uint64_t recordOffset = 0;
+		uint64_t rawOffset = 0;
+		uint32_t rawSize = 0;
+		uint32_t packedSize = 0;
+		uint32_t checksum = 0;
+	};
+
+	// Every byte packs to at most three bytes (an escaped 0xFF).
+	static size_t MaxPackedSize(size_t rawSize)
+	{
+		return rawSize * 3;
+	}
+
+	static uint32_t Checksum(std::span<const uint8_t> data)
+	{
+		uint32_t hash = 2166136261u;
+		for (uint8_t byte : data)
+		{
+			hash = (hash ^ byte) * 16777619u;
+		}
+		return hash;
+	}
+
+	static size_t PackChunk(std::span<const uint8_t> raw, std::span<uint8_t> packed)
+	{
+		RleEncoder encoder;
+		std::span<uint8_t> output = packed;
+		encoder.Encode(raw, output);
+		encoder.Finish(output);
+		return packed.size() - output.size();
+	}
+
+	static void UnpackChunk(const ChunkInfo& chunk, std::span<const uint8_t> packed, std::span<uint8_t> raw)
+	{
+		if (packed.size() != chunk.packedSize || raw.size() != chunk.rawSize
+			|| Checksum(packed) != chunk.checksum)
+		{
+			throw std::runtime_error("Corrupted container chunk");
+		}
+
+		RleDecoder decoder;
+		std::span<uint8_t> output = raw;
+		decoder.Decode(packed, output);
+		if (!packed.empty() || !output.empty() || decoder.HasPendingOutput())
+		{
+			throw std::runtime_error("Corrupted container chunk");
+		}
+	}
+
+	static void PutHeader(uint8_t* dst, uint32_t chunkSize)
+	{
+		std::copy(k_headerMagic.begin(), k_headerMagic.end(), dst);
+		dst[4] = k_version;
+		dst[5] = dst[6] = dst[7] = 0;
+		PutU32(dst + 8, chunkSize);
+	}
+
+	static uint32_t GetChunkSize(const uint8_t* src)
+	{
+		if (!std::equal(k_headerMagic.begin(), k_headerMagic.end(), src))
+		{
+			throw std::runtime_error("Not an RLE container");
+		}
+		if (src[4] != k_version)
+		{
+			throw std::runtime_error("Unsupported RLE container version");
+		}
+		uint32_t chunkSize = GetU32(src + 8);
+		if (chunkSize == 0)
+		{
+			throw std::runtime_error("Corrupted container header");
+		}
+		return chunkSize;
+	}
+
+	static void PutChunkHeader(uint8_t* dst, const ChunkInfo& chunk)
+	{
+		PutU32(dst, chunk.rawSize);
+		PutU32(dst + 4, chunk.packedSize);
+		PutU32(dst + 8, chunk.checksum);
+	}
+
+	static ChunkInfo GetChunkHeader(const uint8_t* src)
+	{
+		ChunkInfo chunk;
+		chunk.rawSize = GetU32(src);
+		chunk.packedSize = GetU32(src + 4);
+		chunk.checksum = GetU32(src + 8);
+		return chunk;
+	}
+
+	// A record reached through the index must describe the same chunk.
+	static void CheckChunkHeader(const uint8_t* src, const ChunkInfo& chunk)
+	{
+		auto header = GetChunkHeader(src);
+		if (header.rawSize != chunk.rawSize || header.packedSize != chunk.packedSize || header.checksum != chunk.checksum)
+		{
+			throw std::runtime_error("Corrupted container chunk");
+		}
+	}
+
+	static void PutIndexEntry(uint8_t* dst, const ChunkInfo& chunk)
+	{
+		PutU64(dst, chunk.recordOffset);
+		PutU64(dst + 8, chunk.rawOffset);
+		PutChunkHeader(dst + 16, chunk);
+	}
+
+	static ChunkInfo GetIndexEntry(const uint8_t* src)
+	{
+		ChunkInfo chunk = GetChunkHeader(src + 16);
+		chunk.recordOffset = GetU64(src);
+		chunk.rawOffset = GetU64(src + 8);
+		return chunk;
+	}
+
+	static void PutFooter(uint8_t* dst, uint64_t indexOffset, uint32_t chunkCount)
+	{
+		PutU64(dst, indexOffset);
+		PutU32(dst + 8, chunkCount);
+		std::copy(k_footerMagic.begin(), k_footerMagic.end(), dst + 12);
+	}
+
+	static std::pair<uint64_t, uint32_t> GetFooter(const uint8_t* src)
+	{
+		if (!std::equal(k_footerMagic.begin(), k_footerMagic.end(), src + 12))
+		{
+			throw std::runtime_error("Corrupted container footer");
+		}
+		return { GetU64(src), GetU32(src + 8) };
+	}
+
+	// Checks the footer against the container: the index must end right where
+	// the footer starts. Returns the index offset and the chunk count.
+	static std::pair<uint64_t, uint32_t> GetIndexLocation(const uint8_t* footer, uint64_t indexEnd)
+	{
+		auto [indexOffset, chunkCount] = GetFooter(footer);
+		const uint64_t indexSize = uint64_t{ chunkCount } * k_indexEntrySize;
+		if (indexOffset < k_headerSize || !FitsIn(indexOffset, indexSize, indexEnd)
+			|| indexOffset + indexSize != indexEnd)
+		{
+			throw std::runtime_error("Corrupted container footer");
+		}
+		return { indexOffset, chunkCount };
+	}
+
+	// Offsets come from the file, so each one is checked against the container
+	// before it is added to anything.
+	static std::vector<ChunkInfo> GetIndex(std::span<const uint8_t> entries, uint64_t indexOffset, uint32_t chunkSize)
+	{
+		std::vector<ChunkInfo> index;
+		uint64_t rawOffset = 0;
+		for (size_t position = 0; position + k_indexEntrySize <= entries.size(); position += k_indexEntrySize)
+		{
+			auto chunk = GetIndexEntry(entries.data() + position);
+			if (chunk.rawOffset != rawOffset || chunk.rawSize > chunkSize
+				|| chunk.recordOffset < k_headerSize
+				|| !FitsIn(chunk.recordOffset, k_chunkHeaderSize + uint64_t{ chunk.packedSize }, indexOffset))
+			{
+				throw std::runtime_error("Corrupted container index");
+			}
+			rawOffset += chunk.rawSize;
+			index.push_back(chunk);
+		}
+		return index;
+	}
+
+	// The chunk covering offset, which must be below the unpacked size.
+	static size_t FindChunk(const std::vector<ChunkInfo>& index, uint64_t offset)
+	{
+		auto it = std::upper_bound(index.begin(), index.end(), offset,
+			[](uint64_t value, const ChunkInfo& chunk) { return value < chunk.rawOffset; });
+		return static_cast<size_t>(it - index.begin()) - 1;
+	}
+
+	static size_t GetWorkerCount()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+private:
+	// Whether [offset, offset + size) lies within [0, limit), without overflow.
+	static bool FitsIn(uint64_t offset, uint64_t size, uint64_t limit)
+	{
+		return offset <= limit && size <= limit - offset;
+	}
+
+	static void PutU32(uint8_t* dst, uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(value >> (8 * i));
+		}
+	}
+
+	static void PutU64(uint8_t* dst, uint64_t value)
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			dst[i] = static_cast<uint8_t>(value >> (8 * i));
+		}
+	}
+
+	static uint32_t GetU32(const uint8_t* src)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			value |= static_cast<uint32_t>(src[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	static uint64_t GetU64(const uint8_t* src)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < 8; ++i)
+		{
+			value |= static_cast<uint64_t>(src[i]) << (8 * i);
+		}
+		return value;
+	}
+};
+
+class ChunkedPackingOutputStreamDecorator : public IOutputStream
+{
+private:
+	using Format = RleContainerFormat;
+
+	IOutputStreamPtr m_outputStream;
+	uint32_t m_chunkSize;
+	size_t m_batchSize;
+	std::vector<uint8_t> m_raw;
+	std::vector<std::vector<uint8_t>> m_packed;
+	std::vector<size_t> m_packedSizes;
+	std::vector<Format::ChunkInfo> m_index;
+	WorkerPool m_pool;
+	uint64_t m_offset = 0;
+	uint64_t m_rawOffset = 0;
+	bool m_isClosed = false;
+
+public:
+	ChunkedPackingOutputStreamDecorator(
+		IOutputStreamPtr outputStream, uint32_t chunkSize = Format::k_defaultChunkSize)
+		: m_outputStream(std::move(outputStream))
+		, m_chunkSize(chunkSize)
+		, m_batchSize(Format::GetWorkerCount())
+		, m_packed(m_batchSize, std::vector<uint8_t>(Format::MaxPackedSize(chunkSize)))
+		, m_packedSizes(m_batchSize)
+		, m_pool(m_batchSize)
+	{
+		if (chunkSize == 0)
+		{
+			throw std::invalid_argument("Chunk size must be positive");
+		}
+		m_raw.reserve(m_chunkSize * m_batchSize);
+
+		std::array<uint8_t, Format::k_headerSize> header;
+		Format::PutHeader(header.data(), m_chunkSize);
+		Write(header.data(), header.size());
+	}
+
+	~ChunkedPackingOutputStreamDecorator() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		try
+		{
+			Finish();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void WriteByte(uint8_t data) override
+	{
+		WriteBlock(&data, 1);
+	}
+
+	void WriteBlock(const void* srcData, std::streamsize size) override
+	{
+		if (m_isClosed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+
+		auto* data = static_cast<const uint8_t*>(srcData);
+		size_t batchBytes = static_cast<size_t>(m_chunkSize) * m_batchSize;
+		while (size > 0)
+		{
+			size_t count = std::min(static_cast<size_t>(size), batchBytes - m_raw.size());
+			m_raw.insert(m_raw.end(), data, data + count);
+			data += count;
+			size -= static_cast<std::streamsize>(count);
+			if (m_raw.size() == batchBytes)
+			{
+				FlushBatch();
+			}
+		}
+	}
+
+	void Close() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		Finish();
+		m_outputStream->Close();
+	}
+
+private:
+	void Finish()
+	{
+		m_isClosed = true;
+		FlushBatch();
+
+		std::array<uint8_t, Format::k_chunkHeaderSize> endRecord{};
+		Write(endRecord.data(), endRecord.size());
+
+		uint64_t indexOffset = m_offset;
+		std::array<uint8_t, Format::k_indexEntrySize> entry;
+		for (const auto& chunk : m_index)
+		{
+			Format::PutIndexEntry(entry.data(), chunk);
+			Write(entry.data(), entry.size());
+		}
+
+		std::array<uint8_t, Format::k_footerSize> footer;
+		Format::PutFooter(footer.data(), indexOffset, static_cast<uint32_t>(m_index.size()));
+		Write(footer.data(), footer.size());
+	}
+
+	void FlushBatch()
+	{
+		size_t chunkCount = (m_raw.size() + m_chunkSize - 1) / m_chunkSize;
+		m_pool.Run(chunkCount, [this](size_t i) {
+			m_packedSizes[i] = Format::PackChunk(RawChunk(i), m_packed[i]);
+		});
+
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			auto raw = RawChunk(i);
+			std::span<const uint8_t> packed(m_packed[i].data(), m_packedSizes[i]);
+
+			Format::ChunkInfo chunk;
+			chunk.recordOffset = m_offset;
+			chunk.rawOffset = m_rawOffset;
+			chunk.rawSize = static_cast<uint32_t>(raw.size());
+			chunk.packedSize = static_cast<uint32_t>(packed.size());
+			chunk.checksum = Format::Checksum(packed);
+			m_index.push_back(chunk);
+
+			std::array<uint8_t, Format::k_chunkHeaderSize> header;
+			Format::PutChunkHeader(header.data(), chunk);
+			Write(header.data(), header.size());
+			Write(packed.data(), packed.size());
+			m_rawOffset += raw.size();
+		}
+		m_raw.clear();
+	}
+
+	std::span<const uint8_t> RawChunk(size_t i) const
+	{
+		size_t begin = i * m_chunkSize;
+		return std::span<const uint8_t>(m_raw).subspan(begin, std::min<size_t>(m_chunkSize, m_raw.size() - begin));
+	}
+
+	void Write(const uint8_t* data, size_t size)
+	{
+		m_outputStream->WriteBlock(data, static_cast<std::streamsize>(size));
+		m_offset += size;
+	}
+};
+
+// Reads chunks in order and unpacks them a batch at a time. Over a seekable
+// stream it is seekable too: the index is read from the trailer with ReadAt on
+// first use, and Seek and ReadAt unpack only the chunks covering the range.
+class ChunkedUnpackingInputStreamDecorator : public ISeekableInputStream
+{
+private:
+	using Format = RleContainerFormat;
+
+	IInputStreamPtr m_inputStream;
+	uint32_t m_chunkSize = 0;
+	size_t m_batchSize;
+	std::vector<uint8_t> m_packed;
+	std::vector<uint8_t> m_decoded;
+	WorkerPool m_pool;
+	size_t m_position = 0;
+	uint64_t m_offset = 0;
+	uint32_t m_chunkCount = 0;
+	bool m_isFinished = false;
+
+	std::once_flag m_indexLoaded;
+	std::vector<Format::ChunkInfo> m_index;
+	uint32_t m_indexChunkSize = 0;
+	uint64_t m_indexOffset = 0;
+	uint64_t m_size = 0;
+
+public:
+	ChunkedUnpackingInputStreamDecorator(IInputStreamPtr inputStream)
+		: m_inputStream(std::move(inputStream))
+		, m_batchSize(Format::GetWorkerCount())
+		, m_pool(m_batchSize)
+	{
+	}
+
+	bool IsEOF() override
+	{
+		if (m_position == m_decoded.size() && !m_isFinished)
+		{
+			FillBatch();
+		}
+		return m_isFinished && m_position == m_decoded.size();
+	}
+
+	uint8_t ReadByte() override
+	{
+		uint8_t data;
+		if (ReadBlock(&data, 1) != 1)
+		{
+			throw std::runtime_error("ReadByte failed");
+		}
+		return data;
+	}
+
+	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
+	{
+		auto* dst = static_cast<uint8_t*>(dstBuffer);
+		std::streamsize total = 0;
+		while (total < size && !IsEOF())
+		{
+			size_t count = std::min(static_cast<size_t>(size - total), m_decoded.size() - m_position);
+			std::memcpy(dst + total, m_decoded.data() + m_position, count);
+			m_position += count;
+			total += static_cast<std::streamsize>(count);
+		}
+		return total;
+	}
+
+	bool IsSeekable() const override
+	{
+		auto* input = dynamic_cast<ISeekableInputStream*>(m_inputStream.get());
+		return input && input->IsSeekable();
+	}
+
+	std::streamsize Size() override
+	{
+		LoadIndex();
+		return static_cast<std::streamsize>(m_size);
+	}
+
+	// Unpacks the chunk covering position and moves the wrapped stream to the
+	// record after it, so sequential reading carries on from there.
+	void Seek(std::streamsize position) override
+	{
+		CheckSeekPosition(position, Size());
+		auto& input = GetSeekableInput();
+
+		size_t chunkIndex = m_index.size();
+		m_decoded.clear();
+		m_position = 0;
+		if (static_cast<uint64_t>(position) < m_size)
+		{
+			chunkIndex = Format::FindChunk(m_index, static_cast<uint64_t>(position));
+			const auto& chunk = m_index[chunkIndex];
+			m_decoded.resize(chunk.rawSize);
+			UnpackIndexedChunk(chunk, m_packed, m_decoded);
+			m_position = static_cast<size_t>(static_cast<uint64_t>(position) - chunk.rawOffset);
+			++chunkIndex;
+		}
+
+		m_chunkSize = m_indexChunkSize;
+		m_chunkCount = static_cast<uint32_t>(chunkIndex);
+		m_offset = chunkIndex < m_index.size()
+			? m_index[chunkIndex].recordOffset
+			: m_indexOffset - Format::k_chunkHeaderSize;
+		m_isFinished = false;
+		input.Seek(static_cast<std::streamsize>(m_offset));
+	}
+
+	std::streamsize ReadAt(std::streamsize offset, std::span<uint8_t> buffer) override
+	{
+		LoadIndex();
+		if (offset < 0)
+		{
+			return 0;
+		}
+
+		std::vector<uint8_t> packed;
+		std::vector<uint8_t> raw;
+		auto position = static_cast<uint64_t>(offset);
+		size_t total = 0;
+		while (total < buffer.size() && position < m_size)
+		{
+			const auto& chunk = m_index[Format::FindChunk(m_index, position)];
+			raw.resize(chunk.rawSize);
+			UnpackIndexedChunk(chunk, packed, raw);
+
+			size_t begin = static_cast<size_t>(position - chunk.rawOffset);
+			size_t count = std::min(buffer.size() - total, raw.size() - begin);
+			std::memcpy(buffer.data() + total, raw.data() + begin, count);
+			total += count;
+			position += count;
+		}
+		return static_cast<std::streamsize>(total);
+	}
+
+private:
+	ISeekableInputStream& GetSeekableInput()
+	{
+		if (!IsSeekable())
+		{
+			throw std::runtime_error("Stream is not seekable");
+		}
+		return static_cast<ISeekableInputStream&>(*m_inputStream);
+	}
+
+	// Reads the header, footer and index with ReadAt, which leaves the
+	// sequential position alone. A failed load is retried by the next call.
+	void LoadIndex()
+	{
+		auto& input = GetSeekableInput();
+		std::call_once(m_indexLoaded, [&] {
+			const auto size = static_cast<uint64_t>(input.Size());
+			if (size < Format::k_headerSize + Format::k_chunkHeaderSize + Format::k_footerSize)
+			{
+				throw std::runtime_error("Truncated RLE container");
+			}
+
+			std::array<uint8_t, Format::k_headerSize> header;
+			ReadExactAt(input, 0, header);
+			uint32_t chunkSize = Format::GetChunkSize(header.data());
+
+			std::array<uint8_t, Format::k_footerSize> footer;
+			const uint64_t indexEnd = size - Format::k_footerSize;
+			ReadExactAt(input, indexEnd, footer);
+			auto [indexOffset, chunkCount] = Format::GetIndexLocation(footer.data(), indexEnd);
+
+			std::vector<uint8_t> entries(static_cast<size_t>(indexEnd - indexOffset));
+			ReadExactAt(input, indexOffset, entries);
+			m_index = Format::GetIndex(entries, indexOffset, chunkSize);
+			m_size = m_index.empty() ? 0 : m_index.back().rawOffset + m_index.back().rawSize;
+			m_indexChunkSize = chunkSize;
+			m_indexOffset = indexOffset;
+		});
+	}
+
+	// Only ReadAt of the wrapped stream is used, so this is safe to call from
+	// several threads with their own buffers.
+	void UnpackIndexedChunk(const Format::ChunkInfo& chunk, std::vector<uint8_t>& packed, std::span<uint8_t> raw)
+	{
+		auto& input = GetSeekableInput();
+		packed.resize(Format::k_chunkHeaderSize + chunk.packedSize);
+		ReadExactAt(input, chunk.recordOffset, packed);
+		Format::CheckChunkHeader(packed.data(), chunk);
+		Format::UnpackChunk(chunk, std::span<const uint8_t>(packed).subspan(Format::k_chunkHeaderSize), raw);
+	}
+
+	static void ReadExactAt(ISeekableInputStream& input, uint64_t offset, std::span<uint8_t> dst)
+	{
+		if (input.ReadAt(static_cast<std::streamsize>(offset), dst) != static_cast<std::streamsize>(dst.size()))
+		{
+			throw std::runtime_error("Truncated RLE container");
+		}
+	}
+
+	void FillBatch()
+	{
+		if (m_chunkSize == 0)
+		{
+			ReadHeader();
+		}
+
+		std::vector<Format::ChunkInfo> chunks;
+		std::vector<size_t> packedOffsets;
+		m_packed.clear();
+		while (chunks.size() < m_batchSize)
+		{
+			std::array<uint8_t, Format::k_chunkHeaderSize> header;
+			ReadExact(header.data(), header.size());
+			Format::ChunkInfo chunk = Format::GetChunkHeader(header.data());
+			if (chunk.rawSize == 0 && chunk.packedSize == 0)
+			{
+				ReadTrailer();
+				break;
+			}
+			if (chunk.rawSize > m_chunkSize || chunk.packedSize > Format::MaxPackedSize(chunk.rawSize))
+			{
+				throw std::runtime_error("Corrupted container chunk");
+			}
+
+			packedOffsets.push_back(m_packed.size());
+			m_packed.resize(m_packed.size() + chunk.packedSize);
+			ReadExact(m_packed.data() + packedOffsets.back(), chunk.packedSize);
+			chunks.push_back(chunk);
+		}
+
+		DecodeBatch(chunks, packedOffsets);
+	}
+
+	void DecodeBatch(const std::vector<Format::ChunkInfo>& chunks, const std::vector<size_t>& packedOffsets)
+	{
+		size_t rawSize = 0;
+		std::vector<size_t> rawOffsets;
+		for (const auto& chunk : chunks)
+		{
+			rawOffsets.push_back(rawSize);
+			rawSize += chunk.rawSize;
+		}
+		m_decoded.resize(rawSize);
+		m_position = 0;
+
+		m_pool.Run(chunks.size(), [&](size_t i) {
+			Format::UnpackChunk(chunks[i],
+				std::span<const uint8_t>(m_packed).subspan(packedOffsets[i], chunks[i].packedSize),
+				std::span<uint8_t>(m_decoded).subspan(rawOffsets[i], chunks[i].rawSize));
+		});
+		m_chunkCount += static_cast<uint32_t>(chunks.size());
+	}
+
+	void ReadHeader()
+	{
+		std::array<uint8_t, Format::k_headerSize> header;
+		ReadExact(header.data(), header.size());
+		m_chunkSize = Format::GetChunkSize(header.data());
+	}
+
+	// The index is not needed for sequential reading; it is only checked
+	// against the chunks that were read.
+	void ReadTrailer()
+	{
+		uint64_t indexOffset = m_offset;
+		std::array<uint8_t, Format::k_indexEntrySize> entry;
+		for (uint32_t i = 0; i < m_chunkCount; ++i)
+		{
+			ReadExact(entry.data(), entry.size());
+		}
+
+		std::array<uint8_t, Format::k_footerSize> footer;
+		ReadExact(footer.data(), footer.size());
+		auto [footerIndexOffset, chunkCount] = Format::GetFooter(footer.data());
+		if (footerIndexOffset != indexOffset || chunkCount != m_chunkCount)
+		{
+			throw std::runtime_error("Corrupted container footer");
+		}
+		m_isFinished = true;
+	}
+
+	void ReadExact(uint8_t* dst, size_t size)
+	{
+		size_t total = 0;
+		while (total < size && !m_inputStream->IsEOF())
+		{
+			total += static_cast<size_t>(m_inputStream->ReadBlock(dst + total, static_cast<std::streamsize>(size - total)));
+		}
+		if (total != size)
+		{
+			throw std::runtime_error("Truncated RLE container");
+		}
+		m_offset += size;
+	}
+};
+
+// Random access over a whole container held in memory, for example the
+// borrowed pages of a MappedFileInputStream. Only the chunks that cover the
+// requested range are unpacked.
+class RleContainerView
+{
+private:
+	using Format = RleContainerFormat;
+
+	std::span<const uint8_t> m_data;
+	std::vector<Format::ChunkInfo> m_index;
+	uint64_t m_size = 0;
+	size_t m_cachedChunk = SIZE_MAX;
+	std::vector<uint8_t> m_cache;
+	std::unique_ptr<WorkerPool> m_pool;
+
+public:
+	RleContainerView(std::span<const uint8_t> data)
+		: m_data(data)
+	{
+		if (m_data.size() < Format::k_headerSize + Format::k_chunkHeaderSize + Format::k_footerSize)
+		{
+			throw std::runtime_error("Truncated RLE container");
+		}
+		uint32_t chunkSize = Format::GetChunkSize(m_data.data());
+		const uint64_t indexEnd = m_data.size() - Format::k_footerSize;
+		auto [indexOffset, chunkCount] = Format::GetIndexLocation(m_data.data() + indexEnd, indexEnd);
+		m_index = Format::GetIndex(m_data.subspan(indexOffset, indexEnd - indexOffset), indexOffset, chunkSize);
+		if (!m_index.empty())
+		{
+			m_size = m_index.back().rawOffset + m_index.back().rawSize;
+		}
+	}
+
+	uint64_t Size() const
+	{
+		return m_size;
+	}
+
+	size_t ReadAt(uint64_t offset, std::span<uint8_t> dst)
+	{
+		size_t total = 0;
+		while (total < dst.size() && offset < m_size)
+		{
+			size_t chunkIndex = Format::FindChunk(m_index, offset);
+			const auto& chunk = m_index[chunkIndex];
+			LoadChunk(chunkIndex);
+
+			size_t begin = static_cast<size_t>(offset - chunk.rawOffset);
+			size_t count = std::min(dst.size() - total, chunk.rawSize - begin);
+			std::memcpy(dst.data() + total, m_cache.data() + begin, count);
+			total += count;
+			offset += count;
+		}
+		return total;
+	}
+
+	// The pool is started by the first call, so a view that is only read at
+	// random offsets never starts threads.
+	std::vector<uint8_t> UnpackAll()
+	{
+		if (!m_pool)
+		{
+			m_pool = std::make_unique<WorkerPool>(Format::GetWorkerCount());
+		}
+		std::vector<uint8_t> result(m_size);
+		m_pool->Run(m_index.size(), [&](size_t i) {
+			const auto& chunk = m_index[i];
+			Format::UnpackChunk(chunk, PackedChunk(chunk),
+				std::span<uint8_t>(result).subspan(chunk.rawOffset, chunk.rawSize));
+		});
+		return result;
+	}
+
+private:
+	void LoadChunk(size_t chunkIndex)
+	{
+		if (chunkIndex == m_cachedChunk)
+		{
+			return;
+		}
+		const auto& chunk = m_index[chunkIndex];
+		m_cache.resize(chunk.rawSize);
+		Format::UnpackChunk(chunk, PackedChunk(chunk), m_cache);
+		m_cachedChunk = chunkIndex;
+	}
+
+	std::span<const uint8_t> PackedChunk(const Format::ChunkInfo& chunk) const
+	{
+		Format::CheckChunkHeader(m_data.data() + chunk.recordOffset, chunk);
+		return m_data.subspan(chunk.recordOffset + Format::k_chunkHeaderSize, chunk.packedSize);
+	}
+};
+
+#endif /* RLECONTAINER_H */
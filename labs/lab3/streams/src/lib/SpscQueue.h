@@ -0,0 +1,96 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Push and Pop sleep in std::atomic::wait while the queue is full or empty;
+// Close wakes both sides and makes every later Push and Pop fail.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	bool TryPush(const T& value)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		m_items[tail & (Capacity - 1)] = value;
+		m_tail.store(tail + 1, std::memory_order_release);
+		Signal(m_pushes);
+		return true;
+	}
+
+	bool TryPop(T& value)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = m_items[head & (Capacity - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		Signal(m_pops);
+		return true;
+	}
+
+	bool Push(const T& value)
+	{
+		return WaitFor(m_pops, [&] { return TryPush(value); });
+	}
+
+	bool Pop(T& value)
+	{
+		return WaitFor(m_pushes, [&] { return TryPop(value); });
+	}
+
+	void Close()
+	{
+		m_isClosed.store(true, std::memory_order_release);
+		Signal(m_pushes);
+		Signal(m_pops);
+	}
+
+private:
+	static void Signal(std::atomic<uint32_t>& counter)
+	{
+		counter.fetch_add(1, std::memory_order_release);
+		counter.notify_one();
+	}
+
+	// The counter is read before the attempt, so a change made by the other
+	// side between a failed attempt and the wait is not missed.
+	template <typename Attempt>
+	bool WaitFor(std::atomic<uint32_t>& counter, Attempt&& attempt)
+	{
+		while (true)
+		{
+			uint32_t seen = counter.load(std::memory_order_acquire);
+			if (m_isClosed.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			if (attempt())
+			{
+				return true;
+			}
+			counter.wait(seen, std::memory_order_acquire);
+		}
+	}
+
+	std::array<T, Capacity> m_items{};
+	alignas(64) std::atomic<size_t> m_head{ 0 };
+	alignas(64) std::atomic<size_t> m_tail{ 0 };
+	alignas(64) std::atomic<uint32_t> m_pushes{ 0 };
+	alignas(64) std::atomic<uint32_t> m_pops{ 0 };
+	std::atomic<bool> m_isClosed{ false };
+};
+
+#endif /* SPSCQUEUE_H */
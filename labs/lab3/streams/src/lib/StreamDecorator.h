@@ -4,12 +4,20 @@
 #include "DataProcessor.h"
 #include "InputStream.h"
 #include "OutputStream.h"
+#include "RleCodec.h"
+#include <array>
 #include <memory>
+#include <span>
+#include <vector>
 
 using IInputStreamPtr = std::unique_ptr<IInputStream>;
 using IOutputStreamPtr = std::unique_ptr<IOutputStream>;
 
-class InputStreamDecorator : public IInputStream
+// Seekable whenever the wrapped stream is and the processor is position
+// independent; other decorators report IsSeekable() == false. Over a stream
+// that lends its memory, such a processor reads the borrowed block straight
+// into the caller's buffer, so the data is touched once.
+class InputStreamDecorator : public ISeekableInputStream
 {
 protected:
 	IInputStreamPtr m_inputStream;
@@ -21,6 +29,11 @@ public:
 		: m_inputStream(std::move(inputStream))
 		, m_dataProcessor(std::move(dataProcessor))
 	{
+		FuseWithInnerDecorator();
+		if (m_dataProcessor->IsPositionIndependent())
+		{
+			m_borrowingInput = dynamic_cast<IBorrowingInputStream*>(m_inputStream.get());
+		}
 	}
 
 	bool IsEOF() override
@@ -36,16 +49,81 @@ public:
 
 	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
 	{
+		if (m_borrowingInput)
+		{
+			auto block = m_borrowingInput->BorrowBlock(size);
+			return m_dataProcessor->TransformBlock(block, std::span<uint8_t>(static_cast<uint8_t*>(dstBuffer), block.size()));
+		}
 		std::streamsize bytesRead = m_inputStream->ReadBlock(dstBuffer, size);
 		return m_dataProcessor->ProcessDataBlock(dstBuffer, bytesRead);
 	}
+
+	bool IsSeekable() const override
+	{
+		auto* input = dynamic_cast<ISeekableInputStream*>(m_inputStream.get());
+		return input && input->IsSeekable() && m_dataProcessor->IsPositionIndependent();
+	}
+
+	std::streamsize Size() override
+	{
+		return GetSeekableInput().Size();
+	}
+
+	void Seek(std::streamsize position) override
+	{
+		GetSeekableInput().Seek(position);
+	}
+
+	std::streamsize ReadAt(std::streamsize offset, std::span<uint8_t> buffer) override
+	{
+		std::streamsize bytesRead = GetSeekableInput().ReadAt(offset, buffer);
+		return m_dataProcessor->ProcessDataBlock(buffer.data(), bytesRead);
+	}
+
+private:
+	IBorrowingInputStream* m_borrowingInput = nullptr;
+
+	ISeekableInputStream& GetSeekableInput()
+	{
+		if (!IsSeekable())
+		{
+			throw std::runtime_error("Stream is not seekable");
+		}
+		return static_cast<ISeekableInputStream&>(*m_inputStream);
+	}
+
+	// Two stacked substitutions become one table, so a chain of them costs a
+	// single pass over the data. The inner decorator was fused the same way
+	// when it was built, so looking one level down is enough.
+	void FuseWithInnerDecorator()
+	{
+		auto* inner = dynamic_cast<InputStreamDecorator*>(m_inputStream.get());
+		auto* outer = dynamic_cast<SubstitutionDataProcessor*>(m_dataProcessor.get());
+		if (!inner || !outer)
+		{
+			return;
+		}
+		auto* first = dynamic_cast<SubstitutionDataProcessor*>(inner->m_dataProcessor.get());
+		if (!first)
+		{
+			return;
+		}
+		m_dataProcessor = SubstitutionDataProcessor::Compose(*first, *outer);
+		m_inputStream = std::move(inner->m_inputStream);
+	}
 };
 
-class OutputStreamDecorator : public IOutputStream
+// Over a stream that lets callers write into its memory, a position
+// independent processor transforms writes straight into the reserved block and
+// passes reservations through, so the data is touched once.
+class OutputStreamDecorator
+	: public IOutputStream
+	, public IReservingOutputStream
 {
 protected:
 	IOutputStreamPtr m_outputStream;
 	IDataProcessorPtr m_dataProcessor;
+	std::vector<uint8_t> m_buffer;
 
 public:
 	OutputStreamDecorator(
@@ -53,6 +131,12 @@ public:
 		: m_outputStream(std::move(outputStream))
 		, m_dataProcessor(std::move(dataProcessor))
 	{
+		FuseWithInnerDecorator();
+		auto* output = dynamic_cast<IReservingOutputStream*>(m_outputStream.get());
+		if (output && output->CanReserve() && m_dataProcessor->IsPositionIndependent())
+		{
+			m_reservingOutput = output;
+		}
 	}
 
 	void WriteByte(uint8_t data) override
@@ -63,17 +147,78 @@ public:
 
 	void WriteBlock(const void* srcData, std::streamsize size) override
 	{
-		std::vector<uint8_t> buffer(size);
-		std::memcpy(buffer.data(), srcData, size);
-		std::streamsize processedSize
-			= m_dataProcessor->ProcessDataBlock(buffer.data(), size);
-		m_outputStream->WriteBlock(buffer.data(), processedSize);
+		std::span<const uint8_t> src(static_cast<const uint8_t*>(srcData), static_cast<size_t>(size));
+		if (m_reservingOutput)
+		{
+			while (!src.empty())
+			{
+				auto block = m_reservingOutput->Reserve(static_cast<std::streamsize>(src.size()));
+				auto count = m_dataProcessor->TransformBlock(src.first(block.size()), block);
+				m_reservingOutput->Commit(count);
+				src = src.subspan(block.size());
+			}
+			return;
+		}
+
+		// The caller's data is const, so it is processed into a scratch buffer
+		// that only grows and is reused by later writes.
+		if (m_buffer.size() < static_cast<size_t>(size))
+		{
+			m_buffer.resize(static_cast<size_t>(size));
+		}
+		std::streamsize processedSize = m_dataProcessor->TransformBlock(src, m_buffer);
+		m_outputStream->WriteBlock(m_buffer.data(), processedSize);
+	}
+
+	bool CanReserve() const override
+	{
+		return m_reservingOutput != nullptr;
+	}
+
+	std::span<uint8_t> Reserve(std::streamsize size) override
+	{
+		if (!m_reservingOutput)
+		{
+			throw std::runtime_error("Stream cannot reserve blocks");
+		}
+		m_reserved = m_reservingOutput->Reserve(size);
+		return m_reserved;
+	}
+
+	// The committed bytes are processed where the caller produced them.
+	void Commit(std::streamsize count) override
+	{
+		m_dataProcessor->ProcessDataBlock(m_reserved.data(), count);
+		m_reservingOutput->Commit(count);
 	}
 
 	void Close() override
 	{
 		m_outputStream->Close();
 	}
+
+private:
+	IReservingOutputStream* m_reservingOutput = nullptr;
+	std::span<uint8_t> m_reserved;
+
+	// Data written here passes through this processor first and the inner one
+	// second; see InputStreamDecorator::FuseWithInnerDecorator.
+	void FuseWithInnerDecorator()
+	{
+		auto* inner = dynamic_cast<OutputStreamDecorator*>(m_outputStream.get());
+		auto* outer = dynamic_cast<SubstitutionDataProcessor*>(m_dataProcessor.get());
+		if (!inner || !outer)
+		{
+			return;
+		}
+		auto* second = dynamic_cast<SubstitutionDataProcessor*>(inner->m_dataProcessor.get());
+		if (!second)
+		{
+			return;
+		}
+		m_dataProcessor = SubstitutionDataProcessor::Compose(*outer, *second);
+		m_outputStream = std::move(inner->m_outputStream);
+	}
 };
 
 class DecodingInputStreamDecorator : public InputStreamDecorator
@@ -86,13 +231,60 @@ public:
 	}
 };
 
-class UnpackingInputStreamDecorator : public InputStreamDecorator
+class UnpackingInputStreamDecorator : public IInputStream
 {
+private:
+	IInputStreamPtr m_inputStream;
+	RleDecoder m_decoder;
+	std::array<uint8_t, 4096> m_buffer;
+	std::span<const uint8_t> m_input;
+
 public:
 	UnpackingInputStreamDecorator(IInputStreamPtr inputStream)
-		: InputStreamDecorator(std::move(inputStream),
-			  std::make_shared<UnpackingDataProcessor>())
+		: m_inputStream(std::move(inputStream))
+	{
+	}
+
+	bool IsEOF() override
+	{
+		return m_input.empty() && !m_decoder.HasPendingOutput() && m_inputStream->IsEOF();
+	}
+
+	uint8_t ReadByte() override
 	{
+		uint8_t data;
+		if (ReadBlock(&data, 1) != 1)
+		{
+			throw std::runtime_error("ReadByte failed");
+		}
+		return data;
+	}
+
+	std::streamsize ReadBlock(void* dstBuffer, std::streamsize size) override
+	{
+		std::span<uint8_t> output(static_cast<uint8_t*>(dstBuffer), static_cast<size_t>(size));
+		while (!output.empty())
+		{
+			m_decoder.Decode(m_input, output);
+			if (!output.empty() && m_input.empty() && !FillInput())
+			{
+				m_decoder.Finish(output);
+				break;
+			}
+		}
+		return size - static_cast<std::streamsize>(output.size());
+	}
+
+private:
+	bool FillInput()
+	{
+		if (m_inputStream->IsEOF())
+		{
+			return false;
+		}
+		std::streamsize bytesRead = m_inputStream->ReadBlock(m_buffer.data(), m_buffer.size());
+		m_input = std::span<const uint8_t>(m_buffer.data(), static_cast<size_t>(bytesRead));
+		return bytesRead > 0;
 	}
 };
 
@@ -106,13 +298,102 @@ public:
 	}
 };
 
-class PackingOutputStreamDecorator : public OutputStreamDecorator
+class PackingOutputStreamDecorator : public IOutputStream
 {
+private:
+	IOutputStreamPtr m_outputStream;
+	RleEncoder m_encoder;
+	std::array<uint8_t, 4096> m_buffer;
+	size_t m_bufferedSize = 0;
+	bool m_isClosed = false;
+
 public:
 	PackingOutputStreamDecorator(IOutputStreamPtr outputStream)
-		: OutputStreamDecorator(
-			  std::move(outputStream), std::make_shared<PackingDataProcessor>())
+		: m_outputStream(std::move(outputStream))
+	{
+	}
+
+	~PackingOutputStreamDecorator() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		try
+		{
+			FinishEncoding();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void WriteByte(uint8_t data) override
+	{
+		WriteBlock(&data, 1);
+	}
+
+	void WriteBlock(const void* srcData, std::streamsize size) override
+	{
+		if (m_isClosed)
+		{
+			throw std::runtime_error("Write failed");
+		}
+
+		std::span<const uint8_t> input(static_cast<const uint8_t*>(srcData), static_cast<size_t>(size));
+		while (!input.empty())
+		{
+			auto output = FreeSpace();
+			m_encoder.Encode(input, output);
+			Commit(output);
+		}
+	}
+
+	void Close() override
+	{
+		if (m_isClosed)
+		{
+			return;
+		}
+		FinishEncoding();
+		m_isClosed = true;
+		m_outputStream->Close();
+	}
+
+private:
+	void FinishEncoding()
+	{
+		bool finished = false;
+		while (!finished)
+		{
+			auto output = FreeSpace();
+			finished = m_encoder.Finish(output);
+			Commit(output);
+		}
+		Flush();
+	}
+
+	std::span<uint8_t> FreeSpace()
+	{
+		return std::span<uint8_t>(m_buffer).subspan(m_bufferedSize);
+	}
+
+	void Commit(std::span<uint8_t> freeSpaceLeft)
+	{
+		m_bufferedSize = m_buffer.size() - freeSpaceLeft.size();
+		if (m_bufferedSize == m_buffer.size())
+		{
+			Flush();
+		}
+	}
+
+	void Flush()
 	{
+		if (m_bufferedSize > 0)
+		{
+			m_outputStream->WriteBlock(m_buffer.data(), static_cast<std::streamsize>(m_bufferedSize));
+			m_bufferedSize = 0;
+		}
 	}
 };
 
@@ -0,0 +1,135 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Threads started once and reused for every batch, so a batch costs a wake-up
+// instead of a thread per job. The calling thread runs jobs too, which is why
+// a pool for n workers starts n - 1 threads. Batches are run one at a time
+// from a single caller.
+class WorkerPool
+{
+public:
+	explicit WorkerPool(size_t workerCount)
+	{
+		for (size_t i = 1; i < workerCount; ++i)
+		{
+			m_threads.emplace_back([this] { Work(); });
+		}
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_changed.notify_all();
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	size_t GetWorkerCount() const
+	{
+		return m_threads.size() + 1;
+	}
+
+	// Runs job(0) ... job(count - 1) and returns once all of them have
+	// finished. After a job throws, the jobs not yet started are skipped and
+	// the first exception is rethrown here.
+	template <typename Job>
+	void Run(size_t count, Job&& job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::unique_lock lock(m_mutex);
+		m_job = std::ref(job);
+		m_count = count;
+		m_next = 0;
+		m_changed.notify_all();
+
+		RunJobs(lock);
+		m_finished.wait(lock, [&] { return m_active == 0; });
+
+		m_job = nullptr;
+		m_count = m_next = 0;
+		if (auto error = std::exchange(m_error, nullptr))
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+private:
+	void Work()
+	{
+		std::unique_lock lock(m_mutex);
+		while (true)
+		{
+			m_changed.wait(lock, [&] { return m_isStopped || m_next < m_count; });
+			if (m_isStopped)
+			{
+				return;
+			}
+			RunJobs(lock);
+		}
+	}
+
+	// Takes jobs until none are left; the lock is released while a job runs.
+	void RunJobs(std::unique_lock<std::mutex>& lock)
+	{
+		while (m_next < m_count)
+		{
+			size_t index = m_next++;
+			++m_active;
+			lock.unlock();
+			std::exception_ptr error;
+			try
+			{
+				m_job(index);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			lock.lock();
+			--m_active;
+			if (error && !m_error)
+			{
+				m_error = error;
+				m_next = m_count;
+			}
+		}
+		if (m_active == 0)
+		{
+			m_finished.notify_all();
+		}
+	}
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::condition_variable m_finished;
+	std::function<void(size_t)> m_job;
+	size_t m_count = 0;
+	size_t m_next = 0;
+	size_t m_active = 0;
+	std::exception_ptr m_error;
+	bool m_isStopped = false;
+};
+
+#endif /* WORKERPOOL_H */
@@ -0,0 +1,174 @@
+#include "../src/lib/InputStream.h"
+#include "../src/lib/OutputStream.h"
+#include "../src/lib/StreamDecorator.h"
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+
+// Every allocation in the test binary goes through these replacements, but
+// they count only on a thread inside an AllocationCounter scope, so other tests
+// and gtest itself are not affected. They are kept out of line so that GCC does
+// not pair the inlined free with a new expression.
+namespace
+{
+thread_local bool t_isCounting = false;
+thread_local size_t t_allocationCount = 0;
+
+__attribute__((noinline)) void Deallocate(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+// Counts the allocations made by the current thread while it exists.
+class AllocationCounter
+{
+public:
+	AllocationCounter()
+	{
+		t_allocationCount = 0;
+		t_isCounting = true;
+	}
+
+	AllocationCounter(const AllocationCounter&) = delete;
+	AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+	~AllocationCounter()
+	{
+		t_isCounting = false;
+	}
+
+	size_t GetCount() const
+	{
+		return t_allocationCount;
+	}
+};
+} // namespace
+
+void* operator new(std::size_t size)
+{
+	if (t_isCounting)
+	{
+		++t_allocationCount;
+	}
+	if (void* ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+namespace allocation_tests
+{
+
+class CountingOutputStream : public IOutputStream
+{
+public:
+	void WriteByte(uint8_t) override
+	{
+		++m_size;
+	}
+
+	void WriteBlock(const void*, std::streamsize size) override
+	{
+		m_size += size;
+	}
+
+	void Close() override
+	{
+	}
+
+	std::streamsize GetSize() const
+	{
+		return m_size;
+	}
+
+private:
+	std::streamsize m_size = 0;
+};
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		data[i] = static_cast<uint8_t>(i / 5);
+	}
+	return data;
+}
+
+TEST(AllocationTest, DecoratedWritesDoNotAllocateOnceWarm)
+{
+	auto data = MakeData(4096);
+	auto sink = std::make_unique<CountingOutputStream>();
+	auto* counter = sink.get();
+	IOutputStreamPtr stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(sink), 3);
+	stream = std::make_unique<PackingOutputStreamDecorator>(std::move(stream));
+	stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 7);
+
+	// Scratch buffers grow to the largest block they have seen, so warm up first.
+	for (int i = 0; i < 10; ++i)
+	{
+		stream->WriteBlock(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	{
+		AllocationCounter allocations;
+		for (int i = 0; i < 100; ++i)
+		{
+			stream->WriteBlock(data.data(), static_cast<std::streamsize>(data.size()));
+			stream->WriteBlock(data.data(), 100);
+		}
+		EXPECT_EQ(allocations.GetCount(), 0u);
+	}
+
+	stream->Close();
+	EXPECT_GT(counter->GetSize(), 0);
+}
+
+TEST(AllocationTest, DecoratedReadsDoNotAllocate)
+{
+	auto data = MakeData(1 << 16);
+	IInputStreamPtr stream = std::make_unique<MemoryInputStream>(data.data(), static_cast<std::streamsize>(data.size()));
+	stream = std::make_unique<DecodingInputStreamDecorator>(std::move(stream), 3);
+	stream = std::make_unique<UnpackingInputStreamDecorator>(std::move(stream));
+	stream = std::make_unique<DecodingInputStreamDecorator>(std::move(stream), 7);
+
+	std::vector<uint8_t> buffer(4096);
+	std::streamsize total = 0;
+	{
+		AllocationCounter allocations;
+		while (!stream->IsEOF())
+		{
+			total += stream->ReadBlock(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		}
+		EXPECT_EQ(allocations.GetCount(), 0u);
+	}
+	EXPECT_GT(total, 0);
+}
+
+} // namespace allocation_tests
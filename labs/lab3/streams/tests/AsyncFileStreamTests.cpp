@@ -0,0 +1,133 @@
+#include "../src/lib/AsyncFileStream.h"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+
+namespace async_file_stream_tests
+{
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 7 + i / 1000);
+	}
+	return data;
+}
+
+void WriteFile(const std::string& fileName, const std::vector<uint8_t>& data)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+std::vector<uint8_t> ReadFile(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST(AsyncFileInputStreamTest, ReadsAcrossManySmallBlocks)
+{
+	auto data = MakeData(100000);
+	WriteFile("async_input.bin", data);
+
+	std::vector<uint8_t> result(data.size());
+	{
+		AsyncFileInputStream stream("async_input.bin", 1000, 3);
+		size_t position = 0;
+		for (size_t step = 0; !stream.IsEOF(); ++step)
+		{
+			if (step % 3 == 0)
+			{
+				result[position++] = stream.ReadByte();
+				continue;
+			}
+			std::streamsize size = std::min<std::streamsize>(step * 13 % 2500, result.size() - position);
+			position += stream.ReadBlock(result.data() + position, size);
+		}
+		EXPECT_EQ(position, data.size());
+		EXPECT_EQ(stream.ReadBlock(result.data(), 10), 0);
+		EXPECT_THROW(stream.ReadByte(), std::runtime_error);
+	}
+
+	EXPECT_EQ(result, data);
+	std::remove("async_input.bin");
+}
+
+TEST(AsyncFileInputStreamTest, EmptyFile)
+{
+	WriteFile("async_empty.bin", {});
+	AsyncFileInputStream stream("async_empty.bin");
+
+	EXPECT_TRUE(stream.IsEOF());
+	EXPECT_THROW(stream.ReadByte(), std::runtime_error);
+	std::remove("async_empty.bin");
+}
+
+TEST(AsyncFileInputStreamTest, StopsWithUnreadBlocks)
+{
+	WriteFile("async_unread.bin", MakeData(50000));
+	{
+		AsyncFileInputStream stream("async_unread.bin", 100, 2);
+		EXPECT_EQ(stream.ReadByte(), 0);
+	}
+	std::remove("async_unread.bin");
+}
+
+TEST(AsyncFileInputStreamTest, MissingFile)
+{
+	EXPECT_THROW(AsyncFileInputStream("async_missing.bin"), std::runtime_error);
+}
+
+TEST(AsyncFileInputStreamTest, ReadErrorIsSticky)
+{
+	// A directory opens for reading, but pread from it fails.
+	AsyncFileInputStream stream(".", 1000, 2);
+	EXPECT_THROW(stream.ReadByte(), std::runtime_error);
+	EXPECT_THROW(stream.ReadByte(), std::runtime_error);
+	uint8_t buffer[10];
+	EXPECT_THROW(stream.ReadBlock(buffer, sizeof(buffer)), std::runtime_error);
+	EXPECT_THROW(stream.IsEOF(), std::runtime_error);
+}
+
+TEST(AsyncFileOutputStreamTest, WritesAcrossBufferSwaps)
+{
+	auto data = MakeData(100000);
+	{
+		AsyncFileOutputStream stream("async_output.bin", 1000);
+		size_t position = 0;
+		for (size_t step = 0; position < data.size(); ++step)
+		{
+			if (step % 3 == 0)
+			{
+				stream.WriteByte(data[position++]);
+				continue;
+			}
+			size_t size = std::min(step * 13 % 2500, data.size() - position);
+			stream.WriteBlock(data.data() + position, static_cast<std::streamsize>(size));
+			position += size;
+		}
+		stream.Close();
+		EXPECT_THROW(stream.WriteByte(0x01), std::runtime_error);
+	}
+
+	EXPECT_EQ(ReadFile("async_output.bin"), data);
+	std::remove("async_output.bin");
+}
+
+TEST(AsyncFileOutputStreamTest, DestructorFlushes)
+{
+	auto data = MakeData(3000);
+	{
+		AsyncFileOutputStream stream("async_flush.bin", 1024);
+		stream.WriteBlock(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+
+	EXPECT_EQ(ReadFile("async_flush.bin"), data);
+	std::remove("async_flush.bin");
+}
+
+} // namespace async_file_stream_tests
@@ -58,6 +58,112 @@ TEST(EncryptionTest, DoubleEncryptDoubleDecrypt)
 	EXPECT_EQ(original, decrypted1);
 }
 
+namespace
+{
+std::vector<uint8_t> MakeReferenceEncodeTable(int key)
+{
+	std::vector<uint8_t> table(256);
+	for (int i = 0; i < 256; ++i)
+	{
+		table[i] = static_cast<uint8_t>(i);
+	}
+	std::mt19937 gen(key);
+	std::shuffle(table.begin(), table.end(), gen);
+	return table;
+}
+
+std::vector<uint8_t> MakeRandomData(size_t size)
+{
+	std::mt19937 gen(42);
+	std::vector<uint8_t> data(size);
+	for (auto& byte : data)
+	{
+		byte = static_cast<uint8_t>(gen());
+	}
+	return data;
+}
+} // namespace
+
+TEST(EncryptionTest, BlockMatchesReferenceTables)
+{
+	for (int key : { 0, 1, 999, -12345 })
+	{
+		auto encodeTable = MakeReferenceEncodeTable(key);
+		std::vector<uint8_t> decodeTable(256);
+		for (int i = 0; i < 256; ++i)
+		{
+			decodeTable[encodeTable[i]] = static_cast<uint8_t>(i);
+		}
+
+		EncodingDataProcessor encoder(key);
+		DecodingDataProcessor decoder(key);
+
+		for (size_t size : { 0, 1, 15, 16, 31, 32, 33, 255, 4096, 4101 })
+		{
+			auto original = MakeRandomData(size);
+			auto encoded = original;
+			auto decoded = original;
+
+			encoder.ProcessDataBlock(encoded.data(), encoded.size());
+			decoder.ProcessDataBlock(decoded.data(), decoded.size());
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				ASSERT_EQ(encoded[i], encodeTable[original[i]]) << "key " << key << " offset " << i;
+				ASSERT_EQ(decoded[i], decodeTable[original[i]]) << "key " << key << " offset " << i;
+			}
+		}
+	}
+}
+
+TEST(EncryptionTest, KernelsAreBitExact)
+{
+	SubstitutionTable table;
+	auto reference = MakeReferenceEncodeTable(2024);
+	std::copy(reference.begin(), reference.end(), table.begin());
+
+	std::vector<uint8_t> original(1027);
+	for (size_t i = 0; i < original.size(); ++i)
+	{
+		original[i] = static_cast<uint8_t>(i);
+	}
+
+	auto expected = original;
+	ByteSubstitution::ApplyScalar(table, expected.data(), expected.data(), expected.size());
+	for (size_t i = 0; i < original.size(); ++i)
+	{
+		ASSERT_EQ(expected[i], reference[original[i]]);
+	}
+
+#ifdef BYTE_SUBSTITUTION_X86
+	if (ByteSubstitution::IsAvx2Supported())
+	{
+		std::vector<uint8_t> actual(original.size());
+		ByteSubstitution::ApplyAvx2(table, original.data() + 1, actual.data() + 1, actual.size() - 1);
+		ByteSubstitution::ApplyScalar(table, original.data(), actual.data(), 1);
+		EXPECT_EQ(actual, expected);
+	}
+#endif
+}
+
+TEST(EncryptionTest, TransformBlockLeavesSourceIntact)
+{
+	EncodingDataProcessor encoder(5);
+	std::vector<uint8_t> source(300);
+	for (size_t i = 0; i < source.size(); ++i)
+	{
+		source[i] = static_cast<uint8_t>(i * 7);
+	}
+	const auto original = source;
+
+	std::vector<uint8_t> transformed(source.size());
+	EXPECT_EQ(encoder.TransformBlock(source, transformed), static_cast<std::streamsize>(source.size()));
+	EXPECT_EQ(source, original);
+
+	encoder.ProcessDataBlock(source.data(), static_cast<std::streamsize>(source.size()));
+	EXPECT_EQ(transformed, source);
+}
+
 TEST(CompressionTest, SameCompressionForSameData)
 {
 	PackingDataProcessor packer;
@@ -0,0 +1,78 @@
+#include "../src/lib/FileTransformer.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace file_transformer_tests
+{
+
+class TransformTest : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		std::filesystem::create_directory("transform_files");
+		std::ofstream file("transform_files/input.bin", std::ios::binary);
+		file << "AAAABBBBCCCC";
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove_all("transform_files");
+	}
+
+	void Transform(std::vector<std::string> arguments)
+	{
+		arguments.insert(arguments.begin(), "transform");
+		std::vector<char*> args;
+		for (auto& argument : arguments)
+		{
+			args.push_back(argument.data());
+		}
+		FileTransformer().Transform(static_cast<int>(args.size()), args.data());
+	}
+};
+
+TEST_F(TransformTest, ClosesOutputBeforeReturning)
+{
+	Transform({ "--compress-chunked", "transform_files/input.bin", "transform_files/output.bin" });
+
+	std::ifstream file("transform_files/output.bin", std::ios::binary);
+	std::vector<uint8_t> packed((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(12u, RleContainerView(packed).Size());
+}
+
+TEST_F(TransformTest, MappedDecryptionRestoresInput)
+{
+	Transform({ "--encrypt", "5", "--encrypt", "9", "transform_files/input.bin", "transform_files/encrypted.bin" });
+	Transform({ "--mmap", "--decrypt", "5", "--decrypt", "9", "transform_files/encrypted.bin", "transform_files/output.bin" });
+
+	std::ifstream file("transform_files/output.bin", std::ios::binary);
+	std::string result((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	EXPECT_EQ("AAAABBBBCCCC", result);
+}
+
+TEST_F(TransformTest, StagedPipelineRestoresInput)
+{
+	Transform({ "--pipeline", "--compress", "--encrypt", "5", "--encrypt", "9", "transform_files/input.bin", "transform_files/packed.bin" });
+	Transform({ "--pipeline", "--decompress", "--decrypt", "5", "--decrypt", "9", "transform_files/packed.bin", "transform_files/output.bin" });
+
+	std::ifstream file("transform_files/output.bin", std::ios::binary);
+	std::string result((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	EXPECT_EQ("AAAABBBBCCCC", result);
+}
+
+TEST_F(TransformTest, ReportsErrorsOfFinalFlush)
+{
+	if (!std::filesystem::exists("/dev/full"))
+	{
+		GTEST_SKIP() << "/dev/full is not available";
+	}
+	EXPECT_THROW(Transform({ "transform_files/input.bin", "/dev/full" }), std::runtime_error);
+	EXPECT_THROW(Transform({ "--compress", "transform_files/input.bin", "/dev/full" }), std::runtime_error);
+	EXPECT_THROW(Transform({ "--async", "transform_files/input.bin", "/dev/full" }), std::runtime_error);
+	EXPECT_THROW(Transform({ "--pipeline", "--compress-chunked", "transform_files/input.bin", "/dev/full" }), std::runtime_error);
+	EXPECT_THROW(Transform({ "--pipeline", "--compress", "--encrypt", "3", "transform_files/input.bin", "/dev/full" }), std::runtime_error);
+}
+
+} // namespace file_transformer_tests
@@ -1,6 +1,7 @@
 #include "../src/lib/InputStream.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 class MockInputStream : public IInputStream
 {
@@ -81,6 +82,28 @@ TEST(MemoryInputStreamTest, ReadMoreThanAvailable)
 	EXPECT_TRUE(stream.IsEOF());
 }
 
+TEST(MemoryInputStreamTest, SeekAndReadAt)
+{
+	const uint8_t data[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+	MemoryInputStream stream(data, 5);
+
+	EXPECT_EQ(stream.Size(), 5);
+	stream.Seek(3);
+	EXPECT_EQ(stream.ReadByte(), 0x04);
+
+	uint8_t buffer[4] = { 0 };
+	EXPECT_EQ(stream.ReadAt(1, buffer), 4);
+	EXPECT_EQ(buffer[0], 0x02);
+	EXPECT_EQ(buffer[3], 0x05);
+	EXPECT_EQ(stream.ReadAt(5, buffer), 0);
+
+	EXPECT_EQ(stream.ReadByte(), 0x05);
+	EXPECT_TRUE(stream.IsEOF());
+	stream.Seek(0);
+	EXPECT_EQ(stream.ReadByte(), 0x01);
+	EXPECT_THROW(stream.Seek(6), std::runtime_error);
+}
+
 TEST(FileInputStreamTest, EmptyFile)
 {
 	auto file = std::make_unique<std::ifstream>();
@@ -161,3 +184,178 @@ TEST(FileInputStreamTest, ReadMoreThanAvailable)
 	stream.Close();
 	std::remove("more_bytes_test_file.bin");
 }
+
+TEST(FileInputStreamTest, MixedReadsAcrossBufferWindows)
+{
+	std::vector<uint8_t> data(50000);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 31 + i / 256);
+	}
+
+	std::ofstream outFile("window_test_file.bin", std::ios::binary);
+	outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+	outFile.close();
+
+	auto file = std::make_unique<std::ifstream>("window_test_file.bin", std::ios::binary);
+	FileInputStream stream(std::move(file));
+
+	std::vector<uint8_t> result(data.size());
+	size_t position = 0;
+	const std::streamsize blockSizes[] = { 1, 100, 20000, 7, 16384 };
+	for (size_t step = 0; !stream.IsEOF(); ++step)
+	{
+		if (step % 2 == 0)
+		{
+			result[position++] = stream.ReadByte();
+			continue;
+		}
+		std::streamsize size = std::min<std::streamsize>(blockSizes[step % 5], result.size() - position);
+		position += stream.ReadBlock(result.data() + position, size);
+	}
+
+	EXPECT_EQ(position, data.size());
+	EXPECT_EQ(result, data);
+	EXPECT_THROW(stream.ReadByte(), std::runtime_error);
+
+	stream.Close();
+	std::remove("window_test_file.bin");
+}
+
+TEST(FileInputStreamTest, SeekAndReadAtAroundBufferedReads)
+{
+	std::vector<uint8_t> data(40000);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 3 + i / 256);
+	}
+
+	std::ofstream outFile("seek_test_file.bin", std::ios::binary);
+	outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+	outFile.close();
+
+	auto file = std::make_unique<std::ifstream>("seek_test_file.bin", std::ios::binary);
+	FileInputStream stream(std::move(file));
+	EXPECT_EQ(stream.Size(), 40000);
+
+	EXPECT_EQ(stream.ReadByte(), data[0]);
+	std::vector<uint8_t> buffer(1000);
+	EXPECT_EQ(stream.ReadAt(30000, buffer), 1000);
+	EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), data.begin() + 30000));
+	EXPECT_EQ(stream.ReadByte(), data[1]);
+
+	// Reading past the window continues where the window ended, not where
+	// ReadAt stopped.
+	std::vector<uint8_t> next(20000);
+	EXPECT_EQ(stream.ReadBlock(next.data(), 20000), 20000);
+	EXPECT_TRUE(std::equal(next.begin(), next.end(), data.begin() + 2));
+	EXPECT_EQ(stream.ReadAt(0, buffer), 1000);
+	EXPECT_EQ(stream.ReadByte(), data[20002]);
+
+	stream.Seek(39999);
+	EXPECT_EQ(stream.ReadByte(), data[39999]);
+	EXPECT_TRUE(stream.IsEOF());
+	EXPECT_EQ(stream.ReadAt(39500, buffer), 500);
+	EXPECT_TRUE(std::equal(buffer.begin(), buffer.begin() + 500, data.begin() + 39500));
+
+	stream.Seek(20000);
+	std::vector<uint8_t> rest(20000);
+	EXPECT_EQ(stream.ReadBlock(rest.data(), 20000), 20000);
+	EXPECT_TRUE(std::equal(rest.begin(), rest.end(), data.begin() + 20000));
+
+	stream.Close();
+	std::remove("seek_test_file.bin");
+}
+
+TEST(FileInputStreamTest, ConcurrentReadAt)
+{
+	std::vector<uint8_t> data(64000);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i / 250);
+	}
+
+	std::ofstream outFile("concurrent_test_file.bin", std::ios::binary);
+	outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+	outFile.close();
+
+	FileInputStream stream(std::make_unique<std::ifstream>("concurrent_test_file.bin", std::ios::binary));
+	std::vector<uint8_t> result(data.size());
+	std::vector<std::thread> threads;
+	for (size_t part = 0; part < 4; ++part)
+	{
+		threads.emplace_back([&, part] {
+			for (size_t offset = part * 1000; offset < result.size(); offset += 4000)
+			{
+				stream.ReadAt(static_cast<std::streamsize>(offset), std::span(result).subspan(offset, 1000));
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(result, data);
+	std::remove("concurrent_test_file.bin");
+}
+
+TEST(MappedFileInputStreamTest, EmptyFile)
+{
+	std::ofstream("empty_mapped_test_file.bin", std::ios::binary).close();
+
+	MappedFileInputStream stream("empty_mapped_test_file.bin");
+
+	uint8_t buffer[3] = { 0xFF, 0xFF, 0xFF };
+	EXPECT_TRUE(stream.IsEOF());
+	EXPECT_EQ(stream.ReadBlock(buffer, 3), 0);
+	EXPECT_EQ(buffer[0], 0xFF);
+	EXPECT_THROW(stream.ReadByte(), std::runtime_error);
+
+	stream.Close();
+	std::remove("empty_mapped_test_file.bin");
+}
+
+TEST(MappedFileInputStreamTest, ReadAndBorrow)
+{
+	const uint8_t data[] = { 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+	std::ofstream outFile("mapped_test_file.bin", std::ios::binary);
+	outFile.write(reinterpret_cast<const char*>(data), 5);
+	outFile.close();
+
+	MappedFileInputStream stream("mapped_test_file.bin");
+
+	EXPECT_EQ(stream.ReadByte(), 0x11);
+
+	uint8_t buffer[2] = { 0 };
+	EXPECT_EQ(stream.ReadBlock(buffer, 2), 2);
+	EXPECT_EQ(buffer[0], 0x22);
+	EXPECT_EQ(buffer[1], 0x33);
+
+	EXPECT_EQ(stream.Size(), 5);
+	EXPECT_EQ(stream.ReadAt(3, buffer), 2);
+	EXPECT_EQ(buffer[0], 0x44);
+
+	auto block = stream.BorrowBlock(10);
+	ASSERT_EQ(block.size(), 2);
+	EXPECT_EQ(block[0], 0x44);
+	EXPECT_EQ(block[1], 0x55);
+	EXPECT_TRUE(stream.IsEOF());
+
+	stream.Seek(1);
+	EXPECT_EQ(stream.ReadByte(), 0x22);
+
+	stream.Close();
+
+	std::ifstream inFile("mapped_test_file.bin", std::ios::binary);
+	inFile.seekg(3);
+	EXPECT_EQ(inFile.get(), 0x44);
+	inFile.close();
+	std::remove("mapped_test_file.bin");
+}
+
+TEST(MappedFileInputStreamTest, MissingFile)
+{
+	EXPECT_THROW(MappedFileInputStream("missing_mapped_test_file.bin"), std::runtime_error);
+}
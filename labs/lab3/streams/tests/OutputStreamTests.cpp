@@ -89,6 +89,44 @@ TEST(FileOutputStreamTest, WriteBlockPartial)
 	std::remove("test_write_partial.bin");
 }
 
+TEST(FileOutputStreamTest, MixedWritesAcrossBufferWindows)
+{
+	std::vector<uint8_t> data(50000);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 13 + i / 512);
+	}
+
+	{
+		auto file = std::make_unique<std::ofstream>("test_write_window.bin", std::ios::binary);
+		FileOutputStream stream(std::move(file));
+
+		size_t position = 0;
+		const size_t blockSizes[] = { 1, 16383, 20000, 5 };
+		for (size_t step = 0; position < data.size(); ++step)
+		{
+			size_t size = std::min(blockSizes[step % 4], data.size() - position);
+			if (size == 1)
+			{
+				stream.WriteByte(data[position]);
+			}
+			else
+			{
+				stream.WriteBlock(data.data() + position, static_cast<std::streamsize>(size));
+			}
+			position += size;
+		}
+		// Destroyed without Close: the buffered tail must still reach the file.
+	}
+
+	std::ifstream inFile("test_write_window.bin", std::ios::binary);
+	std::vector<uint8_t> result((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+	inFile.close();
+
+	EXPECT_EQ(result, data);
+	std::remove("test_write_window.bin");
+}
+
 TEST(MemoryOutputStreamTest, WriteByte)
 {
 	MemoryOutputStream stream;
@@ -135,3 +173,78 @@ TEST(MemoryOutputStreamTest, WriteBlockPartial)
 	EXPECT_EQ(result[0], 0x99);
 	EXPECT_EQ(result[1], 0x88);
 }
+
+TEST(MappedFileOutputStreamTest, WriteByteAndBlock)
+{
+	MappedFileOutputStream stream("test_mapped_write.bin");
+
+	const uint8_t data[] = { 0x02, 0x03, 0x04 };
+	stream.WriteByte(0x01);
+	stream.WriteBlock(data, 3);
+	stream.Close();
+
+	std::ifstream inFile("test_mapped_write.bin", std::ios::binary | std::ios::ate);
+	EXPECT_EQ(inFile.tellg(), 4);
+	inFile.seekg(0);
+	uint8_t result[4];
+	inFile.read(reinterpret_cast<char*>(result), 4);
+	inFile.close();
+
+	EXPECT_EQ(result[0], 0x01);
+	EXPECT_EQ(result[1], 0x02);
+	EXPECT_EQ(result[2], 0x03);
+	EXPECT_EQ(result[3], 0x04);
+	std::remove("test_mapped_write.bin");
+}
+
+TEST(MappedFileOutputStreamTest, GrowsBeyondInitialMapping)
+{
+	std::vector<uint8_t> data((3 << 20) + 7);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 31);
+	}
+
+	MappedFileOutputStream stream("test_mapped_grow.bin");
+	stream.WriteBlock(data.data(), 5);
+	stream.WriteBlock(data.data() + 5, static_cast<std::streamsize>(data.size() - 5));
+	stream.Close();
+
+	std::ifstream inFile("test_mapped_grow.bin", std::ios::binary);
+	std::vector<uint8_t> result(data.size() + 1);
+	inFile.read(reinterpret_cast<char*>(result.data()), static_cast<std::streamsize>(result.size()));
+	EXPECT_EQ(inFile.gcount(), static_cast<std::streamsize>(data.size()));
+	inFile.close();
+
+	result.resize(data.size());
+	EXPECT_EQ(result, data);
+	std::remove("test_mapped_grow.bin");
+}
+
+TEST(MappedFileOutputStreamTest, ReservesWithinExpectedSize)
+{
+	MappedFileOutputStream stream("test_mapped_reserve.bin", 10);
+
+	auto block = stream.Reserve(16);
+	ASSERT_EQ(block.size(), 10u);
+	std::fill(block.begin(), block.end(), 0x5A);
+	stream.Commit(6);
+	EXPECT_EQ(stream.Reserve(16).size(), 4u);
+	stream.Commit(0);
+	stream.Close();
+
+	std::ifstream inFile("test_mapped_reserve.bin", std::ios::binary);
+	std::vector<uint8_t> result((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+	inFile.close();
+	EXPECT_EQ(result, std::vector<uint8_t>(6, 0x5A));
+	std::remove("test_mapped_reserve.bin");
+}
+
+TEST(MappedFileOutputStreamTest, WriteClosed)
+{
+	MappedFileOutputStream stream("test_mapped_closed.bin");
+	stream.Close();
+
+	EXPECT_THROW(stream.WriteByte(0xAA), std::runtime_error);
+	std::remove("test_mapped_closed.bin");
+}
@@ -0,0 +1,225 @@
+#include "../src/lib/PipelinedTransfer.h"
+#include "../src/lib/SpscQueue.h"
+#include "../src/lib/StreamDecorator.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace pipelined_transfer_tests
+{
+
+class FailingInputStream : public IInputStream
+{
+public:
+	bool IsEOF() override
+	{
+		return false;
+	}
+
+	uint8_t ReadByte() override
+	{
+		throw std::runtime_error("ReadByte failed");
+	}
+
+	std::streamsize ReadBlock(void*, std::streamsize) override
+	{
+		throw std::runtime_error("ReadBlock failed");
+	}
+};
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		data[i] = static_cast<uint8_t>(i % 7 == 0 ? 0xFF : i / 300);
+	}
+	return data;
+}
+
+TEST(SpscQueueTest, RespectsCapacity)
+{
+	SpscQueue<int, 4> queue;
+	for (int i = 0; i < 4; ++i)
+	{
+		EXPECT_TRUE(queue.TryPush(i));
+	}
+	EXPECT_FALSE(queue.TryPush(4));
+
+	int value;
+	EXPECT_TRUE(queue.TryPop(value));
+	EXPECT_EQ(value, 0);
+	EXPECT_TRUE(queue.TryPush(4));
+}
+
+TEST(SpscQueueTest, PreservesOrderAcrossThreads)
+{
+	SpscQueue<int, 8> queue;
+	constexpr int count = 100000;
+
+	std::thread producer([&] {
+		for (int i = 0; i < count; ++i)
+		{
+			while (!queue.TryPush(i))
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	int value = -1;
+	for (int expected = 0; expected < count; ++expected)
+	{
+		while (!queue.TryPop(value))
+		{
+			std::this_thread::yield();
+		}
+		ASSERT_EQ(value, expected);
+	}
+	producer.join();
+}
+
+TEST(SpscQueueTest, BlockingPopWaitsForPush)
+{
+	SpscQueue<int, 2> queue;
+	constexpr int count = 100000;
+
+	std::thread producer([&] {
+		for (int i = 0; i < count; ++i)
+		{
+			ASSERT_TRUE(queue.Push(i));
+		}
+	});
+
+	int value = -1;
+	for (int expected = 0; expected < count; ++expected)
+	{
+		ASSERT_TRUE(queue.Pop(value));
+		ASSERT_EQ(value, expected);
+	}
+	producer.join();
+}
+
+TEST(SpscQueueTest, CloseWakesBlockedPop)
+{
+	SpscQueue<int, 2> queue;
+	bool popped = true;
+
+	std::thread consumer([&] {
+		int value;
+		popped = queue.Pop(value);
+	});
+	queue.Close();
+	consumer.join();
+
+	EXPECT_FALSE(popped);
+	EXPECT_FALSE(queue.Push(1));
+}
+
+TEST(PipelinedTransferTest, MatchesSerialTransfer)
+{
+	auto original = MakeData(100000);
+
+	auto memoryOutput = std::make_unique<MemoryOutputStream>();
+	auto* packed = memoryOutput.get();
+	PackingOutputStreamDecorator output(std::move(memoryOutput));
+	MemoryInputStream source(original.data(), original.size());
+	PipelinedTransfer().Run(source, output);
+	output.Close();
+
+	MemoryOutputStream result;
+	UnpackingInputStreamDecorator input(
+		std::make_unique<MemoryInputStream>(packed->GetData().data(), packed->GetData().size()));
+	PipelinedTransfer().Run(input, result);
+
+	EXPECT_EQ(result.GetData(), original);
+}
+
+TEST(PipelinedTransferTest, ReaderErrorIsRethrown)
+{
+	FailingInputStream input;
+	MemoryOutputStream output;
+
+	EXPECT_THROW(PipelinedTransfer().Run(input, output), std::runtime_error);
+}
+
+TEST(PipelinedTransferTest, WriterErrorStopsReader)
+{
+	auto original = MakeData(1000000);
+	MemoryInputStream input(original.data(), original.size());
+	MemoryOutputStream output;
+	output.Close();
+
+	EXPECT_THROW(PipelinedTransfer().Run(input, output), std::runtime_error);
+}
+
+TEST(PipelinedStreamTest, StagedChainMatchesSerialChain)
+{
+	auto original = MakeData(1000000);
+
+	MemoryOutputStream serial;
+	{
+		IOutputStreamPtr stream = std::make_unique<MemoryOutputStream>();
+		auto* sink = static_cast<MemoryOutputStream*>(stream.get());
+		stream = std::make_unique<PackingOutputStreamDecorator>(std::move(stream));
+		stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 3);
+		stream->WriteBlock(original.data(), static_cast<std::streamsize>(original.size()));
+		stream->Close();
+		serial.WriteBlock(sink->GetData().data(), static_cast<std::streamsize>(sink->GetData().size()));
+	}
+
+	IOutputStreamPtr stream = std::make_unique<MemoryOutputStream>();
+	auto* sink = static_cast<MemoryOutputStream*>(stream.get());
+	stream = std::make_unique<PipelinedOutputStream>(std::move(stream));
+	stream = std::make_unique<PackingOutputStreamDecorator>(std::move(stream));
+	stream = std::make_unique<PipelinedOutputStream>(std::move(stream));
+	stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 3);
+	for (size_t offset = 0; offset < original.size(); offset += 1000)
+	{
+		stream->WriteBlock(original.data() + offset, 1000);
+	}
+	stream->Close();
+	ASSERT_EQ(sink->GetData(), serial.GetData());
+
+	IInputStreamPtr input = std::make_unique<MemoryInputStream>(sink->GetData().data(), sink->GetData().size());
+	input = std::make_unique<PipelinedInputStream>(std::move(input));
+	input = std::make_unique<UnpackingInputStreamDecorator>(std::move(input));
+	input = std::make_unique<PipelinedInputStream>(std::move(input));
+	input = std::make_unique<DecodingInputStreamDecorator>(std::move(input), 3);
+	MemoryOutputStream result;
+	PipelinedTransfer().Run(*input, result);
+
+	EXPECT_EQ(result.GetData(), original);
+}
+
+TEST(PipelinedStreamTest, WorkerWriteErrorIsRethrown)
+{
+	auto original = MakeData(1000000);
+	auto sink = std::make_unique<MemoryOutputStream>();
+	sink->Close();
+	PipelinedOutputStream stream(std::move(sink));
+
+	auto writeAndClose = [&] {
+		stream.WriteBlock(original.data(), static_cast<std::streamsize>(original.size()));
+		stream.Close();
+	};
+	EXPECT_THROW(writeAndClose(), std::runtime_error);
+}
+
+TEST(PipelinedStreamTest, WorkerReadErrorIsRethrown)
+{
+	PipelinedInputStream stream(std::make_unique<FailingInputStream>());
+	uint8_t buffer[16];
+
+	EXPECT_THROW(stream.ReadBlock(buffer, sizeof(buffer)), std::runtime_error);
+}
+
+TEST(PipelinedStreamTest, UnreadInputIsAbandoned)
+{
+	auto original = MakeData(1000000);
+	PipelinedInputStream stream(std::make_unique<MemoryInputStream>(original.data(), original.size()));
+
+	EXPECT_EQ(stream.ReadByte(), original[0]);
+}
+
+} // namespace pipelined_transfer_tests
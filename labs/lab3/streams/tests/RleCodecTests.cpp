@@ -0,0 +1,116 @@
+#include "../src/lib/RleCodec.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+std::vector<uint8_t> Encode(const std::vector<uint8_t>& data, size_t inputChunk, size_t outputChunk)
+{
+	RleEncoder encoder;
+	std::vector<uint8_t> result;
+	std::vector<uint8_t> buffer(outputChunk);
+
+	for (size_t offset = 0; offset < data.size(); offset += inputChunk)
+	{
+		std::span<const uint8_t> input(data.data() + offset, std::min(inputChunk, data.size() - offset));
+		while (!input.empty())
+		{
+			std::span<uint8_t> output(buffer);
+			encoder.Encode(input, output);
+			result.insert(result.end(), buffer.begin(), buffer.end() - output.size());
+		}
+	}
+
+	bool finished = false;
+	while (!finished)
+	{
+		std::span<uint8_t> output(buffer);
+		finished = encoder.Finish(output);
+		result.insert(result.end(), buffer.begin(), buffer.end() - output.size());
+	}
+	return result;
+}
+
+std::vector<uint8_t> Decode(const std::vector<uint8_t>& data, size_t inputChunk, size_t outputChunk)
+{
+	RleDecoder decoder;
+	std::vector<uint8_t> result;
+	std::vector<uint8_t> buffer(outputChunk);
+
+	for (size_t offset = 0; offset < data.size(); offset += inputChunk)
+	{
+		std::span<const uint8_t> input(data.data() + offset, std::min(inputChunk, data.size() - offset));
+		while (!input.empty() || decoder.HasPendingOutput())
+		{
+			std::span<uint8_t> output(buffer);
+			decoder.Decode(input, output);
+			if (output.size() == buffer.size())
+			{
+				break;
+			}
+			result.insert(result.end(), buffer.begin(), buffer.end() - output.size());
+		}
+	}
+
+	while (decoder.HasPendingOutput())
+	{
+		std::span<uint8_t> output(buffer);
+		decoder.Finish(output);
+		result.insert(result.end(), buffer.begin(), buffer.end() - output.size());
+	}
+	return result;
+}
+
+std::vector<uint8_t> MakeRunData(size_t size)
+{
+	std::mt19937 gen(7);
+	std::vector<uint8_t> data;
+	while (data.size() < size)
+	{
+		uint8_t value = gen() % 4 == 0 ? 0xFF : static_cast<uint8_t>(gen());
+		size_t length = 1 + gen() % 600;
+		data.insert(data.end(), std::min(length, size - data.size()), value);
+	}
+	return data;
+}
+} // namespace
+
+TEST(RleCodecTest, EncodesRunsAndEscapesMarker)
+{
+	std::vector<uint8_t> data = { 0x11, 0x11, 0x11, 0x22, 0x22, 0x22, 0x22, 0xFF, 0x33 };
+	std::vector<uint8_t> expected = { 0x11, 0x11, 0x11, 0xFF, 0x22, 0x04, 0xFF, 0xFF, 0x01, 0x33 };
+
+	EXPECT_EQ(Encode(data, data.size(), 64), expected);
+}
+
+TEST(RleCodecTest, RunsContinueAcrossBlockBoundaries)
+{
+	std::vector<uint8_t> data(1000, 0xAB);
+	std::vector<uint8_t> expected = {
+		0xFF, 0xAB, 0xFF, 0xFF, 0xAB, 0xFF, 0xFF, 0xAB, 0xFF, 0xFF, 0xAB, 0xEB
+	};
+
+	EXPECT_EQ(Encode(data, 1000, 64), expected);
+	EXPECT_EQ(Encode(data, 7, 64), expected);
+	EXPECT_EQ(Encode(data, 1, 1), expected);
+}
+
+TEST(RleCodecTest, RoundTripWithBoundedBuffers)
+{
+	auto data = MakeRunData(100000);
+	auto reference = Encode(data, data.size(), 4096);
+
+	for (size_t chunk : { 1, 2, 3, 5, 4096 })
+	{
+		EXPECT_EQ(Encode(data, chunk, chunk), reference);
+		EXPECT_EQ(Decode(reference, chunk, chunk), data);
+	}
+}
+
+TEST(RleCodecTest, TruncatedMarkerIsKeptAsLiteral)
+{
+	EXPECT_EQ(Decode({ 0x01, 0xFF }, 16, 16), std::vector<uint8_t>({ 0x01, 0xFF }));
+	EXPECT_EQ(Decode({ 0x01, 0xFF, 0x02 }, 1, 1), std::vector<uint8_t>({ 0x01, 0xFF, 0x02 }));
+}
@@ -0,0 +1,212 @@
+#include "../src/lib/RleContainer.h"
+#include <fstream>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace rle_container_tests
+{
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		data[i] = static_cast<uint8_t>(i % 11 == 0 ? 0xFF : i / 50);
+	}
+	return data;
+}
+
+std::vector<uint8_t> Pack(const std::vector<uint8_t>& data, uint32_t chunkSize)
+{
+	auto memoryOutput = std::make_unique<MemoryOutputStream>();
+	auto* packed = memoryOutput.get();
+	ChunkedPackingOutputStreamDecorator packer(std::move(memoryOutput), chunkSize);
+	for (size_t offset = 0; offset < data.size(); offset += 1000)
+	{
+		packer.WriteBlock(data.data() + offset, std::min<std::streamsize>(1000, data.size() - offset));
+	}
+	packer.Close();
+	return packed->GetData();
+}
+
+std::vector<uint8_t> Unpack(const std::vector<uint8_t>& packed)
+{
+	ChunkedUnpackingInputStreamDecorator unpacker(std::make_unique<MemoryInputStream>(packed.data(), packed.size()));
+	std::vector<uint8_t> result;
+	std::vector<uint8_t> buffer(777);
+	while (!unpacker.IsEOF())
+	{
+		std::streamsize bytesRead = unpacker.ReadBlock(buffer.data(), buffer.size());
+		result.insert(result.end(), buffer.begin(), buffer.begin() + bytesRead);
+	}
+	return result;
+}
+
+TEST(RleContainerTest, RoundTrip)
+{
+	for (size_t size : { 0, 1, 4096, 4097, 50000 })
+	{
+		auto data = MakeData(size);
+		auto packed = Pack(data, 4096);
+
+		EXPECT_EQ(Unpack(packed), data);
+		EXPECT_EQ(RleContainerView(packed).UnpackAll(), data);
+	}
+}
+
+TEST(RleContainerTest, StartsWithVersionedHeader)
+{
+	auto packed = Pack(MakeData(10), 4096);
+
+	ASSERT_GE(packed.size(), RleContainerFormat::k_headerSize);
+	EXPECT_EQ(std::string(packed.begin(), packed.begin() + 4), "RLEC");
+	EXPECT_EQ(packed[4], RleContainerFormat::k_version);
+}
+
+TEST(RleContainerTest, ReadAtUsesIndex)
+{
+	auto data = MakeData(50000);
+	auto packed = Pack(data, 1024);
+	RleContainerView view(packed);
+
+	EXPECT_EQ(view.Size(), data.size());
+
+	std::vector<uint8_t> buffer(3000);
+	EXPECT_EQ(view.ReadAt(12345, buffer), buffer.size());
+	EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), data.begin() + 12345));
+
+	EXPECT_EQ(view.ReadAt(49000, buffer), 1000);
+	EXPECT_TRUE(std::equal(buffer.begin(), buffer.begin() + 1000, data.begin() + 49000));
+
+	EXPECT_EQ(view.ReadAt(50000, buffer), 0);
+}
+
+TEST(RleContainerTest, RejectsWrongMagicAndVersion)
+{
+	auto packed = Pack(MakeData(100), 4096);
+
+	auto badMagic = packed;
+	badMagic[0] = 'X';
+	EXPECT_THROW(Unpack(badMagic), std::runtime_error);
+	EXPECT_THROW(RleContainerView{ badMagic }, std::runtime_error);
+
+	auto badVersion = packed;
+	badVersion[4] = RleContainerFormat::k_version + 1;
+	EXPECT_THROW(Unpack(badVersion), std::runtime_error);
+	EXPECT_THROW(RleContainerView{ badVersion }, std::runtime_error);
+}
+
+TEST(RleContainerTest, DetectsCorruptedChunk)
+{
+	auto packed = Pack(MakeData(10000), 4096);
+	packed[RleContainerFormat::k_headerSize + RleContainerFormat::k_chunkHeaderSize + 5] ^= 0x01;
+
+	EXPECT_THROW(Unpack(packed), std::runtime_error);
+	EXPECT_THROW(RleContainerView(packed).UnpackAll(), std::runtime_error);
+}
+
+TEST(RleContainerTest, DetectsTruncationAndBadFooter)
+{
+	auto packed = Pack(MakeData(10000), 4096);
+
+	auto truncated = packed;
+	truncated.resize(packed.size() - 5);
+	EXPECT_THROW(Unpack(truncated), std::runtime_error);
+	EXPECT_THROW(RleContainerView{ truncated }, std::runtime_error);
+
+	auto badFooter = packed;
+	badFooter[badFooter.size() - RleContainerFormat::k_footerSize + 8] ^= 0x01;
+	EXPECT_THROW(Unpack(badFooter), std::runtime_error);
+	EXPECT_THROW(RleContainerView{ badFooter }, std::runtime_error);
+}
+
+TEST(RleContainerTest, SeeksIntoFileBackedContainer)
+{
+	auto data = MakeData(50000);
+	auto packed = Pack(data, 1024);
+	{
+		std::ofstream file("rle_seek_test.bin", std::ios::binary);
+		file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+	}
+
+	{
+		ChunkedUnpackingInputStreamDecorator unpacker(
+			std::make_unique<FileInputStream>(std::make_unique<std::ifstream>("rle_seek_test.bin", std::ios::binary)));
+		ASSERT_TRUE(unpacker.IsSeekable());
+		EXPECT_EQ(unpacker.Size(), static_cast<std::streamsize>(data.size()));
+
+		// Reading on from the middle continues chunk by chunk and still checks
+		// the trailer at the end.
+		unpacker.Seek(30000);
+		std::vector<uint8_t> rest(data.size());
+		EXPECT_EQ(unpacker.ReadBlock(rest.data(), static_cast<std::streamsize>(rest.size())), 20000);
+		EXPECT_TRUE(std::equal(data.begin() + 30000, data.end(), rest.begin()));
+		EXPECT_TRUE(unpacker.IsEOF());
+
+		unpacker.Seek(12345);
+		EXPECT_EQ(unpacker.ReadByte(), data[12345]);
+
+		std::vector<uint8_t> buffer(3000);
+		EXPECT_EQ(unpacker.ReadAt(40000, buffer), 3000);
+		EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), data.begin() + 40000));
+		EXPECT_EQ(unpacker.ReadAt(49000, buffer), 1000);
+		EXPECT_EQ(unpacker.ReadAt(50000, buffer), 0);
+		EXPECT_EQ(unpacker.ReadByte(), data[12346]);
+
+		unpacker.Seek(static_cast<std::streamsize>(data.size()));
+		EXPECT_TRUE(unpacker.IsEOF());
+		EXPECT_THROW(unpacker.Seek(static_cast<std::streamsize>(data.size()) + 1), std::runtime_error);
+	}
+	std::remove("rle_seek_test.bin");
+}
+
+TEST(RleContainerTest, SeekRejectsCorruptedIndexedChunk)
+{
+	auto packed = Pack(MakeData(10000), 1024);
+	const auto chunk = RleContainerFormat::GetIndexEntry(
+		packed.data() + packed.size() - RleContainerFormat::k_footerSize - 9 * RleContainerFormat::k_indexEntrySize);
+	packed[chunk.recordOffset + RleContainerFormat::k_chunkHeaderSize] ^= 0x01;
+
+	ChunkedUnpackingInputStreamDecorator unpacker(std::make_unique<MemoryInputStream>(packed.data(), packed.size()));
+	EXPECT_NO_THROW(unpacker.Seek(500));
+	EXPECT_THROW(unpacker.Seek(1500), std::runtime_error);
+}
+
+void PutLittleEndian(uint8_t* dst, uint64_t value, size_t size)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		dst[i] = static_cast<uint8_t>(value >> (8 * i));
+	}
+}
+
+TEST(RleContainerTest, ViewRejectsOffsetsThatWrapAround)
+{
+	using Format = RleContainerFormat;
+	auto packed = Pack(MakeData(10000), 4096);
+	const size_t footer = packed.size() - Format::k_footerSize;
+	const size_t indexOffset = footer - 3 * Format::k_indexEntrySize;
+
+	// indexOffset + index size + footer size wraps around to the data size.
+	auto wrappedFooter = packed;
+	const uint32_t chunkCount = UINT32_MAX;
+	const uint64_t tail = uint64_t{ chunkCount } * Format::k_indexEntrySize + Format::k_footerSize;
+	PutLittleEndian(wrappedFooter.data() + footer, packed.size() - tail, 8);
+	PutLittleEndian(wrappedFooter.data() + footer + 8, chunkCount, 4);
+	EXPECT_THROW(RleContainerView{ wrappedFooter }, std::runtime_error);
+
+	// recordOffset + chunk header size + packed size wraps around to zero.
+	auto wrappedRecord = packed;
+	const auto chunk = Format::GetIndexEntry(packed.data() + indexOffset);
+	PutLittleEndian(wrappedRecord.data() + indexOffset, 0 - Format::k_chunkHeaderSize - uint64_t{ chunk.packedSize }, 8);
+	EXPECT_THROW(RleContainerView{ wrappedRecord }, std::runtime_error);
+
+	// A record that starts inside the container header.
+	auto recordInHeader = packed;
+	PutLittleEndian(recordInHeader.data() + indexOffset, 0, 8);
+	EXPECT_THROW(RleContainerView{ recordInHeader }, std::runtime_error);
+
+	EXPECT_EQ(10000u, RleContainerView{ packed }.UnpackAll().size());
+}
+
+} // namespace rle_container_tests
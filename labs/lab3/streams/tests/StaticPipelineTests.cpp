@@ -0,0 +1,92 @@
+#include "../src/lib/MakeDecorator.h"
+#include "../src/lib/StaticPipeline.h"
+#include "../src/lib/StreamDecorator.h"
+#include <gtest/gtest.h>
+
+namespace static_pipeline_tests
+{
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size; ++i)
+	{
+		data[i] = static_cast<uint8_t>(i % 11 == 0 ? 0xFF : i / 70);
+	}
+	return data;
+}
+
+template <typename Stream>
+void WriteInPieces(Stream& stream, const std::vector<uint8_t>& data)
+{
+	size_t position = 0;
+	for (size_t step = 1; position < data.size(); ++step)
+	{
+		size_t size = std::min(step * 37 % 5000, data.size() - position);
+		if (size == 0)
+		{
+			stream.WriteByte(data[position++]);
+			continue;
+		}
+		stream.WriteBlock(data.data() + position, static_cast<std::streamsize>(size));
+		position += size;
+	}
+}
+
+TEST(StaticPipelineTest, MatchesRuntimeDecorators)
+{
+	auto data = MakeData(30000);
+
+	auto runtimeOutput = std::make_unique<MemoryOutputStream>();
+	auto* runtimeOutputPtr = runtimeOutput.get();
+	auto runtimeStream = std::move(runtimeOutput)
+		<< MakeDecorator<EncodingOutputStreamDecorator>(7)
+		<< MakeDecorator<PackingOutputStreamDecorator>()
+		<< MakeDecorator<EncodingOutputStreamDecorator>(3);
+	WriteInPieces(*runtimeStream, data);
+	runtimeStream->Close();
+
+	auto staticOutput = std::make_unique<MemoryOutputStream>();
+	auto* staticOutputPtr = staticOutput.get();
+	auto staticStream = std::move(staticOutput) << (Encrypt<3>() | Pack() | Encrypt<7>());
+	WriteInPieces(*staticStream, data);
+	staticStream->Close();
+
+	EXPECT_EQ(staticOutputPtr->GetData(), runtimeOutputPtr->GetData());
+}
+
+TEST(StaticPipelineTest, RoundTripsThroughRuntimeReaders)
+{
+	auto data = MakeData(9000);
+
+	auto output = std::make_unique<MemoryOutputStream>();
+	auto* outputPtr = output.get();
+	IOutputStreamPtr stream = StaticPipeline<Encrypt<1>, Encrypt<2>, Pack>()(std::move(output));
+	WriteInPieces(*stream, data);
+	stream->Close();
+
+	const auto& encoded = outputPtr->GetData();
+	auto input = std::make_unique<MemoryInputStream>(encoded.data(), encoded.size())
+		<< MakeDecorator<UnpackingInputStreamDecorator>()
+		<< MakeDecorator<DecodingInputStreamDecorator>(2)
+		<< MakeDecorator<DecodingInputStreamDecorator>(1);
+
+	std::vector<uint8_t> result(data.size() + 1);
+	std::streamsize total = 0;
+	while (!input->IsEOF())
+	{
+		total += input->ReadBlock(result.data() + total, static_cast<std::streamsize>(result.size()) - total);
+	}
+	result.resize(total);
+	EXPECT_EQ(result, data);
+}
+
+TEST(StaticPipelineTest, WriteAfterCloseThrows)
+{
+	auto stream = std::make_unique<MemoryOutputStream>() << StaticPipeline<Pack>();
+	stream->WriteByte(0x01);
+	stream->Close();
+	EXPECT_THROW(stream->WriteByte(0x02), std::runtime_error);
+}
+
+} // namespace static_pipeline_tests
@@ -4,6 +4,7 @@
 #include "../src/lib/StreamDecorator.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 namespace stream_decorator_tests
 {
@@ -132,3 +133,245 @@ TEST(OutputStreamDecoratorTest, MultipleDecoration)
 
 
 }
+
+namespace stream_decorator_tests
+{
+
+TEST(PackingDecoratorTest, RoundTripInSmallBlocks)
+{
+	std::vector<uint8_t> original;
+	for (int i = 0; i < 20000; ++i)
+	{
+		original.push_back(static_cast<uint8_t>((i / 37) % 3 == 0 ? 0xFF : i / 100));
+	}
+
+	auto memoryOutput = std::make_unique<MemoryOutputStream>();
+	auto* memoryOutputPtr = memoryOutput.get();
+	{
+		PackingOutputStreamDecorator packer(std::move(memoryOutput));
+		for (size_t offset = 0; offset < original.size(); offset += 1000)
+		{
+			packer.WriteBlock(original.data() + offset, 1000);
+		}
+		packer.WriteByte(0x42);
+		packer.Close();
+		original.push_back(0x42);
+		EXPECT_LT(memoryOutputPtr->GetData().size(), original.size());
+
+		const auto& packed = memoryOutputPtr->GetData();
+		UnpackingInputStreamDecorator unpacker(std::make_unique<MemoryInputStream>(packed.data(), packed.size()));
+
+		std::vector<uint8_t> result(original.size() + 10);
+		std::streamsize total = 0;
+		while (!unpacker.IsEOF())
+		{
+			total += unpacker.ReadBlock(result.data() + total, std::min<std::streamsize>(4096, result.size() - total));
+		}
+
+		ASSERT_EQ(total, static_cast<std::streamsize>(original.size()));
+		result.resize(total);
+		EXPECT_EQ(result, original);
+	}
+}
+
+TEST(PackingDecoratorTest, ReadByteDecodesRuns)
+{
+	const uint8_t packed[] = { 0x01, 0xFF, 0x07, 0x03 };
+	UnpackingInputStreamDecorator unpacker(std::make_unique<MemoryInputStream>(packed, 4));
+
+	EXPECT_EQ(unpacker.ReadByte(), 0x01);
+	EXPECT_EQ(unpacker.ReadByte(), 0x07);
+	EXPECT_EQ(unpacker.ReadByte(), 0x07);
+	EXPECT_EQ(unpacker.ReadByte(), 0x07);
+	EXPECT_TRUE(unpacker.IsEOF());
+	EXPECT_THROW(unpacker.ReadByte(), std::runtime_error);
+}
+
+TEST(SubstitutionFusionTest, StackedEncodersWriteOnce)
+{
+	const uint8_t data[] = { 0x00, 0x10, 0x7F, 0xFF };
+	uint8_t expected[4];
+	std::memcpy(expected, data, 4);
+	EncodingDataProcessor(5).ProcessDataBlock(expected, 4);
+	EncodingDataProcessor(3).ProcessDataBlock(expected, 4);
+	EncodingDataProcessor(1).ProcessDataBlock(expected, 4);
+
+	auto mockOutputStream = std::make_unique<MockOutputStream>();
+	EXPECT_CALL(*mockOutputStream, WriteBlock(testing::_, 4))
+		.WillOnce([&](const void* srcData, std::streamsize) {
+			EXPECT_EQ(std::memcmp(srcData, expected, 4), 0);
+		});
+	EXPECT_CALL(*mockOutputStream, WriteByte(expected[1])).Times(1);
+
+	IOutputStreamPtr stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(mockOutputStream), 1);
+	stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 3);
+	stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 5);
+
+	stream->WriteBlock(data, 4);
+	stream->WriteByte(data[1]);
+}
+
+TEST(SubstitutionFusionTest, DecodersAroundPackingUndoEncoders)
+{
+	std::vector<uint8_t> original(5000);
+	for (size_t i = 0; i < original.size(); ++i)
+	{
+		original[i] = static_cast<uint8_t>(i / 9);
+	}
+
+	auto memoryOutput = std::make_unique<MemoryOutputStream>();
+	auto* memoryOutputPtr = memoryOutput.get();
+	IOutputStreamPtr output = std::make_unique<EncodingOutputStreamDecorator>(std::move(memoryOutput), 11);
+	output = std::make_unique<EncodingOutputStreamDecorator>(std::move(output), 12);
+	output = std::make_unique<PackingOutputStreamDecorator>(std::move(output));
+	output = std::make_unique<EncodingOutputStreamDecorator>(std::move(output), 13);
+	output = std::make_unique<EncodingOutputStreamDecorator>(std::move(output), 14);
+	output->WriteBlock(original.data(), static_cast<std::streamsize>(original.size()));
+	output->Close();
+
+	const auto& encoded = memoryOutputPtr->GetData();
+	IInputStreamPtr input = std::make_unique<MemoryInputStream>(encoded.data(), encoded.size());
+	input = std::make_unique<DecodingInputStreamDecorator>(std::move(input), 11);
+	input = std::make_unique<DecodingInputStreamDecorator>(std::move(input), 12);
+	input = std::make_unique<UnpackingInputStreamDecorator>(std::move(input));
+	input = std::make_unique<DecodingInputStreamDecorator>(std::move(input), 13);
+	input = std::make_unique<DecodingInputStreamDecorator>(std::move(input), 14);
+
+	std::vector<uint8_t> result;
+	while (!input->IsEOF())
+	{
+		result.push_back(input->ReadByte());
+	}
+	EXPECT_EQ(result, original);
+}
+
+TEST(SeekableDecoratorTest, DecoderPassesRandomAccessThrough)
+{
+	std::vector<uint8_t> original(20000);
+	for (size_t i = 0; i < original.size(); ++i)
+	{
+		original[i] = static_cast<uint8_t>(i % 251);
+	}
+	std::vector<uint8_t> encoded = original;
+	EncodingDataProcessor(4).ProcessDataBlock(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+	EncodingDataProcessor(9).ProcessDataBlock(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+
+	IInputStreamPtr stream = std::make_unique<MemoryInputStream>(encoded.data(), encoded.size());
+	stream = std::make_unique<DecodingInputStreamDecorator>(std::move(stream), 9);
+	stream = std::make_unique<DecodingInputStreamDecorator>(std::move(stream), 4);
+
+	auto* seekable = dynamic_cast<ISeekableInputStream*>(stream.get());
+	ASSERT_NE(seekable, nullptr);
+	ASSERT_TRUE(seekable->IsSeekable());
+	EXPECT_EQ(seekable->Size(), 20000);
+
+	std::vector<uint8_t> result(original.size());
+	std::vector<std::thread> threads;
+	for (size_t part = 0; part < 4; ++part)
+	{
+		threads.emplace_back([&, part] {
+			size_t offset = part * 5000;
+			seekable->ReadAt(static_cast<std::streamsize>(offset), std::span(result).subspan(offset, 5000));
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	EXPECT_EQ(result, original);
+
+	seekable->Seek(12345);
+	EXPECT_EQ(stream->ReadByte(), original[12345]);
+}
+
+TEST(SeekableDecoratorTest, StatefulLayersAreNotSeekable)
+{
+	const uint8_t data[] = { 0x01, 0x02 };
+	auto mockProcessor = std::make_shared<MockDataProcessor>();
+	InputStreamDecorator decorator(std::make_unique<MemoryInputStream>(data, 2), mockProcessor);
+	EXPECT_FALSE(decorator.IsSeekable());
+	EXPECT_THROW(decorator.Seek(0), std::runtime_error);
+
+	IInputStreamPtr stream = std::make_unique<MemoryInputStream>(data, 2);
+	stream = std::make_unique<UnpackingInputStreamDecorator>(std::move(stream));
+	stream = std::make_unique<DecodingInputStreamDecorator>(std::move(stream), 1);
+	auto* seekable = dynamic_cast<ISeekableInputStream*>(stream.get());
+	ASSERT_NE(seekable, nullptr);
+	EXPECT_FALSE(seekable->IsSeekable());
+	EXPECT_THROW(seekable->Size(), std::runtime_error);
+}
+
+TEST(BorrowingDecoratorTest, DecodesMappedPagesIntoCallerBuffer)
+{
+	std::vector<uint8_t> original(10000);
+	for (size_t i = 0; i < original.size(); ++i)
+	{
+		original[i] = static_cast<uint8_t>(i * 31);
+	}
+	std::vector<uint8_t> encoded = original;
+	EncodingDataProcessor(4).ProcessDataBlock(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+	{
+		std::ofstream file("borrowing_test_file.bin", std::ios::binary);
+		file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+	}
+
+	{
+		IInputStreamPtr stream = std::make_unique<MappedFileInputStream>("borrowing_test_file.bin");
+		stream = std::make_unique<DecodingInputStreamDecorator>(std::move(stream), 4);
+
+		std::vector<uint8_t> result;
+		uint8_t buffer[3000];
+		while (!stream->IsEOF())
+		{
+			auto bytesRead = stream->ReadBlock(buffer, sizeof(buffer));
+			result.insert(result.end(), buffer, buffer + bytesRead);
+		}
+		EXPECT_EQ(result, original);
+	}
+
+	std::ifstream file("borrowing_test_file.bin", std::ios::binary);
+	std::vector<uint8_t> onDisk((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(onDisk, encoded);
+	file.close();
+	std::remove("borrowing_test_file.bin");
+}
+
+TEST(ReservingDecoratorTest, EncodesWritesIntoReservedBlocks)
+{
+	std::vector<uint8_t> data(5000);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 7);
+	}
+	std::vector<uint8_t> expected = data;
+	EncodingDataProcessor(3).ProcessDataBlock(expected.data(), static_cast<std::streamsize>(expected.size()));
+	EncodingDataProcessor(9).ProcessDataBlock(expected.data(), static_cast<std::streamsize>(expected.size()));
+
+	{
+		IOutputStreamPtr stream = std::make_unique<MappedFileOutputStream>("reserving_test_file.bin", 1000);
+		stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 9);
+		stream = std::make_unique<EncodingOutputStreamDecorator>(std::move(stream), 3);
+		auto* reserving = dynamic_cast<IReservingOutputStream*>(stream.get());
+		ASSERT_NE(reserving, nullptr);
+		ASSERT_TRUE(reserving->CanReserve());
+
+		stream->WriteBlock(data.data(), 3000);
+		auto block = reserving->Reserve(2000);
+		std::memcpy(block.data(), data.data() + 3000, block.size());
+		reserving->Commit(static_cast<std::streamsize>(block.size()));
+		stream->WriteBlock(data.data() + 3000 + block.size(), static_cast<std::streamsize>(2000 - block.size()));
+		stream->Close();
+	}
+
+	std::ifstream file("reserving_test_file.bin", std::ios::binary);
+	std::vector<uint8_t> onDisk((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(onDisk, expected);
+	file.close();
+	std::remove("reserving_test_file.bin");
+
+	EncodingOutputStreamDecorator memoryDecorator(std::make_unique<MemoryOutputStream>(), 1);
+	EXPECT_FALSE(memoryDecorator.CanReserve());
+	EXPECT_THROW(memoryDecorator.Reserve(1), std::runtime_error);
+}
+
+} // namespace stream_decorator_tests
@@ -0,0 +1,37 @@
+#include "../src/lib/WorkerPool.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+TEST(WorkerPoolTest, RunsEveryJobOncePerBatch)
+{
+	WorkerPool pool(4);
+	EXPECT_EQ(pool.GetWorkerCount(), 4u);
+
+	for (size_t batch = 0; batch < 50; ++batch)
+	{
+		std::vector<std::atomic<int>> calls(batch);
+		pool.Run(calls.size(), [&](size_t i) { ++calls[i]; });
+		for (const auto& count : calls)
+		{
+			EXPECT_EQ(count.load(), 1);
+		}
+	}
+}
+
+TEST(WorkerPoolTest, RethrowsJobErrorAndStaysUsable)
+{
+	WorkerPool pool(3);
+	EXPECT_THROW(pool.Run(100, [](size_t i) {
+		if (i == 10)
+		{
+			throw std::runtime_error("job failed");
+		}
+	}),
+		std::runtime_error);
+
+	std::atomic<size_t> sum = 0;
+	pool.Run(10, [&](size_t i) { sum += i; });
+	EXPECT_EQ(sum.load(), 45u);
+}
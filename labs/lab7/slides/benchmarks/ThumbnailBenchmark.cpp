@@ -0,0 +1,73 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#include "../src/lib/Raster/ThumbnailRenderer.h"
+#include "../src/lib/Shapes/GroupShape.h"
+#include "../src/lib/Shapes/Shapes.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int k_slideCount = 64;
+constexpr int k_shapesPerSlide = 200;
+
+std::shared_ptr<IShape> MakeShape(DrawingStrategy strategy, RectD frame, RGBAColor fillColor)
+{
+	return std::make_shared<SimpleShape>(
+		std::make_shared<DrawingStrategy>(std::move(strategy)), frame,
+		std::make_unique<Style>(true, fillColor),
+		std::make_unique<Style>(true, 0x000000FF), 2);
+}
+
+// Слайды 1280x960 со случайными прямоугольниками, эллипсами и шестиугольниками.
+std::vector<std::shared_ptr<const IDrawable>> MakeSlides()
+{
+	std::mt19937 random(42);
+	std::uniform_real_distribution<double> position(0, 1180);
+	std::uniform_real_distribution<double> size(10, 100);
+	std::uniform_int_distribution<RGBAColor> color(0, 0xFFFFFF);
+
+	std::vector<std::shared_ptr<const IDrawable>> slides;
+	for (int slide = 0; slide < k_slideCount; ++slide)
+	{
+		auto group = std::make_shared<GroupShape>();
+		for (int i = 0; i < k_shapesPerSlide; ++i)
+		{
+			const RectD frame{ position(random), position(random) * 0.75, size(random), size(random) };
+			const RGBAColor fillColor = color(random) << 8 | 0xFF;
+			switch (i % 3)
+			{
+			case 0:
+				group->InsertShape(MakeShape(MakeRectangleStrategy(), frame, fillColor));
+				break;
+			case 1:
+				group->InsertShape(MakeShape(MakeEllipseStrategy(), frame, fillColor));
+				break;
+			default:
+				group->InsertShape(MakeShape(MakePolygonStrategy(6), frame, fillColor));
+				break;
+			}
+		}
+		slides.push_back(group);
+	}
+	return slides;
+}
+
+// Аргумент — число потоков; items/s в отчёте — слайдов в секунду. Потоки
+// запускаются один раз, до замеров.
+void BM_RenderThumbnails(benchmark::State& state)
+{
+	const auto slides = MakeSlides();
+	ThumbnailRenderer renderer(static_cast<unsigned>(state.range(0)));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(renderer.Render(slides));
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(slides.size()));
+}
+BENCHMARK(BM_RenderThumbnails)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+} // namespace
@@ -0,0 +1,348 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#ifndef OOD_AABBTREE_H
+#define OOD_AABBTREE_H
+#include "CommonTypes.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Динамическое дерево ограничивающих прямоугольников (BVH). Листья хранят
+// прямоугольник и значение и вставляются туда, где периметр родительских
+// прямоугольников вырастет меньше всего; после вставки и удаления дерево
+// выравнивается поворотами, поэтому его высота остаётся O(log n).
+// Номер листа, который вернул Insert, не меняется до Remove.
+template <typename T>
+class AabbTree
+{
+public:
+	static constexpr int k_nullNode = -1;
+
+	int Insert(const RectD& box, T value)
+	{
+		const int leaf = AllocateNode();
+		Node& node = m_nodes[leaf];
+		node.box = box;
+		node.height = 0;
+		node.value = std::move(value);
+		InsertLeaf(leaf);
+		++m_size;
+		return leaf;
+	}
+
+	void Remove(int leaf)
+	{
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+		--m_size;
+	}
+
+	void Move(int leaf, const RectD& box)
+	{
+		if (IsSame(m_nodes[leaf].box, box))
+		{
+			return;
+		}
+		RemoveLeaf(leaf);
+		m_nodes[leaf].box = box;
+		InsertLeaf(leaf);
+	}
+
+	const RectD& GetBox(int leaf) const
+	{
+		return m_nodes[leaf].box;
+	}
+
+	T& GetValue(int leaf)
+	{
+		return m_nodes[leaf].value;
+	}
+
+	const T& GetValue(int leaf) const
+	{
+		return m_nodes[leaf].value;
+	}
+
+	size_t GetSize() const
+	{
+		return m_size;
+	}
+
+	int GetHeight() const
+	{
+		return m_root == k_nullNode ? 0 : m_nodes[m_root].height;
+	}
+
+	// Вызывает visit(value) для каждого листа, пересекающего area.
+	template <typename Visit>
+	void Query(const RectD& area, Visit&& visit) const
+	{
+		Traverse([&](const RectD& box) { return Intersects(box, area); }, visit);
+	}
+
+	// Вызывает visit(value) для каждого листа, содержащего точку.
+	template <typename Visit>
+	void QueryPoint(double x, double y, Visit&& visit) const
+	{
+		Traverse([&](const RectD& box) { return Contains(box, x, y); }, visit);
+	}
+
+	static bool Intersects(const RectD& a, const RectD& b)
+	{
+		return a.left <= b.left + b.width && b.left <= a.left + a.width
+			&& a.top <= b.top + b.height && b.top <= a.top + a.height;
+	}
+
+	static bool Contains(const RectD& box, double x, double y)
+	{
+		return x >= box.left && x <= box.left + box.width
+			&& y >= box.top && y <= box.top + box.height;
+	}
+
+private:
+	struct Node
+	{
+		RectD box;
+		// Для свободного узла — следующий свободный.
+		int parent = k_nullNode;
+		int left = k_nullNode;
+		int right = k_nullNode;
+		// У листа 0, у свободного узла -1.
+		int height = -1;
+		T value{};
+	};
+
+	static RectD Union(const RectD& a, const RectD& b)
+	{
+		const double left = std::min(a.left, b.left);
+		const double top = std::min(a.top, b.top);
+		const double right = std::max(a.left + a.width, b.left + b.width);
+		const double bottom = std::max(a.top + a.height, b.top + b.height);
+		return { left, top, right - left, bottom - top };
+	}
+
+	static double Perimeter(const RectD& box)
+	{
+		return 2 * (box.width + box.height);
+	}
+
+	static bool IsSame(const RectD& a, const RectD& b)
+	{
+		return a.left == b.left && a.top == b.top && a.width == b.width && a.height == b.height;
+	}
+
+	bool IsLeaf(int index) const
+	{
+		return m_nodes[index].left == k_nullNode;
+	}
+
+	template <typename Accept, typename Visit>
+	void Traverse(Accept&& accept, Visit& visit) const
+	{
+		if (m_root == k_nullNode)
+		{
+			return;
+		}
+		std::vector<int> stack{ m_root };
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+			if (!accept(node.box))
+			{
+				continue;
+			}
+			if (node.left == k_nullNode)
+			{
+				visit(node.value);
+			}
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	int AllocateNode()
+	{
+		if (m_freeList == k_nullNode)
+		{
+			m_nodes.emplace_back();
+			return static_cast<int>(m_nodes.size() - 1);
+		}
+		const int index = m_freeList;
+		m_freeList = m_nodes[index].parent;
+		m_nodes[index] = Node{};
+		return index;
+	}
+
+	void FreeNode(int index)
+	{
+		m_nodes[index] = Node{};
+		m_nodes[index].parent = m_freeList;
+		m_freeList = index;
+	}
+
+	// Цена вставки листа под узел index: прирост периметров предков уже
+	// учтён вызывающим, здесь — периметр нового или расширенного узла.
+	double GetDescendCost(int index, const RectD& box) const
+	{
+		const RectD& nodeBox = m_nodes[index].box;
+		const double perimeter = Perimeter(Union(box, nodeBox));
+		return IsLeaf(index) ? perimeter : perimeter - Perimeter(nodeBox);
+	}
+
+	void InsertLeaf(int leaf)
+	{
+		if (m_root == k_nullNode)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = k_nullNode;
+			return;
+		}
+
+		const RectD box = m_nodes[leaf].box;
+		int sibling = m_root;
+		while (!IsLeaf(sibling))
+		{
+			const Node& node = m_nodes[sibling];
+			const double combined = Perimeter(Union(node.box, box));
+			const double cost = 2 * combined;
+			const double inheritanceCost = 2 * (combined - Perimeter(node.box));
+			const double leftCost = GetDescendCost(node.left, box) + inheritanceCost;
+			const double rightCost = GetDescendCost(node.right, box) + inheritanceCost;
+			if (cost < leftCost && cost < rightCost)
+			{
+				break;
+			}
+			sibling = leftCost < rightCost ? node.left : node.right;
+		}
+
+		const int oldParent = m_nodes[sibling].parent;
+		const int newParent = AllocateNode();
+		Node& parent = m_nodes[newParent];
+		parent.parent = oldParent;
+		parent.box = Union(box, m_nodes[sibling].box);
+		parent.height = m_nodes[sibling].height + 1;
+		parent.left = sibling;
+		parent.right = leaf;
+		ReplaceChild(oldParent, sibling, newParent);
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		Refit(newParent);
+	}
+
+	void RemoveLeaf(int leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = k_nullNode;
+			return;
+		}
+
+		const int parent = m_nodes[leaf].parent;
+		const int grandParent = m_nodes[parent].parent;
+		const int sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+		ReplaceChild(grandParent, parent, sibling);
+		m_nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+		m_nodes[leaf].parent = k_nullNode;
+		if (grandParent != k_nullNode)
+		{
+			Refit(grandParent);
+		}
+	}
+
+	void ReplaceChild(int parent, int oldChild, int newChild)
+	{
+		if (parent == k_nullNode)
+		{
+			m_root = newChild;
+		}
+		else if (m_nodes[parent].left == oldChild)
+		{
+			m_nodes[parent].left = newChild;
+		}
+		else
+		{
+			m_nodes[parent].right = newChild;
+		}
+	}
+
+	// Поднимается к корню, выравнивая узлы и пересчитывая их прямоугольники.
+	void Refit(int index)
+	{
+		while (index != k_nullNode)
+		{
+			index = Balance(index);
+			Node& node = m_nodes[index];
+			const Node& left = m_nodes[node.left];
+			const Node& right = m_nodes[node.right];
+			node.height = 1 + std::max(left.height, right.height);
+			node.box = Union(left.box, right.box);
+			index = node.parent;
+		}
+	}
+
+	// Если высоты детей узла a различаются больше чем на 1, поднимает
+	// более высокого ребёнка на место a. Возвращает новый корень поддерева.
+	int Balance(int a)
+	{
+		if (IsLeaf(a) || m_nodes[a].height < 2)
+		{
+			return a;
+		}
+		const int b = m_nodes[a].left;
+		const int c = m_nodes[a].right;
+		const int balance = m_nodes[c].height - m_nodes[b].height;
+		if (balance > 1)
+		{
+			return Rotate(a, c, false);
+		}
+		if (balance < -1)
+		{
+			return Rotate(a, b, true);
+		}
+		return a;
+	}
+
+	// Ребёнок up занимает место a, a становится его левым ребёнком, а более
+	// низкий из внуков переходит к a на место up.
+	int Rotate(int a, int up, bool isLeftChild)
+	{
+		const int f = m_nodes[up].left;
+		const int g = m_nodes[up].right;
+		m_nodes[up].left = a;
+		m_nodes[up].parent = m_nodes[a].parent;
+		m_nodes[a].parent = up;
+		ReplaceChild(m_nodes[up].parent, a, up);
+
+		const bool keepLeft = m_nodes[f].height > m_nodes[g].height;
+		const int kept = keepLeft ? f : g;
+		const int moved = keepLeft ? g : f;
+		m_nodes[up].right = kept;
+		(isLeftChild ? m_nodes[a].left : m_nodes[a].right) = moved;
+		m_nodes[moved].parent = a;
+
+		Node& nodeA = m_nodes[a];
+		nodeA.box = Union(m_nodes[nodeA.left].box, m_nodes[nodeA.right].box);
+		nodeA.height = 1 + std::max(m_nodes[nodeA.left].height, m_nodes[nodeA.right].height);
+		Node& nodeUp = m_nodes[up];
+		nodeUp.box = Union(nodeA.box, m_nodes[kept].box);
+		nodeUp.height = 1 + std::max(nodeA.height, m_nodes[kept].height);
+		return up;
+	}
+
+	std::vector<Node> m_nodes;
+	int m_root = k_nullNode;
+	int m_freeList = k_nullNode;
+	size_t m_size = 0;
+};
+
+#endif // OOD_AABBTREE_H
@@ -1,26 +1,11 @@
 #pragma once
 #include "CommonTypes.h"
+#include "ICanvas.h"
 #include <SFML/Graphics.hpp>
 #include <algorithm>
 #include <cmath>
 #include <vector>
 
-class ICanvas
-{
-public:
-	virtual void SetLineColor(RGBAColor color) = 0;
-	virtual void BeginFill(RGBAColor color) = 0;
-	virtual void EndFill() = 0;
-	virtual void MoveTo(double x, double y) = 0;
-	virtual void LineTo(double x, double y) = 0;
-	virtual void DrawEllipse(
-		double left, double top, double width, double height)
-		= 0;
-	virtual void SetLineWidth(int width) = 0;
-
-	virtual ~ICanvas() = default;
-};
-
 inline sf::Color toSfColor(RGBAColor color)
 {
 	return sf::Color((color >> 24) & 0xFF,
@@ -130,4 +115,163 @@ private:
 	sf::Color m_currentLineColor;
 	int m_currentLineWidth;
 	std::vector<sf::Vector2f> m_pathVertices;
+};
+
+// Точек на контуре эллипса, как у sf::CircleShape по умолчанию.
+constexpr size_t k_ellipsePointCount = 30;
+
+// Холст, который ничего не рисует сам, а раскладывает заливки и контуры на
+// треугольники и дописывает их в vertices в порядке рисования. Всё, что
+// нарисовано через него, выводится одним вызовом draw с sf::Triangles.
+class TessellatingCanvas final : public ICanvas
+{
+public:
+	explicit TessellatingCanvas(std::vector<sf::Vertex>& vertices)
+		: m_vertices(vertices)
+		, m_currentFillColor(sf::Color::Transparent)
+		, m_currentLineColor(sf::Color::Transparent)
+		, m_currentLineWidth(1)
+	{
+	}
+
+	void SetLineColor(RGBAColor color) override
+	{
+		m_currentLineColor = toSfColor(color);
+	}
+
+	void BeginFill(RGBAColor color) override
+	{
+		m_currentFillColor = toSfColor(color);
+	}
+
+	void EndFill() override
+	{
+		if (m_pathVertices.size() >= 3 && m_currentFillColor.a > 0)
+		{
+			AddFan(m_pathVertices[0], m_pathVertices, m_currentFillColor);
+		}
+
+		if (m_pathVertices.size() >= 2 && m_currentLineColor.a > 0)
+		{
+			for (size_t i = 0; i < m_pathVertices.size(); ++i)
+			{
+				AddSegment(m_pathVertices[i],
+					m_pathVertices[(i + 1) % m_pathVertices.size()]);
+			}
+		}
+
+		m_pathVertices.clear();
+	}
+
+	void MoveTo(double x, double y) override
+	{
+		m_pathVertices.clear();
+		m_pathVertices.emplace_back(
+			static_cast<float>(x), static_cast<float>(y));
+	}
+
+	void LineTo(double x, double y) override
+	{
+		m_pathVertices.emplace_back(
+			static_cast<float>(x), static_cast<float>(y));
+	}
+
+	// Контур, как и у sf::CircleShape, лежит снаружи эллипса.
+	void DrawEllipse(
+		double left, double top, double width, double height) override
+	{
+		const float radiusX = static_cast<float>(width) / 2.0f;
+		const float radiusY = static_cast<float>(height) / 2.0f;
+		const sf::Vector2f center(
+			static_cast<float>(left) + radiusX, static_cast<float>(top) + radiusY);
+
+		std::vector<sf::Vector2f> inner = GetEllipsePoints(center, radiusX, radiusY);
+		if (m_currentFillColor.a > 0)
+		{
+			AddFan(center, inner, m_currentFillColor);
+		}
+
+		if (m_currentLineColor.a > 0)
+		{
+			const float lineWidth = static_cast<float>(m_currentLineWidth);
+			std::vector<sf::Vector2f> outer = GetEllipsePoints(
+				center, radiusX + lineWidth, radiusY + lineWidth);
+			for (size_t i = 0; i < k_ellipsePointCount; ++i)
+			{
+				const size_t next = (i + 1) % k_ellipsePointCount;
+				AddQuad(inner[i], outer[i], outer[next], inner[next], m_currentLineColor);
+			}
+		}
+	}
+
+	void SetLineWidth(int width) override
+	{
+		m_currentLineWidth = std::max(1, width);
+	}
+
+private:
+	static std::vector<sf::Vector2f> GetEllipsePoints(
+		sf::Vector2f center, float radiusX, float radiusY)
+	{
+		std::vector<sf::Vector2f> points;
+		points.reserve(k_ellipsePointCount);
+		for (size_t i = 0; i < k_ellipsePointCount; ++i)
+		{
+			const double angle = 2.0 * M_PI * static_cast<double>(i) / k_ellipsePointCount;
+			points.emplace_back(center.x + radiusX * static_cast<float>(std::cos(angle)),
+				center.y + radiusY * static_cast<float>(std::sin(angle)));
+		}
+		return points;
+	}
+
+	// Выпуклый многоугольник веером треугольников из точки center.
+	void AddFan(sf::Vector2f center, const std::vector<sf::Vector2f>& points, sf::Color color)
+	{
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			const sf::Vector2f& a = points[i];
+			const sf::Vector2f& b = points[(i + 1) % points.size()];
+			m_vertices.emplace_back(center, color);
+			m_vertices.emplace_back(a, color);
+			m_vertices.emplace_back(b, color);
+		}
+	}
+
+	void AddQuad(sf::Vector2f a, sf::Vector2f b, sf::Vector2f c, sf::Vector2f d, sf::Color color)
+	{
+		m_vertices.emplace_back(a, color);
+		m_vertices.emplace_back(b, color);
+		m_vertices.emplace_back(c, color);
+		m_vertices.emplace_back(a, color);
+		m_vertices.emplace_back(c, color);
+		m_vertices.emplace_back(d, color);
+	}
+
+	// Отрезок толщиной в линию; концы продлены на полтолщины, чтобы углы
+	// контура не оставались пустыми.
+	void AddSegment(sf::Vector2f from, sf::Vector2f to)
+	{
+		const sf::Vector2f delta(to.x - from.x, to.y - from.y);
+		const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+		if (length == 0)
+		{
+			return;
+		}
+		const float halfWidth = static_cast<float>(m_currentLineWidth) / 2.0f;
+		const sf::Vector2f along(delta.x / length * halfWidth, delta.y / length * halfWidth);
+		const sf::Vector2f across(-along.y, along.x);
+		const sf::Vector2f start(from.x - along.x, from.y - along.y);
+		const sf::Vector2f end(to.x + along.x, to.y + along.y);
+		AddQuad({ start.x + across.x, start.y + across.y },
+			{ end.x + across.x, end.y + across.y },
+			{ end.x - across.x, end.y - across.y },
+			{ start.x - across.x, start.y - across.y },
+			m_currentLineColor);
+	}
+
+	std::vector<sf::Vertex>& m_vertices;
+	sf::Color m_currentFillColor;
+	sf::Color m_currentLineColor;
+	int m_currentLineWidth;
+	std::vector<sf::Vector2f> m_pathVertices;
 };
\ No newline at end of file
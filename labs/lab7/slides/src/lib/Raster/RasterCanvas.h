@@ -0,0 +1,392 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#ifndef OOD_RASTERCANVAS_H
+#define OOD_RASTERCANVAS_H
+#include "../ICanvas.h"
+#include "RasterImage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <math.h>
+#include <utility>
+#include <vector>
+
+struct RasterPoint
+{
+	float x;
+	float y;
+};
+
+// Сглаживание по площади: каждый отрезок контура добавляет в буфер
+// накопления знаковую площадь, которую он отсекает в каждой ячейке строки,
+// а сумма по строке слева направо даёт покрытие пикселя. Контуры одной
+// заливки складываются, покрытие ограничено единицей; контур, обходящий
+// другой в обратную сторону, вырезает дыру.
+class CoverageRasterizer
+{
+public:
+	void AddContour(const std::vector<RasterPoint>& points)
+	{
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			AddSegment(points[i], points[(i + 1) % points.size()]);
+		}
+	}
+
+	void Fill(RasterImage& image, RGBAColor color)
+	{
+		const float imageWidth = static_cast<float>(image.GetWidth());
+		const float imageHeight = static_cast<float>(image.GetHeight());
+		const int left = static_cast<int>(std::clamp(std::floor(m_minX), 0.0f, imageWidth));
+		const int top = static_cast<int>(std::clamp(std::floor(m_minY), 0.0f, imageHeight));
+		const int right = static_cast<int>(std::clamp(std::ceil(m_maxX), 0.0f, imageWidth));
+		const int bottom = static_cast<int>(std::clamp(std::ceil(m_maxY), 0.0f, imageHeight));
+		if (!m_segments.empty() && left < right && top < bottom && (color & 0xFF) != 0)
+		{
+			const int width = right - left;
+			const int height = bottom - top;
+			const size_t stride = static_cast<size_t>(width) + 2;
+			m_cells.assign(stride * height, 0.0f);
+			for (const auto& [from, to] : m_segments)
+			{
+				AccumulateClipped({ from.x - left, from.y - top }, { to.x - left, to.y - top }, width, height, stride);
+			}
+
+			m_coverage.resize(static_cast<size_t>(width));
+			for (int y = 0; y < height; ++y)
+			{
+				const float* cells = m_cells.data() + stride * y;
+				float sum = 0;
+				for (int x = 0; x < width; ++x)
+				{
+					sum += cells[x];
+					m_coverage[x] = std::min(1.0f, std::abs(sum));
+				}
+				BlendSpan(image.GetRow(top + y).data() + left, m_coverage.data(), width, color);
+			}
+		}
+		Clear();
+	}
+
+	void Clear()
+	{
+		m_segments.clear();
+		m_minX = m_minY = INFINITY;
+		m_maxX = m_maxY = -INFINITY;
+	}
+
+private:
+	void AddSegment(RasterPoint from, RasterPoint to)
+	{
+		m_segments.emplace_back(from, to);
+		m_minX = std::min({ m_minX, from.x, to.x });
+		m_minY = std::min({ m_minY, from.y, to.y });
+		m_maxX = std::max({ m_maxX, from.x, to.x });
+		m_maxY = std::max({ m_maxY, from.y, to.y });
+	}
+
+	// Части отрезка левее 0 и правее width прижимаются к границе: вертикальные
+	// отрезки на границе дают внутри области ту же площадь.
+	void AccumulateClipped(RasterPoint from, RasterPoint to, int width, int height, size_t stride)
+	{
+		const float right = static_cast<float>(width);
+		float cuts[4] = { 0, 1, 1, 1 };
+		int cutCount = 1;
+		for (float edge : { 0.0f, right })
+		{
+			if ((from.x - edge) * (to.x - edge) < 0)
+			{
+				cuts[cutCount++] = (edge - from.x) / (to.x - from.x);
+			}
+		}
+		// Первая доля всегда 0, а пересечений не больше двух.
+		if (cutCount == 3 && cuts[2] < cuts[1])
+		{
+			std::swap(cuts[1], cuts[2]);
+		}
+		cuts[cutCount] = 1;
+		for (int i = 0; i < cutCount; ++i)
+		{
+			RasterPoint a{ from.x + (to.x - from.x) * cuts[i], from.y + (to.y - from.y) * cuts[i] };
+			RasterPoint b{ from.x + (to.x - from.x) * cuts[i + 1], from.y + (to.y - from.y) * cuts[i + 1] };
+			const float middle = (a.x + b.x) / 2;
+			if (middle <= 0 || middle >= right)
+			{
+				a.x = b.x = middle <= 0 ? 0 : right;
+			}
+			a.x = std::clamp(a.x, 0.0f, right);
+			b.x = std::clamp(b.x, 0.0f, right);
+			AccumulateLine(a, b, right, height, stride);
+		}
+	}
+
+	// Вклад отрезка в ячейки строк, которые он пересекает.
+	void AccumulateLine(RasterPoint p0, RasterPoint p1, float right, int height, size_t stride)
+	{
+		if (p0.y == p1.y)
+		{
+			return;
+		}
+		float direction = 1;
+		if (p0.y > p1.y)
+		{
+			std::swap(p0, p1);
+			direction = -1;
+		}
+		const float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+		float x = p0.x;
+		if (p0.y < 0)
+		{
+			x -= p0.y * dxdy;
+		}
+		const float rows = static_cast<float>(height);
+		const int yEnd = static_cast<int>(std::clamp(std::ceil(p1.y), 0.0f, rows));
+		for (int y = static_cast<int>(std::clamp(p0.y, 0.0f, rows)); y < yEnd; ++y)
+		{
+			float* row = m_cells.data() + stride * y;
+			const float dy = std::min(static_cast<float>(y + 1), p1.y) - std::max(static_cast<float>(y), p0.y);
+			const float xNext = x + dxdy * dy;
+			const float d = dy * direction;
+			// Накопленная ошибка не должна выводить за границы строки.
+			const float x0 = std::clamp(std::min(x, xNext), 0.0f, right);
+			const float x1 = std::clamp(std::max(x, xNext), 0.0f, right);
+			const float x0Floor = std::floor(x0);
+			const int x0i = static_cast<int>(x0Floor);
+			const float x1Ceil = std::ceil(x1);
+			const int x1i = static_cast<int>(x1Ceil);
+			if (x1i <= x0i + 1)
+			{
+				const float xm = 0.5f * (x + xNext) - x0Floor;
+				row[x0i] += d - d * xm;
+				row[x0i + 1] += d * xm;
+			}
+			else
+			{
+				const float s = 1.0f / (x1 - x0);
+				const float x0f = x0 - x0Floor;
+				const float a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+				const float x1f = x1 - x1Ceil + 1;
+				const float am = 0.5f * s * x1f * x1f;
+				row[x0i] += d * a0;
+				if (x1i == x0i + 2)
+				{
+					row[x0i + 1] += d * (1 - a0 - am);
+				}
+				else
+				{
+					const float a1 = s * (1.5f - x0f);
+					row[x0i + 1] += d * (a1 - a0);
+					for (int xi = x0i + 2; xi < x1i - 1; ++xi)
+					{
+						row[xi] += d * s;
+					}
+					const float a2 = a1 + static_cast<float>(x1i - x0i - 3) * s;
+					row[x1i - 1] += d * (1 - a2 - am);
+				}
+				row[x1i] += d * am;
+			}
+			x = xNext;
+		}
+	}
+
+	// Полностью покрытые отрезки строки непрозрачным цветом заполняются
+	// через std::fill_n, который компилятор разворачивает в векторные записи;
+	// остальные пиксели смешиваются с учётом покрытия.
+	static void BlendSpan(RGBAColor* dst, const float* coverage, int count, RGBAColor color)
+	{
+		const uint32_t alpha = color & 0xFF;
+		for (int x = 0; x < count;)
+		{
+			if (alpha == 0xFF && coverage[x] >= 1.0f)
+			{
+				int end = x + 1;
+				while (end < count && coverage[end] >= 1.0f)
+				{
+					++end;
+				}
+				std::fill_n(dst + x, end - x, color);
+				x = end;
+				continue;
+			}
+			const uint32_t a = static_cast<uint32_t>(coverage[x] * static_cast<float>(alpha) + 0.5f);
+			if (a != 0)
+			{
+				dst[x] = Blend(dst[x], color, a);
+			}
+			++x;
+		}
+	}
+
+	static RGBAColor Blend(RGBAColor dst, RGBAColor src, uint32_t alpha)
+	{
+		const uint32_t inverse = 255 - alpha;
+		RGBAColor result = alpha + ((dst & 0xFF) * inverse + 127) / 255;
+		for (int shift = 8; shift < 32; shift += 8)
+		{
+			const uint32_t s = src >> shift & 0xFF;
+			const uint32_t d = dst >> shift & 0xFF;
+			result |= ((s * alpha + d * inverse + 127) / 255) << shift;
+		}
+		return result;
+	}
+
+	std::vector<std::pair<RasterPoint, RasterPoint>> m_segments;
+	float m_minX = INFINITY;
+	float m_minY = INFINITY;
+	float m_maxX = -INFINITY;
+	float m_maxY = -INFINITY;
+	std::vector<float> m_cells;
+	std::vector<float> m_coverage;
+};
+
+// ICanvas без окна: фигуры растеризуются в RasterImage со сглаживанием.
+// Координаты и толщина линий умножаются на scale, что удобно для миниатюр.
+// Как и у SFMLCanvas, контур эллипса лежит снаружи, а контур пути —
+// по обе стороны от линии.
+class RasterCanvas final : public ICanvas
+{
+public:
+	explicit RasterCanvas(RasterImage& image, double scale = 1.0)
+		: m_image(image)
+		, m_scale(static_cast<float>(scale))
+	{
+	}
+
+	void SetLineColor(RGBAColor color) override
+	{
+		m_lineColor = color;
+	}
+
+	void BeginFill(RGBAColor color) override
+	{
+		m_fillColor = color;
+	}
+
+	void EndFill() override
+	{
+		if (m_path.size() >= 3)
+		{
+			m_rasterizer.AddContour(m_path);
+			m_rasterizer.Fill(m_image, m_fillColor);
+		}
+
+		if (m_path.size() >= 2 && (m_lineColor & 0xFF) != 0)
+		{
+			for (size_t i = 0; i < m_path.size(); ++i)
+			{
+				AddStroke(m_path[i], m_path[(i + 1) % m_path.size()]);
+			}
+			m_rasterizer.Fill(m_image, m_lineColor);
+		}
+
+		m_path.clear();
+	}
+
+	void MoveTo(double x, double y) override
+	{
+		m_path.clear();
+		m_path.push_back(Transform(x, y));
+	}
+
+	void LineTo(double x, double y) override
+	{
+		m_path.push_back(Transform(x, y));
+	}
+
+	void DrawEllipse(
+		double left, double top, double width, double height) override
+	{
+		const RasterPoint center = Transform(left + width / 2, top + height / 2);
+		const float radiusX = static_cast<float>(width / 2) * m_scale;
+		const float radiusY = static_cast<float>(height / 2) * m_scale;
+		const float lineWidth = static_cast<float>(m_lineWidth) * m_scale;
+		const size_t pointCount = GetEllipsePointCount(std::max(radiusX, radiusY) + lineWidth);
+
+		std::vector<RasterPoint> inner = GetEllipsePoints(center, radiusX, radiusY, pointCount);
+		m_rasterizer.AddContour(inner);
+		m_rasterizer.Fill(m_image, m_fillColor);
+
+		if ((m_lineColor & 0xFF) != 0)
+		{
+			// Кольцо: внешний контур и внутренний, обойдённый в обратную сторону.
+			std::reverse(inner.begin(), inner.end());
+			m_rasterizer.AddContour(GetEllipsePoints(center, radiusX + lineWidth, radiusY + lineWidth, pointCount));
+			m_rasterizer.AddContour(inner);
+			m_rasterizer.Fill(m_image, m_lineColor);
+		}
+	}
+
+	void SetLineWidth(int width) override
+	{
+		m_lineWidth = std::max(1, width);
+	}
+
+private:
+	RasterPoint Transform(double x, double y) const
+	{
+		return { static_cast<float>(x) * m_scale, static_cast<float>(y) * m_scale };
+	}
+
+	// Столько точек, чтобы хорда отходила от дуги не больше чем на десятую
+	// пикселя.
+	static size_t GetEllipsePointCount(float radius)
+	{
+		constexpr float k_maxDeviation = 0.1f;
+		if (radius <= k_maxDeviation)
+		{
+			return 8;
+		}
+		const double step = std::acos(1.0 - k_maxDeviation / radius);
+		return std::clamp(static_cast<size_t>(std::ceil(M_PI / step)), size_t{ 8 }, size_t{ 1024 });
+	}
+
+	static std::vector<RasterPoint> GetEllipsePoints(
+		RasterPoint center, float radiusX, float radiusY, size_t count)
+	{
+		std::vector<RasterPoint> points;
+		points.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const double angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(count);
+			points.push_back({ center.x + radiusX * static_cast<float>(std::cos(angle)),
+				center.y + radiusY * static_cast<float>(std::sin(angle)) });
+		}
+		return points;
+	}
+
+	// Отрезок толщиной в линию с продлёнными на полтолщины концами. Все
+	// прямоугольники обходятся в одну сторону, поэтому на стыках их покрытие
+	// складывается, а не вычитается.
+	void AddStroke(RasterPoint from, RasterPoint to)
+	{
+		const float dx = to.x - from.x;
+		const float dy = to.y - from.y;
+		const float length = std::sqrt(dx * dx + dy * dy);
+		if (length == 0)
+		{
+			return;
+		}
+		const float halfWidth = static_cast<float>(m_lineWidth) * m_scale / 2;
+		const float alongX = dx / length * halfWidth;
+		const float alongY = dy / length * halfWidth;
+		const RasterPoint start{ from.x - alongX, from.y - alongY };
+		const RasterPoint end{ to.x + alongX, to.y + alongY };
+		m_rasterizer.AddContour({ { start.x - alongY, start.y + alongX },
+			{ end.x - alongY, end.y + alongX },
+			{ end.x + alongY, end.y - alongX },
+			{ start.x + alongY, start.y - alongX } });
+	}
+
+	RasterImage& m_image;
+	float m_scale;
+	CoverageRasterizer m_rasterizer;
+	std::vector<RasterPoint> m_path;
+	RGBAColor m_fillColor = 0;
+	RGBAColor m_lineColor = 0;
+	int m_lineWidth = 1;
+};
+
+#endif // OOD_RASTERCANVAS_H
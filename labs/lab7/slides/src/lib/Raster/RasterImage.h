@@ -0,0 +1,202 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#ifndef OOD_RASTERIMAGE_H
+#define OOD_RASTERIMAGE_H
+#include "../CommonTypes.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Изображение в памяти, пиксели — RGBAColor (0xRRGGBBAA) построчно.
+class RasterImage
+{
+public:
+	RasterImage(int width, int height, RGBAColor background)
+		: m_width(std::max(width, 0))
+		, m_height(std::max(height, 0))
+		, m_pixels(static_cast<size_t>(m_width) * m_height, background)
+	{
+	}
+
+	int GetWidth() const
+	{
+		return m_width;
+	}
+
+	int GetHeight() const
+	{
+		return m_height;
+	}
+
+	RGBAColor GetPixel(int x, int y) const
+	{
+		return m_pixels[static_cast<size_t>(y) * m_width + x];
+	}
+
+	std::span<RGBAColor> GetRow(int y)
+	{
+		return { m_pixels.data() + static_cast<size_t>(y) * m_width, static_cast<size_t>(m_width) };
+	}
+
+	std::span<const RGBAColor> GetRow(int y) const
+	{
+		return { m_pixels.data() + static_cast<size_t>(y) * m_width, static_cast<size_t>(m_width) };
+	}
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<RGBAColor> m_pixels;
+};
+
+enum class RasterFormat
+{
+	// P6, альфа отбрасывается.
+	Ppm,
+	// RGBA без сжатия: данные zlib лежат несжатыми блоками deflate.
+	Png,
+};
+
+inline void WritePpm(const RasterImage& image, std::ostream& out)
+{
+	out << "P6\n" << image.GetWidth() << " " << image.GetHeight() << "\n255\n";
+	std::vector<char> row(static_cast<size_t>(image.GetWidth()) * 3);
+	for (int y = 0; y < image.GetHeight(); ++y)
+	{
+		char* dst = row.data();
+		for (RGBAColor c : image.GetRow(y))
+		{
+			*dst++ = static_cast<char>(c >> 24 & 0xFF);
+			*dst++ = static_cast<char>(c >> 16 & 0xFF);
+			*dst++ = static_cast<char>(c >> 8 & 0xFF);
+		}
+		out.write(row.data(), static_cast<std::streamsize>(row.size()));
+	}
+}
+
+inline uint32_t UpdatePngCrc(uint32_t crc, const uint8_t* data, size_t size)
+{
+	static const std::array<uint32_t, 256> table = [] {
+		std::array<uint32_t, 256> result{};
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+			{
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			result[n] = c;
+		}
+		return result;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+inline void AppendPngUint32(std::vector<uint8_t>& out, uint32_t value)
+{
+	out.push_back(static_cast<uint8_t>(value >> 24));
+	out.push_back(static_cast<uint8_t>(value >> 16));
+	out.push_back(static_cast<uint8_t>(value >> 8));
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+inline void WritePngChunk(std::ostream& out, const char (&type)[5], const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	chunk.reserve(data.size() + 12);
+	AppendPngUint32(chunk, static_cast<uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	AppendPngUint32(chunk, UpdatePngCrc(0, chunk.data() + 4, chunk.size() - 4));
+	out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+inline void WritePng(const RasterImage& image, std::ostream& out)
+{
+	constexpr size_t k_maxStoredBlock = 0xFFFF;
+	static const char k_signature[] = "\x89PNG\r\n\x1A\n";
+	out.write(k_signature, 8);
+
+	std::vector<uint8_t> header;
+	AppendPngUint32(header, static_cast<uint32_t>(image.GetWidth()));
+	AppendPngUint32(header, static_cast<uint32_t>(image.GetHeight()));
+	// 8 бит на канал, RGBA, без чересстрочности.
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });
+	WritePngChunk(out, "IHDR", header);
+
+	// Каждая строка начинается с типа фильтра 0.
+	std::vector<uint8_t> raw;
+	raw.reserve(static_cast<size_t>(image.GetHeight()) * (static_cast<size_t>(image.GetWidth()) * 4 + 1));
+	for (int y = 0; y < image.GetHeight(); ++y)
+	{
+		raw.push_back(0);
+		for (RGBAColor c : image.GetRow(y))
+		{
+			AppendPngUint32(raw, c);
+		}
+	}
+
+	std::vector<uint8_t> data{ 0x78, 0x01 };
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	size_t offset = 0;
+	do
+	{
+		const size_t size = std::min(k_maxStoredBlock, raw.size() - offset);
+		const bool isLast = offset + size == raw.size();
+		data.push_back(isLast ? 1 : 0);
+		data.push_back(static_cast<uint8_t>(size));
+		data.push_back(static_cast<uint8_t>(size >> 8));
+		data.push_back(static_cast<uint8_t>(~size));
+		data.push_back(static_cast<uint8_t>(~size >> 8));
+		for (size_t i = offset; i < offset + size; ++i)
+		{
+			adlerA = (adlerA + raw[i]) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		data.insert(data.end(), raw.begin() + static_cast<std::ptrdiff_t>(offset),
+			raw.begin() + static_cast<std::ptrdiff_t>(offset + size));
+		offset += size;
+	} while (offset < raw.size());
+	AppendPngUint32(data, adlerB << 16 | adlerA);
+	WritePngChunk(out, "IDAT", data);
+	WritePngChunk(out, "IEND", {});
+}
+
+inline void SaveImage(const RasterImage& image, const std::string& path, RasterFormat format)
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+	if (format == RasterFormat::Ppm)
+	{
+		WritePpm(image, out);
+	}
+	else
+	{
+		WritePng(image, out);
+	}
+	if (!out.flush())
+	{
+		throw std::runtime_error("Failed to write file: " + path);
+	}
+}
+
+#endif // OOD_RASTERIMAGE_H
@@ -0,0 +1,174 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#ifndef OOD_THUMBNAILRENDERER_H
+#define OOD_THUMBNAILRENDERER_H
+#include "../Shapes/IShape.h"
+#include "RasterCanvas.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct ThumbnailOptions
+{
+	int width = 320;
+	int height = 240;
+	// Во сколько раз миниатюра меньше слайда.
+	double scale = 0.25;
+	RGBAColor background = 0xFFFFFFFF;
+};
+
+// Рисует каждый слайд в своё изображение. Потоки запускаются один раз в
+// конструкторе и ждут следующего вызова Render, так что повторная отрисовка
+// (например, после каждой правки) не платит за создание потоков. Вызывающий
+// поток тоже рисует, поэтому для n потоков запускается n - 1.
+// Слайды разбираются потоками по одному, у каждого слайда свой
+// RasterCanvas; сами слайды только читаются и не должны меняться во время
+// отрисовки. Первое исключение пробрасывается из Render после того, как все
+// потоки закончат. Render вызывается из одного потока.
+class ThumbnailRenderer
+{
+public:
+	// 0 — по числу ядер.
+	explicit ThumbnailRenderer(unsigned threadCount = 0)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		for (unsigned i = 1; i < threadCount; ++i)
+		{
+			m_threads.emplace_back([this] { Work(); });
+		}
+	}
+
+	ThumbnailRenderer(const ThumbnailRenderer&) = delete;
+	ThumbnailRenderer& operator=(const ThumbnailRenderer&) = delete;
+
+	~ThumbnailRenderer()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_changed.notify_all();
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	size_t GetThreadCount() const
+	{
+		return m_threads.size() + 1;
+	}
+
+	std::vector<RasterImage> Render(
+		const std::vector<std::shared_ptr<const IDrawable>>& slides, const ThumbnailOptions& options = {})
+	{
+		std::vector<RasterImage> images(slides.size(),
+			RasterImage(options.width, options.height, options.background));
+		if (slides.empty())
+		{
+			return images;
+		}
+
+		std::unique_lock lock(m_mutex);
+		m_slides = &slides;
+		m_images = &images;
+		m_scale = options.scale;
+		m_next = 0;
+		m_changed.notify_all();
+
+		DrawSlides(lock);
+		m_finished.wait(lock, [&] { return m_active == 0; });
+
+		m_slides = nullptr;
+		m_images = nullptr;
+		m_next = 0;
+		if (auto error = std::exchange(m_error, nullptr))
+		{
+			std::rethrow_exception(error);
+		}
+		return images;
+	}
+
+private:
+	void Work()
+	{
+		std::unique_lock lock(m_mutex);
+		while (true)
+		{
+			m_changed.wait(lock, [&] { return m_isStopped || GetSlidesLeft() > 0; });
+			if (m_isStopped)
+			{
+				return;
+			}
+			DrawSlides(lock);
+		}
+	}
+
+	size_t GetSlidesLeft() const
+	{
+		return m_slides ? m_slides->size() - m_next : 0;
+	}
+
+	// Берёт слайды, пока они не кончатся; на время отрисовки мьютекс
+	// отпускается.
+	void DrawSlides(std::unique_lock<std::mutex>& lock)
+	{
+		while (GetSlidesLeft() > 0)
+		{
+			const size_t index = m_next++;
+			const IDrawable& slide = *(*m_slides)[index];
+			RasterImage& image = (*m_images)[index];
+			const double scale = m_scale;
+			++m_active;
+			lock.unlock();
+			std::exception_ptr error;
+			try
+			{
+				RasterCanvas canvas(image, scale);
+				slide.Draw(canvas);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			lock.lock();
+			--m_active;
+			if (error && !m_error)
+			{
+				m_error = error;
+				m_next = m_slides->size();
+			}
+		}
+		if (m_active == 0)
+		{
+			m_finished.notify_all();
+		}
+	}
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::condition_variable m_finished;
+	// Текущий вызов Render; между вызовами пусто.
+	const std::vector<std::shared_ptr<const IDrawable>>* m_slides = nullptr;
+	std::vector<RasterImage>* m_images = nullptr;
+	double m_scale = 1;
+	size_t m_next = 0;
+	size_t m_active = 0;
+	std::exception_ptr m_error;
+	bool m_isStopped = false;
+};
+
+#endif // OOD_THUMBNAILRENDERER_H
@@ -0,0 +1,469 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#ifndef OOD_SHAPEBATCH_H
+#define OOD_SHAPEBATCH_H
+#include "AabbTree.h"
+#include "Canvas.h"
+#include "Shapes/IShape.h"
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Сцена, которая хранит вершины всех фигур в одном буфере между кадрами.
+// Фигуры раскладываются на треугольники через TessellatingCanvas один раз;
+// заново раскладываются только те, что сообщили об изменении содержимого, а их
+// вершины обновляются в буфере на месте, если число вершин не изменилось.
+// Группы разворачиваются в свои простые фигуры: у каждой своя запись и свои
+// границы, поэтому изменение одной фигуры группы не раскладывает остальные.
+// Границы вершин каждой фигуры хранятся в AabbTree, и в кадр попадают
+// только фигуры, видимые в текущем виде; соседние в буфере видимые фигуры
+// рисуются одним вызовом draw.
+class ShapeBatch final : private IShapeObserver
+{
+public:
+	ShapeBatch() = default;
+	ShapeBatch(const ShapeBatch&) = delete;
+	ShapeBatch& operator=(const ShapeBatch&) = delete;
+
+	~ShapeBatch()
+	{
+		for (const auto& [shape, indices] : m_indices)
+		{
+			(void)indices;
+			shape->RemoveObserver(*this);
+		}
+		for (const auto& [group, tops] : m_groups)
+		{
+			(void)tops;
+			group->RemoveObserver(*this);
+		}
+	}
+
+	void AddShape(const std::shared_ptr<IShape>& shape)
+	{
+		const size_t top = m_tops.size();
+		m_tops.push_back({ shape, m_entries.size(), 0 });
+		if (dynamic_cast<IGroupShape*>(shape.get()))
+		{
+			auto& tops = m_groups[shape.get()];
+			if (tops.empty())
+			{
+				shape->AddObserver(*this);
+			}
+			tops.push_back(top);
+		}
+		for (auto& leaf : CollectLeaves(shape))
+		{
+			AddEntry(std::move(leaf), { m_vertices.size(), 0 });
+		}
+		m_tops.back().count = m_entries.size() - m_tops.back().first;
+		m_isSizeChanged = true;
+	}
+
+	size_t GetShapesCount() const
+	{
+		return m_tops.size();
+	}
+
+	// Раскладывает изменившиеся простые фигуры. Возвращает их число.
+	size_t Update()
+	{
+		CheckChangedGroups();
+		if (m_dirty.empty())
+		{
+			if (m_isSizeChanged)
+			{
+				std::vector<std::vector<sf::Vertex>> none;
+				Rebuild({}, none);
+			}
+			return 0;
+		}
+		std::vector<size_t> dirty = std::move(m_dirty);
+		m_dirty.clear();
+		std::sort(dirty.begin(), dirty.end());
+
+		std::vector<std::vector<sf::Vertex>> tessellated(dirty.size());
+		for (size_t i = 0; i < dirty.size(); ++i)
+		{
+			Entry& entry = m_entries[dirty[i]];
+			TessellatingCanvas canvas(tessellated[i]);
+			entry.shape->Draw(canvas);
+			entry.isDirty = false;
+			UpdateBounds(dirty[i], tessellated[i]);
+			m_isSizeChanged = m_isSizeChanged || tessellated[i].size() != entry.count;
+		}
+
+		if (m_isSizeChanged)
+		{
+			Rebuild(dirty, tessellated);
+		}
+		else
+		{
+			for (size_t i = 0; i < dirty.size(); ++i)
+			{
+				const Entry& entry = m_entries[dirty[i]];
+				std::copy(tessellated[i].begin(), tessellated[i].end(),
+					m_vertices.begin() + static_cast<std::ptrdiff_t>(entry.offset));
+				RecordUpdatedRange({ entry.offset, entry.count });
+			}
+		}
+		return dirty.size();
+	}
+
+	const std::vector<sf::Vertex>& GetVertices() const
+	{
+		return m_vertices;
+	}
+
+	struct Range
+	{
+		size_t offset;
+		size_t count;
+	};
+
+	// Участки буфера с вершинами фигур, пересекающих viewport, в порядке
+	// рисования. Соседние участки склеиваются.
+	std::vector<Range> GetVisibleRanges(const RectD& viewport)
+	{
+		Update();
+		std::vector<size_t> visible;
+		m_index.Query(viewport, [&](size_t index) { visible.push_back(index); });
+		std::sort(visible.begin(), visible.end());
+
+		std::vector<Range> ranges;
+		for (size_t index : visible)
+		{
+			const Entry& entry = m_entries[index];
+			if (!ranges.empty() && ranges.back().offset + ranges.back().count == entry.offset)
+			{
+				ranges.back().count += entry.count;
+			}
+			else if (entry.count != 0)
+			{
+				ranges.push_back({ entry.offset, entry.count });
+			}
+		}
+		return ranges;
+	}
+
+	void Draw(sf::RenderTarget& target)
+	{
+		std::vector<Range> ranges = GetVisibleRanges(GetViewport(target.getView()));
+		// Много разрозненных участков дороже одного вызова для всего буфера.
+		if (ranges.size() > k_maxDrawCalls)
+		{
+			ranges = { { 0, m_vertices.size() } };
+		}
+
+		const bool useBuffer = sf::VertexBuffer::isAvailable();
+		if (useBuffer)
+		{
+			UploadToBuffer();
+		}
+		for (const Range& range : ranges)
+		{
+			if (useBuffer)
+			{
+				target.draw(m_buffer, range.offset, range.count);
+			}
+			else
+			{
+				target.draw(m_vertices.data() + range.offset, range.count, sf::Triangles);
+			}
+		}
+	}
+
+private:
+	static constexpr size_t k_maxDrawCalls = 16;
+
+	struct Entry
+	{
+		std::shared_ptr<IShape> shape;
+		size_t offset;
+		size_t count;
+		int leaf;
+		bool isDirty;
+	};
+
+	// Фигура, добавленная через AddShape, и её простые фигуры в m_entries.
+	struct TopShape
+	{
+		std::shared_ptr<IShape> shape;
+		size_t first;
+		size_t count;
+	};
+
+	// Простые фигуры в порядке рисования; вложенные группы тоже
+	// разворачиваются.
+	static std::vector<std::shared_ptr<IShape>> CollectLeaves(const std::shared_ptr<IShape>& shape)
+	{
+		std::vector<std::shared_ptr<IShape>> leaves;
+		std::vector<std::shared_ptr<IShape>> stack{ shape };
+		while (!stack.empty())
+		{
+			std::shared_ptr<IShape> current = std::move(stack.back());
+			stack.pop_back();
+			auto* group = dynamic_cast<IGroupShape*>(current.get());
+			if (!group)
+			{
+				leaves.push_back(std::move(current));
+				continue;
+			}
+			for (size_t i = group->GetShapesCount(); i-- > 0;)
+			{
+				stack.push_back(group->GetShapeAtIndex(i));
+			}
+		}
+		return leaves;
+	}
+
+	// Новая запись; без вершин она помечается для раскладки.
+	void AddEntry(std::shared_ptr<IShape> shape, const Range& vertices, int leaf = AabbTree<size_t>::k_nullNode)
+	{
+		const size_t index = m_entries.size();
+		auto& indices = m_indices[shape.get()];
+		if (indices.empty())
+		{
+			shape->AddObserver(*this);
+		}
+		indices.push_back(index);
+		const bool isDirty = leaf == AabbTree<size_t>::k_nullNode;
+		if (isDirty)
+		{
+			m_dirty.push_back(index);
+		}
+		m_entries.push_back({ std::move(shape), vertices.offset, vertices.count, leaf, isDirty });
+	}
+
+	// Группа сообщает и об изменении своих фигур, о котором те сообщили
+	// сами, и о вставке или удалении фигур. Второе видно только по составу:
+	// он сравнивается с записями группы, без раскладки.
+	void CheckChangedGroups()
+	{
+		bool isChanged = false;
+		for (size_t top : std::exchange(m_changedGroups, {}))
+		{
+			const TopShape& group = m_tops[top];
+			const auto leaves = CollectLeaves(group.shape);
+			isChanged = isChanged || leaves.size() != group.count
+				|| !std::equal(leaves.begin(), leaves.end(), m_entries.begin() + static_cast<std::ptrdiff_t>(group.first),
+					[](const std::shared_ptr<IShape>& leaf, const Entry& entry) { return leaf == entry.shape; });
+		}
+		if (isChanged)
+		{
+			Restructure();
+		}
+	}
+
+	// Собирает записи заново по текущему составу групп. Записи фигур, которые
+	// остались и не изменились, сохраняют вершины в старом буфере и границы,
+	// так что Rebuild только копирует их.
+	void Restructure()
+	{
+		std::vector<Entry> oldEntries = std::move(m_entries);
+		auto oldIndices = std::move(m_indices);
+		m_entries.clear();
+		m_indices.clear();
+		m_dirty.clear();
+
+		std::unordered_map<IShape*, size_t> taken;
+		for (TopShape& top : m_tops)
+		{
+			top.first = m_entries.size();
+			for (auto& leaf : CollectLeaves(top.shape))
+			{
+				const auto old = oldIndices.find(leaf.get());
+				size_t& next = taken[leaf.get()];
+				if (old != oldIndices.end() && next < old->second.size() && !oldEntries[old->second[next]].isDirty)
+				{
+					const Entry& previous = oldEntries[old->second[next++]];
+					const int node = m_index.Insert(m_index.GetBox(previous.leaf), m_entries.size());
+					AddEntry(std::move(leaf), { previous.offset, previous.count }, node);
+				}
+				else
+				{
+					AddEntry(std::move(leaf), { 0, 0 });
+				}
+			}
+			top.count = m_entries.size() - top.first;
+		}
+
+		for (const Entry& entry : oldEntries)
+		{
+			if (entry.leaf != AabbTree<size_t>::k_nullNode)
+			{
+				m_index.Remove(entry.leaf);
+			}
+		}
+		// AddEntry подписался на оставшиеся фигуры ещё раз, а наблюдатель
+		// добавляется столько раз, сколько его удаляют.
+		for (const auto& [shape, indices] : oldIndices)
+		{
+			(void)indices;
+			shape->RemoveObserver(*this);
+		}
+		m_isSizeChanged = true;
+	}
+
+	// Повёрнутый вид заменяется описанным вокруг него квадратом.
+	static RectD GetViewport(const sf::View& view)
+	{
+		const sf::Vector2f center = view.getCenter();
+		const sf::Vector2f size = view.getSize();
+		double halfWidth = std::abs(size.x) / 2;
+		double halfHeight = std::abs(size.y) / 2;
+		if (view.getRotation() != 0)
+		{
+			halfWidth = halfHeight = std::hypot(halfWidth, halfHeight);
+		}
+		return { center.x - halfWidth, center.y - halfHeight, 2 * halfWidth, 2 * halfHeight };
+	}
+
+	void UpdateBounds(size_t index, const std::vector<sf::Vertex>& vertices)
+	{
+		RectD box{ 0, 0, 0, 0 };
+		if (!vertices.empty())
+		{
+			float left = vertices.front().position.x;
+			float top = vertices.front().position.y;
+			float right = left;
+			float bottom = top;
+			for (const sf::Vertex& vertex : vertices)
+			{
+				left = std::min(left, vertex.position.x);
+				top = std::min(top, vertex.position.y);
+				right = std::max(right, vertex.position.x);
+				bottom = std::max(bottom, vertex.position.y);
+			}
+			box = { left, top, right - left, bottom - top };
+		}
+		Entry& entry = m_entries[index];
+		if (entry.leaf == AabbTree<size_t>::k_nullNode)
+		{
+			entry.leaf = m_index.Insert(box, index);
+		}
+		else
+		{
+			m_index.Move(entry.leaf, box);
+		}
+	}
+
+	// Рамка и стили сами по себе не важны: о любом изменении того, как
+	// фигура рисуется, сообщает OnShapeContentChanged.
+	void OnShapeChanged(IShape& shape) override
+	{
+		(void)shape;
+	}
+
+	void OnShapeContentChanged(IShape& shape) override
+	{
+		if (auto group = m_groups.find(&shape); group != m_groups.end())
+		{
+			m_changedGroups.insert(m_changedGroups.end(), group->second.begin(), group->second.end());
+			return;
+		}
+		for (size_t index : m_indices.at(&shape))
+		{
+			Entry& entry = m_entries[index];
+			if (!entry.isDirty)
+			{
+				entry.isDirty = true;
+				m_dirty.push_back(index);
+			}
+		}
+	}
+
+	// Собирает буфер заново: вершины неизменившихся фигур копируются из
+	// старого буфера без повторной раскладки.
+	void Rebuild(const std::vector<size_t>& dirty,
+		std::vector<std::vector<sf::Vertex>>& tessellated)
+	{
+		std::vector<sf::Vertex> vertices;
+		size_t nextDirty = 0;
+		for (size_t index = 0; index < m_entries.size(); ++index)
+		{
+			Entry& entry = m_entries[index];
+			const size_t offset = vertices.size();
+			if (nextDirty < dirty.size() && dirty[nextDirty] == index)
+			{
+				vertices.insert(vertices.end(), tessellated[nextDirty].begin(),
+					tessellated[nextDirty].end());
+				++nextDirty;
+			}
+			else
+			{
+				const auto begin = m_vertices.begin() + static_cast<std::ptrdiff_t>(entry.offset);
+				vertices.insert(vertices.end(), begin, begin + static_cast<std::ptrdiff_t>(entry.count));
+			}
+			entry.offset = offset;
+			entry.count = vertices.size() - offset;
+		}
+		m_vertices = std::move(vertices);
+		m_isSizeChanged = false;
+		m_isBufferStale = true;
+		m_updatedRanges.clear();
+	}
+
+	// Участки запоминаются, только пока буфер совпадает с m_vertices; без
+	// буфера (VertexBuffer недоступен или ещё не создан) догонять нечего.
+	// Если участков набралось больше, чем фигур, дешевле загрузить всё заново.
+	void RecordUpdatedRange(const Range& range)
+	{
+		if (m_isBufferStale)
+		{
+			return;
+		}
+		if (m_updatedRanges.size() >= m_entries.size())
+		{
+			m_updatedRanges.clear();
+			m_isBufferStale = true;
+			return;
+		}
+		m_updatedRanges.push_back(range);
+	}
+
+	void UploadToBuffer()
+	{
+		if (m_isBufferStale)
+		{
+			m_buffer.create(m_vertices.size());
+			m_buffer.update(m_vertices.data());
+			m_isBufferStale = false;
+		}
+		else
+		{
+			for (const Range& range : m_updatedRanges)
+			{
+				m_buffer.update(m_vertices.data() + range.offset, range.count,
+					static_cast<unsigned>(range.offset));
+			}
+		}
+		m_updatedRanges.clear();
+	}
+
+	std::vector<TopShape> m_tops;
+	// Группы из m_tops: вложенные сообщают об изменениях через них.
+	std::unordered_map<IShape*, std::vector<size_t>> m_groups;
+	std::vector<size_t> m_changedGroups;
+	std::vector<Entry> m_entries;
+	std::vector<size_t> m_dirty;
+	// Значение листа — номер фигуры в m_entries.
+	AabbTree<size_t> m_index;
+	// Одна фигура может встречаться в нескольких записях.
+	std::unordered_map<IShape*, std::vector<size_t>> m_indices;
+	std::vector<sf::Vertex> m_vertices;
+	sf::VertexBuffer m_buffer{ sf::Triangles, sf::VertexBuffer::Dynamic };
+	std::vector<Range> m_updatedRanges;
+	bool m_isSizeChanged = false;
+	bool m_isBufferStale = true;
+};
+
+#endif // OOD_SHAPEBATCH_H
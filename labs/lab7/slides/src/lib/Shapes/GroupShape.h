@@ -4,17 +4,35 @@
 
 #ifndef OOD_GROUPSHAPE_H
 #define OOD_GROUPSHAPE_H
+#include "../AabbTree.h"
 #include "IShape.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <limits>
+#include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
-class GroupShape final : public IGroupShape
+// Рамка и общие стили группы не пересчитываются обходом всех фигур: группа
+// хранит вклад каждой фигуры в счётчиках и обновляет их за O(log n) при
+// вставке, удалении и уведомлении от изменившейся фигуры. Об изменении
+// рамки или стилей группа сообщает, только если они действительно
+// изменились, а об изменении содержимого — всегда.
+// Рамки фигур хранятся ещё и в AabbTree: по нему группа рисует только
+// фигуры в области видимости и ищет фигуру под точкой, не обходя остальные.
+// Лист дерева знает свою фигуру и её место в порядке рисования. Места —
+// числа с промежутками: вставка в середину берёт середину промежутка между
+// соседями и не трогает остальные листья. Только когда промежуток
+// исчерпан, места всех листьев раздаются заново.
+class GroupShape final
+	: public IGroupShape
+	, private IShapeObserver
 {
 	class GroupStyle final : public IStyle
 	{
@@ -70,24 +88,160 @@ class GroupShape final : public IGroupShape
 		std::optional<RGBAColor> m_color;
 	};
 
+	// Вклад одной фигуры в рамку и стили группы.
+	struct ShapeSummary
+	{
+		RectD frame;
+		std::optional<RGBAColor> outlineColor;
+		std::optional<bool> outlineEnabled;
+		std::optional<RGBAColor> fillColor;
+		std::optional<bool> fillEnabled;
+		std::optional<int> outlineThickness;
+	};
+
+	// Сколько фигур дали каждое значение. Общее значение есть, только если
+	// все фигуры дали одно и то же.
+	template <typename T>
+	class ValueCounter
+	{
+	public:
+		void Add(const std::optional<T>& value)
+		{
+			++m_counts[value];
+		}
+
+		void Remove(const std::optional<T>& value)
+		{
+			auto it = m_counts.find(value);
+			if (--it->second == 0)
+			{
+				m_counts.erase(it);
+			}
+		}
+
+		std::optional<T> GetCommon() const
+		{
+			return m_counts.size() == 1 ? m_counts.begin()->first : std::nullopt;
+		}
+
+	private:
+		std::map<std::optional<T>, size_t> m_counts;
+	};
+
+	class FrameBounds
+	{
+	public:
+		void Add(const RectD& frame)
+		{
+			m_lefts.insert(frame.left);
+			m_tops.insert(frame.top);
+			m_rights.insert(frame.left + frame.width);
+			m_bottoms.insert(frame.top + frame.height);
+		}
+
+		void Remove(const RectD& frame)
+		{
+			m_lefts.erase(m_lefts.find(frame.left));
+			m_tops.erase(m_tops.find(frame.top));
+			m_rights.erase(m_rights.find(frame.left + frame.width));
+			m_bottoms.erase(m_bottoms.find(frame.top + frame.height));
+		}
+
+		RectD Get() const
+		{
+			const double left = *m_lefts.begin();
+			const double top = *m_tops.begin();
+			return { left, top, *m_rights.rbegin() - left, *m_bottoms.rbegin() - top };
+		}
+
+	private:
+		std::multiset<double> m_lefts;
+		std::multiset<double> m_tops;
+		std::multiset<double> m_rights;
+		std::multiset<double> m_bottoms;
+	};
+
+	struct Aggregates
+	{
+		FrameBounds frame;
+		ValueCounter<RGBAColor> outlineColor;
+		ValueCounter<bool> outlineEnabled;
+		ValueCounter<RGBAColor> fillColor;
+		ValueCounter<bool> fillEnabled;
+		ValueCounter<int> outlineThickness;
+
+		void Add(const ShapeSummary& summary)
+		{
+			frame.Add(summary.frame);
+			outlineColor.Add(summary.outlineColor);
+			outlineEnabled.Add(summary.outlineEnabled);
+			fillColor.Add(summary.fillColor);
+			fillEnabled.Add(summary.fillEnabled);
+			outlineThickness.Add(summary.outlineThickness);
+		}
+
+		void Remove(const ShapeSummary& summary)
+		{
+			frame.Remove(summary.frame);
+			outlineColor.Remove(summary.outlineColor);
+			outlineEnabled.Remove(summary.outlineEnabled);
+			fillColor.Remove(summary.fillColor);
+			fillEnabled.Remove(summary.fillEnabled);
+			outlineThickness.Remove(summary.outlineThickness);
+		}
+	};
+
+	// Одна и та же фигура может входить в группу несколько раз, но
+	// подписывается группа на неё один раз. Каждое вхождение — свой лист
+	// в дереве рамок.
+	struct ChildRecord
+	{
+		ShapeSummary summary;
+		std::vector<int> leaves;
+	};
+
+	struct IndexEntry
+	{
+		uint64_t order = 0;
+		std::shared_ptr<IShape> shape;
+	};
+
 public:
 	GroupShape()
 	{
-		m_outlineStyle = std::make_shared<GroupStyle>(
-			[this](const std::function<void(IStyle&)>& fn) {
-				for (const auto& shape : m_shapes)
-				{
-					fn(shape->GetOutlineStyle());
-				}
-			});
+		CreateStyles();
+	}
 
-		m_fillStyle = std::make_shared<GroupStyle>(
-			[this](const std::function<void(IStyle&)>& fn) {
-				for (const auto& shape : m_shapes)
-				{
-					fn(shape->GetFillStyle());
-				}
-			});
+	GroupShape(const GroupShape& other)
+		: m_shapes(other.m_shapes)
+		, m_children(other.m_children)
+		, m_aggregates(other.m_aggregates)
+		, m_index(other.m_index)
+		, m_leaves(other.m_leaves)
+		, m_frame(other.m_frame)
+		, m_outlineThickness(other.m_outlineThickness)
+	{
+		CreateStyles();
+		m_outlineStyle->SetCachedColor(other.m_outlineStyle->GetColor());
+		m_outlineStyle->SetCachedEnabled(other.m_outlineStyle->IsEnabled());
+		m_fillStyle->SetCachedColor(other.m_fillStyle->GetColor());
+		m_fillStyle->SetCachedEnabled(other.m_fillStyle->IsEnabled());
+		for (const auto& [shape, record] : m_children)
+		{
+			(void)record;
+			shape->AddObserver(*this);
+		}
+	}
+
+	GroupShape& operator=(const GroupShape&) = delete;
+
+	~GroupShape() override
+	{
+		for (const auto& [shape, record] : m_children)
+		{
+			(void)record;
+			shape->RemoveObserver(*this);
+		}
 	}
 
 	void Draw(ICanvas& canvas) const override
@@ -98,6 +252,18 @@ public:
 		}
 	}
 
+	void DrawVisible(ICanvas& canvas, const RectD& viewport) const override
+	{
+		std::vector<const IndexEntry*> visible;
+		m_index.Query(viewport, [&](const IndexEntry& entry) { visible.push_back(&entry); });
+		std::sort(visible.begin(), visible.end(),
+			[](const IndexEntry* a, const IndexEntry* b) { return a->order < b->order; });
+		for (const IndexEntry* entry : visible)
+		{
+			entry->shape->DrawVisible(canvas, viewport);
+		}
+	}
+
 	RectD GetFrame() const override
 	{
 		return m_frame;
@@ -108,25 +274,26 @@ public:
 		if (m_shapes.empty())
 		{
 			m_frame = rect;
+			NotifyChanged();
 			return;
 		}
 
 		double scaleX = m_frame.width == 0 ? 0 : rect.width / m_frame.width;
 		double scaleY = m_frame.height == 0 ? 0 : rect.height / m_frame.height;
 
-		for (auto& shape : m_shapes)
-		{
-			RectD oldShapeFrame = shape->GetFrame();
+		UpdateShapes([&](IShape& shape) {
+			RectD oldShapeFrame = shape.GetFrame();
 			double newX
 				= rect.left + (oldShapeFrame.left - m_frame.left) * scaleX;
 			double newY = rect.top + (oldShapeFrame.top - m_frame.top) * scaleY;
 			double newWidth = oldShapeFrame.width * scaleX;
 			double newHeight = oldShapeFrame.height * scaleY;
 
-			shape->SetFrame({ newX, newY, newWidth, newHeight });
-		}
+			shape.SetFrame({ newX, newY, newWidth, newHeight });
+		});
 
 		m_frame = rect;
+		NotifyChanged();
 	}
 
 	IStyle& GetOutlineStyle() override
@@ -171,11 +338,11 @@ public:
 
 	void SetOutlineThickness(int thickness) override
 	{
-		for (auto& shape : m_shapes)
-		{
-			shape->SetOutlineThickness(thickness);
-		}
 		m_outlineThickness = thickness;
+		UpdateShapes([thickness](IShape& shape) {
+			shape.SetOutlineThickness(thickness);
+		});
+		NotifyChanged();
 	}
 
 	std::optional<int> GetOutlineThickness() const override
@@ -201,18 +368,11 @@ public:
 	void InsertShape(const std::shared_ptr<IShape>& shape,
 		size_t position = std::numeric_limits<size_t>::max()) override
 	{
-		if (position >= m_shapes.size())
-		{
-			m_shapes.push_back(shape);
-		}
-		else
-		{
-			m_shapes.insert(m_shapes.begin() + position, shape);
-		}
-
-		RecalculateFrame();
-		UpdateStyles();
-		UpdateOutlineThickness();
+		position = std::min(position, m_shapes.size());
+		m_shapes.insert(m_shapes.begin() + static_cast<std::ptrdiff_t>(position), shape);
+		AddChild(position);
+		Refresh();
+		m_observers.NotifyContentChanged(*this);
 	}
 
 	std::shared_ptr<IShape> GetShapeAtIndex(size_t index) override
@@ -224,10 +384,22 @@ public:
 	void RemoveShapeAtIndex(size_t index) override
 	{
 		ValidateIndex(index);
-		m_shapes.erase(m_shapes.begin() + index);
-		RecalculateFrame();
-		UpdateStyles();
-		UpdateOutlineThickness();
+		RemoveChild(index);
+		Refresh();
+		m_observers.NotifyContentChanged(*this);
+	}
+
+	std::shared_ptr<IShape> GetShapeAtPoint(double x, double y) override
+	{
+		const IndexEntry* topmost = nullptr;
+		m_index.QueryPoint(x, y, [&](const IndexEntry& entry) {
+			if ((!topmost || entry.order > topmost->order)
+				&& AabbTree<IndexEntry>::Contains(entry.shape->GetFrame(), x, y))
+			{
+				topmost = &entry;
+			}
+		});
+		return topmost ? topmost->shape : nullptr;
 	}
 
 	std::shared_ptr<IShape> Clone() override
@@ -240,7 +412,36 @@ public:
 		return newGroup;
 	}
 
+	void AddObserver(IShapeObserver& observer) override
+	{
+		m_observers.Add(observer);
+	}
+
+	void RemoveObserver(IShapeObserver& observer) override
+	{
+		m_observers.Remove(observer);
+	}
+
 private:
+	void CreateStyles()
+	{
+		m_outlineStyle = std::make_shared<GroupStyle>(
+			[this](const std::function<void(IStyle&)>& fn) {
+				UpdateShapes([&](IShape& shape) {
+					fn(shape.GetOutlineStyle());
+				});
+				NotifyChanged();
+			});
+
+		m_fillStyle = std::make_shared<GroupStyle>(
+			[this](const std::function<void(IStyle&)>& fn) {
+				UpdateShapes([&](IShape& shape) {
+					fn(shape.GetFillStyle());
+				});
+				NotifyChanged();
+			});
+	}
+
 	void ValidateIndex(size_t index) const
 	{
 		if (index >= m_shapes.size())
@@ -249,102 +450,192 @@ private:
 		}
 	}
 
-	void RecalculateFrame()
+	static ShapeSummary Summarize(const IShape& shape)
 	{
-		if (m_shapes.empty())
-		{
-			m_frame = { 0, 0, 0, 0 };
-			return;
-		}
+		const IStyle& outline = shape.GetOutlineStyle();
+		const IStyle& fill = shape.GetFillStyle();
+		return { shape.GetFrame(), outline.GetColor(), outline.IsEnabled(),
+			fill.GetColor(), fill.IsEnabled(), shape.GetOutlineThickness() };
+	}
 
-		double minX = std::numeric_limits<double>::max();
-		double minY = std::numeric_limits<double>::max();
-		double maxX = std::numeric_limits<double>::lowest();
-		double maxY = std::numeric_limits<double>::lowest();
+	// Контур может выходить за рамку, поэтому в дерево кладётся рамка,
+	// расширенная на толщину линии.
+	static RectD GetIndexBox(const ShapeSummary& summary)
+	{
+		const double margin = std::max(summary.outlineThickness.value_or(0), 0);
+		const RectD& frame = summary.frame;
+		return { frame.left - margin, frame.top - margin,
+			frame.width + 2 * margin, frame.height + 2 * margin };
+	}
 
-		for (const auto& shape : m_shapes)
+	// Фигура уже вставлена в m_shapes на место position.
+	void AddChild(size_t position)
+	{
+		IShape& shape = *m_shapes[position];
+		auto [it, isNew] = m_children.try_emplace(&shape, ChildRecord{ Summarize(shape), {} });
+		if (isNew)
 		{
-			RectD frame = shape->GetFrame();
-			if (frame.left < minX)
-				minX = frame.left;
-			if (frame.top < minY)
-				minY = frame.top;
-			if (frame.left + frame.width > maxX)
-				maxX = frame.left + frame.width;
-			if (frame.top + frame.height > maxY)
-				maxY = frame.top + frame.height;
+			shape.AddObserver(*this);
 		}
+		ChildRecord& record = it->second;
+		m_aggregates.Add(record.summary);
 
-		m_frame = { minX, minY, maxX - minX, maxY - minY };
+		const int leaf = m_index.Insert(GetIndexBox(record.summary), { 0, m_shapes[position] });
+		record.leaves.push_back(leaf);
+		m_leaves.insert(m_leaves.begin() + static_cast<std::ptrdiff_t>(position), leaf);
+		AssignOrder(position);
 	}
 
-	void UpdateStyles()
+	void RemoveChild(size_t position)
 	{
-		auto updateStyle = [&](std::shared_ptr<GroupStyle>& groupStyle,
-							   bool isOutline) {
-			if (m_shapes.empty())
-			{
-				groupStyle->SetCachedColor(std::nullopt);
-				groupStyle->SetCachedEnabled(std::nullopt);
-				return;
-			}
-
-			auto getStyle
-				= [&](const std::shared_ptr<IShape>& s) -> const IStyle& {
-				return isOutline ? s->GetOutlineStyle() : s->GetFillStyle();
-			};
+		const std::shared_ptr<IShape> shape = m_shapes[position];
+		auto it = m_children.find(shape.get());
+		ChildRecord& record = it->second;
+		m_aggregates.Remove(record.summary);
+
+		const int leaf = m_leaves[position];
+		m_index.Remove(leaf);
+		record.leaves.erase(std::find(record.leaves.begin(), record.leaves.end(), leaf));
+		if (record.leaves.empty())
+		{
+			shape->RemoveObserver(*this);
+			m_children.erase(it);
+		}
 
-			const IStyle& firstStyle = getStyle(m_shapes[0]);
-			std::optional<RGBAColor> commonColor = firstStyle.GetColor();
-			std::optional<bool> commonEnabled = firstStyle.IsEnabled();
+		m_shapes.erase(m_shapes.begin() + static_cast<std::ptrdiff_t>(position));
+		m_leaves.erase(m_leaves.begin() + static_cast<std::ptrdiff_t>(position));
+	}
 
-			for (size_t i = 1; i < m_shapes.size(); ++i)
-			{
-				const IStyle& style = getStyle(m_shapes[i]);
-				if (style.GetColor() != commonColor)
-				{
-					commonColor = std::nullopt;
-				}
-				if (style.IsEnabled() != commonEnabled)
-				{
-					commonEnabled = std::nullopt;
-				}
-			}
+	uint64_t& GetOrder(size_t position)
+	{
+		return m_index.GetValue(m_leaves[position]).order;
+	}
 
-			groupStyle->SetCachedColor(commonColor);
-			groupStyle->SetCachedEnabled(commonEnabled);
-		};
+	void AssignOrder(size_t position)
+	{
+		const uint64_t before = position == 0 ? 0 : GetOrder(position - 1);
+		if (position + 1 == m_leaves.size())
+		{
+			GetOrder(position) = before + k_orderStep;
+			return;
+		}
+		const uint64_t after = GetOrder(position + 1);
+		if (after - before < 2)
+		{
+			RenumberOrders();
+			return;
+		}
+		GetOrder(position) = before + (after - before) / 2;
+	}
 
-		updateStyle(m_outlineStyle, true);
-		updateStyle(m_fillStyle, false);
+	void RenumberOrders()
+	{
+		for (size_t position = 0; position < m_leaves.size(); ++position)
+		{
+			GetOrder(position) = (position + 1) * k_orderStep;
+		}
 	}
 
-	void UpdateOutlineThickness()
+	void OnShapeChanged(IShape& shape) override
 	{
-		if (m_shapes.empty())
+		ChildRecord& record = m_children.at(&shape);
+		const ShapeSummary summary = Summarize(shape);
+		const RectD box = GetIndexBox(summary);
+		for (int leaf : record.leaves)
 		{
-			m_outlineThickness = std::nullopt;
-			return;
+			m_aggregates.Remove(record.summary);
+			m_aggregates.Add(summary);
+			m_index.Move(leaf, box);
 		}
+		record.summary = summary;
+		if (m_updateDepth == 0)
+		{
+			Refresh();
+		}
+	}
 
-		std::optional<int> commonThickness = m_shapes[0]->GetOutlineThickness();
+	// Внутри UpdateShapes об изменении сообщит вызывающий.
+	void OnShapeContentChanged(IShape& shape) override
+	{
+		(void)shape;
+		if (m_updateDepth == 0)
+		{
+			m_observers.NotifyContentChanged(*this);
+		}
+	}
 
-		for (size_t i = 1; i < m_shapes.size(); ++i)
+	// Применяет изменение ко всем фигурам. Их уведомления только обновляют
+	// счётчики; новое значение свойства группы задаёт вызывающий и затем
+	// один раз уведомляет наблюдателей группы.
+	template <typename F>
+	void UpdateShapes(F&& update)
+	{
+		++m_updateDepth;
+		try
 		{
-			if (m_shapes[i]->GetOutlineThickness() != commonThickness)
+			for (const auto& shape : m_shapes)
 			{
-				commonThickness = std::nullopt;
-				break;
+				update(*shape);
 			}
 		}
+		catch (...)
+		{
+			--m_updateDepth;
+			throw;
+		}
+		--m_updateDepth;
+	}
 
-		m_outlineThickness = commonThickness;
+	void NotifyChanged()
+	{
+		m_observers.Notify(*this);
+		m_observers.NotifyContentChanged(*this);
 	}
 
+	// Берёт рамку и общие стили из счётчиков и уведомляет наблюдателей, если
+	// они изменились.
+	void Refresh()
+	{
+		const RectD frame = m_shapes.empty() ? RectD{ 0, 0, 0, 0 } : m_aggregates.frame.Get();
+		const std::optional<RGBAColor> outlineColor = m_aggregates.outlineColor.GetCommon();
+		const std::optional<bool> outlineEnabled = m_aggregates.outlineEnabled.GetCommon();
+		const std::optional<RGBAColor> fillColor = m_aggregates.fillColor.GetCommon();
+		const std::optional<bool> fillEnabled = m_aggregates.fillEnabled.GetCommon();
+		const std::optional<int> outlineThickness = m_aggregates.outlineThickness.GetCommon();
+
+		const bool isChanged = frame.left != m_frame.left || frame.top != m_frame.top
+			|| frame.width != m_frame.width || frame.height != m_frame.height
+			|| outlineColor != m_outlineStyle->GetColor()
+			|| outlineEnabled != m_outlineStyle->IsEnabled()
+			|| fillColor != m_fillStyle->GetColor()
+			|| fillEnabled != m_fillStyle->IsEnabled()
+			|| outlineThickness != m_outlineThickness;
+
+		m_frame = frame;
+		m_outlineStyle->SetCachedColor(outlineColor);
+		m_outlineStyle->SetCachedEnabled(outlineEnabled);
+		m_fillStyle->SetCachedColor(fillColor);
+		m_fillStyle->SetCachedEnabled(fillEnabled);
+		m_outlineThickness = outlineThickness;
+		if (isChanged)
+		{
+			m_observers.Notify(*this);
+		}
+	}
+
+	static constexpr uint64_t k_orderStep = uint64_t{ 1 } << 32;
+
 	std::vector<std::shared_ptr<IShape>> m_shapes;
+	std::unordered_map<IShape*, ChildRecord> m_children;
+	Aggregates m_aggregates;
+	AabbTree<IndexEntry> m_index;
+	// Лист дерева для каждой фигуры из m_shapes.
+	std::vector<int> m_leaves;
 	RectD m_frame = { 0, 0, 0, 0 };
 	std::shared_ptr<GroupStyle> m_outlineStyle;
 	std::shared_ptr<GroupStyle> m_fillStyle;
 	std::optional<int> m_outlineThickness;
+	ShapeObservers m_observers;
+	int m_updateDepth = 0;
 };
 #endif // OOD_GROUPSHAPE_H
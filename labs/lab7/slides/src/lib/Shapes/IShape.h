@@ -6,10 +6,12 @@
 #define OOD_ISHAPE_H
 #include <optional>
 
-#include "../Canvas.h"
+#include "../ICanvas.h"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
+#include <vector>
 using std::optional;
 
 class IDrawable
@@ -17,10 +19,33 @@ class IDrawable
 public:
 	virtual void Draw(ICanvas& canvas) const = 0;
 
+	// Рисует то, что может попасть в область viewport. Составные объекты
+	// пропускают части за её пределами.
+	virtual void DrawVisible(ICanvas& canvas, const RectD& viewport) const
+	{
+		(void)viewport;
+		Draw(canvas);
+	}
+
 	virtual ~IDrawable() = default;
 };
 
 class IGroupShape;
+class IShape;
+
+// Получает уведомления об изменении фигуры.
+class IShapeObserver
+{
+public:
+	// Изменились рамка, стили или толщина линии фигуры.
+	virtual void OnShapeChanged(IShape& shape) = 0;
+	// Изменилось то, как фигура рисуется. Группа сообщает об этом при любом
+	// изменении вложенных фигур, даже если её рамка и стили остались прежними.
+	virtual void OnShapeContentChanged(IShape& shape) = 0;
+
+protected:
+	~IShapeObserver() = default;
+};
 
 class IShape : public IDrawable
 {
@@ -46,6 +71,48 @@ public:
 	virtual std::optional<int> GetOutlineThickness() const = 0;
 
 	virtual std::shared_ptr<IShape> Clone() = 0;
+
+	virtual void AddObserver(IShapeObserver& observer) = 0;
+	virtual void RemoveObserver(IShapeObserver& observer) = 0;
+};
+
+// Список наблюдателей фигуры. Один наблюдатель может быть добавлен
+// несколько раз и столько же раз удалён.
+class ShapeObservers
+{
+public:
+	void Add(IShapeObserver& observer)
+	{
+		m_observers.push_back(&observer);
+	}
+
+	void Remove(IShapeObserver& observer)
+	{
+		auto it = std::find(m_observers.begin(), m_observers.end(), &observer);
+		if (it != m_observers.end())
+		{
+			m_observers.erase(it);
+		}
+	}
+
+	void Notify(IShape& shape) const
+	{
+		for (IShapeObserver* observer : m_observers)
+		{
+			observer->OnShapeChanged(shape);
+		}
+	}
+
+	void NotifyContentChanged(IShape& shape) const
+	{
+		for (IShapeObserver* observer : m_observers)
+		{
+			observer->OnShapeContentChanged(shape);
+		}
+	}
+
+private:
+	std::vector<IShapeObserver*> m_observers;
 };
 
 class IShapes
@@ -57,6 +124,8 @@ public:
 		= 0;
 	virtual std::shared_ptr<IShape> GetShapeAtIndex(size_t index) = 0;
 	virtual void RemoveShapeAtIndex(size_t index) = 0;
+	// Верхняя фигура, рамка которой содержит точку, или nullptr.
+	virtual std::shared_ptr<IShape> GetShapeAtPoint(double x, double y) = 0;
 
 	virtual ~IShapes() = default;
 };
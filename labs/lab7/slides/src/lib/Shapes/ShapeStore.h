@@ -0,0 +1,355 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#ifndef OOD_SHAPESTORE_H
+#define OOD_SHAPESTORE_H
+#include "Shapes.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+enum class ShapeKind : uint8_t
+{
+	Rectangle,
+	Ellipse,
+	Polygon,
+};
+
+// Хранилище простых фигур по столбцам: рамки, цвета, толщины и виды лежат
+// в отдельных непрерывных массивах, без стратегий и стилей в куче.
+// Массовые операции — линейные проходы по нужным столбцам.
+// IShape для фигуры создаётся по запросу как лёгкое представление строки
+// хранилища; пока оно живо, GetShape возвращает его же, и оно получает
+// уведомления и о массовых изменениях. Представления держат хранилище,
+// поэтому оно создаётся через std::make_shared. Фигуры из хранилища не
+// удаляются.
+class ShapeStore final : public std::enable_shared_from_this<ShapeStore>
+{
+	class StoredShape;
+
+public:
+	size_t AddShape(ShapeKind kind, const RectD& frame, RGBAColor fillColor,
+		RGBAColor outlineColor, int thickness = 1, uint32_t vertexCount = 0)
+	{
+		m_kinds.push_back(kind);
+		m_vertexCounts.push_back(vertexCount);
+		m_lefts.push_back(frame.left);
+		m_tops.push_back(frame.top);
+		m_widths.push_back(frame.width);
+		m_heights.push_back(frame.height);
+		m_fillColors.push_back(fillColor);
+		m_outlineColors.push_back(outlineColor);
+		m_fillEnabled.push_back(true);
+		m_outlineEnabled.push_back(true);
+		m_thicknesses.push_back(thickness);
+		return m_kinds.size() - 1;
+	}
+
+	size_t GetShapesCount() const
+	{
+		return m_kinds.size();
+	}
+
+	std::shared_ptr<IShape> GetShape(size_t index)
+	{
+		if (index >= m_kinds.size())
+		{
+			throw std::out_of_range("Index out of range");
+		}
+		std::weak_ptr<StoredShape>& cached = m_handles[index];
+		std::shared_ptr<StoredShape> shape = cached.lock();
+		if (!shape)
+		{
+			shape = std::make_shared<StoredShape>(shared_from_this(), index);
+			cached = shape;
+		}
+		return shape;
+	}
+
+	RectD GetFrame(size_t index) const
+	{
+		return { m_lefts[index], m_tops[index], m_widths[index], m_heights[index] };
+	}
+
+	void Move(double dx, double dy)
+	{
+		for (double& left : m_lefts)
+		{
+			left += dx;
+		}
+		for (double& top : m_tops)
+		{
+			top += dy;
+		}
+		NotifyAll();
+	}
+
+	void SetFillColor(RGBAColor color)
+	{
+		std::fill(m_fillColors.begin(), m_fillColors.end(), color);
+		NotifyAll();
+	}
+
+	void SetOutlineColor(RGBAColor color)
+	{
+		std::fill(m_outlineColors.begin(), m_outlineColors.end(), color);
+		NotifyAll();
+	}
+
+	void Draw(ICanvas& canvas) const
+	{
+		for (size_t index = 0; index < m_kinds.size(); ++index)
+		{
+			DrawShape(canvas, index);
+		}
+	}
+
+	void DrawShape(ICanvas& canvas, size_t index) const
+	{
+		const RectD frame = GetFrame(index);
+		const RGBAColor fillColor = GetStyleColor(m_fillEnabled[index], m_fillColors[index]);
+		const RGBAColor outlineColor = GetStyleColor(m_outlineEnabled[index], m_outlineColors[index]);
+		switch (m_kinds[index])
+		{
+		case ShapeKind::Rectangle:
+			DrawRectangle(canvas, frame, fillColor, outlineColor);
+			break;
+		case ShapeKind::Ellipse:
+			DrawEllipse(canvas, frame, fillColor, outlineColor);
+			break;
+		case ShapeKind::Polygon:
+			DrawPolygon(canvas, frame, m_vertexCounts[index], fillColor, outlineColor);
+			break;
+		}
+	}
+
+private:
+	// Цвет выключенного стиля такой же, как у Style.
+	static RGBAColor GetStyleColor(bool enabled, RGBAColor color)
+	{
+		return enabled ? color : color & 0x00FFFFFF;
+	}
+
+	// Стиль — ссылка на столбцы цвета и включённости фигуры.
+	class StoredStyle final : public IStyle
+	{
+	public:
+		StoredStyle(StoredShape& shape, bool isFill)
+			: m_shape(shape)
+			, m_isFill(isFill)
+		{
+		}
+
+		std::optional<bool> IsEnabled() const override
+		{
+			return GetEnabled() != 0;
+		}
+
+		void Enable(bool enable) override
+		{
+			GetEnabled() = enable;
+			m_shape.NotifyChanged();
+		}
+
+		std::optional<RGBAColor> GetColor() const override
+		{
+			return GetStyleColor(GetEnabled() != 0, GetStoredColor());
+		}
+
+		void SetColor(RGBAColor color) override
+		{
+			GetStoredColor() = color;
+			m_shape.NotifyChanged();
+		}
+
+		std::unique_ptr<IStyle> Clone() const override
+		{
+			return std::make_unique<Style>(GetEnabled() != 0, GetStoredColor());
+		}
+
+	private:
+		uint8_t& GetEnabled() const
+		{
+			ShapeStore& store = *m_shape.m_store;
+			return (m_isFill ? store.m_fillEnabled : store.m_outlineEnabled)[m_shape.m_index];
+		}
+
+		RGBAColor& GetStoredColor() const
+		{
+			ShapeStore& store = *m_shape.m_store;
+			return (m_isFill ? store.m_fillColors : store.m_outlineColors)[m_shape.m_index];
+		}
+
+		StoredShape& m_shape;
+		bool m_isFill;
+	};
+
+	class StoredShape final : public IShape
+	{
+	public:
+		StoredShape(std::shared_ptr<ShapeStore> store, size_t index)
+			: m_store(std::move(store))
+			, m_index(index)
+			, m_outline(*this, false)
+			, m_fill(*this, true)
+		{
+		}
+
+		StoredShape(const StoredShape&) = delete;
+		StoredShape& operator=(const StoredShape&) = delete;
+
+		void Draw(ICanvas& canvas) const override
+		{
+			m_store->DrawShape(canvas, m_index);
+		}
+
+		RectD GetFrame() const override
+		{
+			return m_store->GetFrame(m_index);
+		}
+
+		void SetFrame(const RectD& rect) override
+		{
+			m_store->m_lefts[m_index] = rect.left;
+			m_store->m_tops[m_index] = rect.top;
+			m_store->m_widths[m_index] = rect.width;
+			m_store->m_heights[m_index] = rect.height;
+			NotifyChanged();
+		}
+
+		IStyle& GetOutlineStyle() override
+		{
+			return m_outline;
+		}
+
+		const IStyle& GetOutlineStyle() const override
+		{
+			return m_outline;
+		}
+
+		IStyle& GetFillStyle() override
+		{
+			return m_fill;
+		}
+
+		const IStyle& GetFillStyle() const override
+		{
+			return m_fill;
+		}
+
+		std::shared_ptr<IGroupShape> GetGroup() override
+		{
+			return nullptr;
+		}
+
+		std::shared_ptr<const IGroupShape> GetGroup() const override
+		{
+			return nullptr;
+		}
+
+		void SetOutlineColor(RGBAColor color) override
+		{
+			m_outline.SetColor(color);
+		}
+
+		void SetFillColor(RGBAColor color) override
+		{
+			m_fill.SetColor(color);
+		}
+
+		void EnableOutline(bool enable) override
+		{
+			m_outline.Enable(enable);
+		}
+
+		void EnableFill(bool enable) override
+		{
+			m_fill.Enable(enable);
+		}
+
+		void SetOutlineThickness(int thickness) override
+		{
+			m_store->m_thicknesses[m_index] = thickness;
+			NotifyChanged();
+		}
+
+		std::optional<int> GetOutlineThickness() const override
+		{
+			return m_store->m_thicknesses[m_index];
+		}
+
+		// Копия добавляется в то же хранилище.
+		std::shared_ptr<IShape> Clone() override
+		{
+			ShapeStore& store = *m_store;
+			const size_t index = store.AddShape(store.m_kinds[m_index], GetFrame(),
+				store.m_fillColors[m_index], store.m_outlineColors[m_index],
+				store.m_thicknesses[m_index], store.m_vertexCounts[m_index]);
+			store.m_fillEnabled[index] = store.m_fillEnabled[m_index];
+			store.m_outlineEnabled[index] = store.m_outlineEnabled[m_index];
+			return store.GetShape(index);
+		}
+
+		void AddObserver(IShapeObserver& observer) override
+		{
+			m_observers.Add(observer);
+		}
+
+		void RemoveObserver(IShapeObserver& observer) override
+		{
+			m_observers.Remove(observer);
+		}
+
+		void NotifyChanged()
+		{
+			m_observers.Notify(*this);
+			m_observers.NotifyContentChanged(*this);
+		}
+
+	private:
+		friend class StoredStyle;
+
+		std::shared_ptr<ShapeStore> m_store;
+		size_t m_index;
+		StoredStyle m_outline;
+		StoredStyle m_fill;
+		ShapeObservers m_observers;
+	};
+
+	// Уведомляет живые представления фигур и забывает умершие.
+	void NotifyAll()
+	{
+		for (auto it = m_handles.begin(); it != m_handles.end();)
+		{
+			if (std::shared_ptr<StoredShape> shape = it->second.lock())
+			{
+				shape->NotifyChanged();
+				++it;
+			}
+			else
+			{
+				it = m_handles.erase(it);
+			}
+		}
+	}
+
+	std::vector<ShapeKind> m_kinds;
+	std::vector<uint32_t> m_vertexCounts;
+	std::vector<double> m_lefts;
+	std::vector<double> m_tops;
+	std::vector<double> m_widths;
+	std::vector<double> m_heights;
+	std::vector<RGBAColor> m_fillColors;
+	std::vector<RGBAColor> m_outlineColors;
+	std::vector<uint8_t> m_fillEnabled;
+	std::vector<uint8_t> m_outlineEnabled;
+	std::vector<int> m_thicknesses;
+	std::unordered_map<size_t, std::weak_ptr<StoredShape>> m_handles;
+};
+
+#endif // OOD_SHAPESTORE_H
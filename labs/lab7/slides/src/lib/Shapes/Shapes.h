@@ -6,6 +6,7 @@
 #define OOD_SHAPES_H
 #include "IShape.h"
 
+#include <cmath>
 #include <functional>
 #include <math.h>
 #include <utility>
@@ -13,80 +14,146 @@
 using DrawingStrategy
 	= std::function<void(ICanvas& canvas, const IShape& shape)>;
 
-inline DrawingStrategy MakeRectangleStrategy()
+// Рисование фигур по рамке и цветам, общее для стратегий и ShapeStore.
+inline void DrawRectangle(ICanvas& canvas, const RectD& r, RGBAColor fillColor, RGBAColor lineColor)
 {
-	return [](ICanvas& canvas, const IShape& shape) {
-		RectD r = shape.GetFrame();
-		canvas.BeginFill(shape.GetFillStyle().GetColor().value_or(0));
-		canvas.SetLineColor(shape.GetOutlineStyle().GetColor().value_or(0));
-		canvas.MoveTo(r.left, r.top);
-		canvas.LineTo(r.left + r.width, r.top);
-		canvas.LineTo(r.left + r.width, r.top + r.height);
-		canvas.LineTo(r.left, r.top + r.height);
-		canvas.LineTo(r.left, r.top);
-		canvas.EndFill();
-	};
+	canvas.BeginFill(fillColor);
+	canvas.SetLineColor(lineColor);
+	canvas.MoveTo(r.left, r.top);
+	canvas.LineTo(r.left + r.width, r.top);
+	canvas.LineTo(r.left + r.width, r.top + r.height);
+	canvas.LineTo(r.left, r.top + r.height);
+	canvas.LineTo(r.left, r.top);
+	canvas.EndFill();
 }
 
-inline DrawingStrategy MakePolygonStrategy(size_t vertexCount)
+inline void DrawPolygon(ICanvas& canvas, const RectD& r, size_t vertexCount,
+	RGBAColor fillColor, RGBAColor lineColor)
 {
-	return [vertexCount](ICanvas& canvas, const IShape& shape) {
-		if (vertexCount < 3)
-			return;
-		RectD r = shape.GetFrame();
-		double cx = r.left + r.width * 0.5;
-		double cy = r.top + r.height * 0.5;
-		double rx = r.width * 0.5;
-		double ry = r.height * 0.5;
+	if (vertexCount < 3)
+		return;
+	double cx = r.left + r.width * 0.5;
+	double cy = r.top + r.height * 0.5;
+	double rx = r.width * 0.5;
+	double ry = r.height * 0.5;
 
-		canvas.BeginFill(shape.GetFillStyle().GetColor().value_or(0));
-		canvas.SetLineColor(shape.GetOutlineStyle().GetColor().value_or(0));
+	canvas.BeginFill(fillColor);
+	canvas.SetLineColor(lineColor);
 
-		double angleStep = 2.0 * M_PI / vertexCount;
-		double a0 = 0.0;
+	double angleStep = 2.0 * M_PI / vertexCount;
+	double a0 = 0.0;
 
-		double x0 = cx + rx * std::cos(a0);
-		double y0 = cy + ry * std::sin(a0);
-		canvas.MoveTo(x0, y0);
+	double x0 = cx + rx * std::cos(a0);
+	double y0 = cy + ry * std::sin(a0);
+	canvas.MoveTo(x0, y0);
 
-		for (size_t i = 1; i < vertexCount; ++i)
-		{
-			double a = i * angleStep;
-			double x = cx + rx * std::cos(a);
-			double y = cy + ry * std::sin(a);
-			canvas.LineTo(x, y);
-		}
+	for (size_t i = 1; i < vertexCount; ++i)
+	{
+		double a = i * angleStep;
+		double x = cx + rx * std::cos(a);
+		double y = cy + ry * std::sin(a);
+		canvas.LineTo(x, y);
+	}
+
+	canvas.LineTo(x0, y0);
+	canvas.EndFill();
+}
+
+inline void DrawEllipse(ICanvas& canvas, const RectD& r, RGBAColor fillColor, RGBAColor lineColor)
+{
+	canvas.BeginFill(fillColor);
+	canvas.SetLineColor(lineColor);
+	canvas.DrawEllipse(r.left, r.top, r.width, r.height);
+	canvas.EndFill();
+}
 
-		canvas.LineTo(x0, y0);
-		canvas.EndFill();
+inline DrawingStrategy MakeRectangleStrategy()
+{
+	return [](ICanvas& canvas, const IShape& shape) {
+		DrawRectangle(canvas, shape.GetFrame(),
+			shape.GetFillStyle().GetColor().value_or(0),
+			shape.GetOutlineStyle().GetColor().value_or(0));
+	};
+}
+
+inline DrawingStrategy MakePolygonStrategy(size_t vertexCount)
+{
+	return [vertexCount](ICanvas& canvas, const IShape& shape) {
+		DrawPolygon(canvas, shape.GetFrame(), vertexCount,
+			shape.GetFillStyle().GetColor().value_or(0),
+			shape.GetOutlineStyle().GetColor().value_or(0));
 	};
 }
 
 inline DrawingStrategy MakeEllipseStrategy()
 {
 	return [](ICanvas& canvas, const IShape& shape) {
-		RectD r = shape.GetFrame();
-		canvas.BeginFill(shape.GetFillStyle().GetColor().value_or(0));
-		canvas.SetLineColor(shape.GetOutlineStyle().GetColor().value_or(0));
-		canvas.DrawEllipse(r.left, r.top, r.width, r.height);
-		canvas.EndFill();
+		DrawEllipse(canvas, shape.GetFrame(),
+			shape.GetFillStyle().GetColor().value_or(0),
+			shape.GetOutlineStyle().GetColor().value_or(0));
 	};
 }
 
 class SimpleShape final : public IShape
 {
+	// Стиль фигуры, который сообщает наблюдателям фигуры о своих изменениях,
+	// даже если его меняют напрямую через GetFillStyle или GetOutlineStyle.
+	class ShapeStyle final : public IStyle
+	{
+	public:
+		ShapeStyle(SimpleShape& shape, std::unique_ptr<IStyle> style)
+			: m_shape(shape)
+			, m_style(std::move(style))
+		{
+		}
+
+		std::optional<bool> IsEnabled() const override
+		{
+			return m_style->IsEnabled();
+		}
+
+		void Enable(bool enable) override
+		{
+			m_style->Enable(enable);
+			m_shape.NotifyChanged();
+		}
+
+		std::optional<RGBAColor> GetColor() const override
+		{
+			return m_style->GetColor();
+		}
+
+		void SetColor(RGBAColor color) override
+		{
+			m_style->SetColor(color);
+			m_shape.NotifyChanged();
+		}
+
+		std::unique_ptr<IStyle> Clone() const override
+		{
+			return m_style->Clone();
+		}
+
+	private:
+		SimpleShape& m_shape;
+		std::unique_ptr<IStyle> m_style;
+	};
+
 public:
 	explicit SimpleShape(std::shared_ptr<DrawingStrategy> strategy, RectD frame,
 		std::unique_ptr<IStyle> fillColor, std::unique_ptr<IStyle> outlineColor,
 		int thickness = 1)
 		: m_strategy(std::move(strategy))
 		, m_frame(frame)
-		, m_outline(std::move(outlineColor))
-		, m_fill(std::move(fillColor))
+		, m_outline(*this, std::move(outlineColor))
+		, m_fill(*this, std::move(fillColor))
 		, m_outlineThickness(thickness)
 	{
 	}
 
+	SimpleShape(const SimpleShape&) = delete;
+	SimpleShape& operator=(const SimpleShape&) = delete;
+
 	void Draw(ICanvas& canvas) const override
 	{
 		(*m_strategy)(canvas, *this);
@@ -100,25 +167,26 @@ public:
 	void SetFrame(const RectD& rect) override
 	{
 		m_frame = rect;
+		NotifyChanged();
 	}
 
 	IStyle& GetOutlineStyle() override
 	{
-		return *m_outline;
+		return m_outline;
 	}
 
 	const IStyle& GetOutlineStyle() const override
 	{
-		return *m_outline;
+		return m_outline;
 	}
 
 	IStyle& GetFillStyle() override
 	{
-		return *m_fill;
+		return m_fill;
 	}
 	const IStyle& GetFillStyle() const override
 	{
-		return *m_fill;
+		return m_fill;
 	}
 
 	std::shared_ptr<IGroupShape> GetGroup() override
@@ -133,24 +201,25 @@ public:
 
 	void SetOutlineColor(RGBAColor color) override
 	{
-		m_outline->SetColor(color);
+		m_outline.SetColor(color);
 	}
 	void SetFillColor(RGBAColor color) override
 	{
-		m_fill->SetColor(color);
+		m_fill.SetColor(color);
 	}
 	void EnableOutline(bool enable) override
 	{
-		m_outline->Enable(enable);
+		m_outline.Enable(enable);
 	}
 	void EnableFill(bool enable) override
 	{
-		m_fill->Enable(enable);
+		m_fill.Enable(enable);
 	}
 
 	void SetOutlineThickness(int thickness) override
 	{
 		m_outlineThickness = thickness;
+		NotifyChanged();
 	}
 	std::optional<int> GetOutlineThickness() const override
 	{
@@ -160,15 +229,32 @@ public:
 	std::shared_ptr<IShape> Clone() override
 	{
 		return std::make_shared<SimpleShape>(m_strategy, m_frame,
-			m_fill->Clone(), m_outline->Clone(), m_outlineThickness);
+			m_fill.Clone(), m_outline.Clone(), m_outlineThickness);
+	}
+
+	void AddObserver(IShapeObserver& observer) override
+	{
+		m_observers.Add(observer);
+	}
+
+	void RemoveObserver(IShapeObserver& observer) override
+	{
+		m_observers.Remove(observer);
 	}
 
 private:
+	void NotifyChanged()
+	{
+		m_observers.Notify(*this);
+		m_observers.NotifyContentChanged(*this);
+	}
+
 	std::shared_ptr<DrawingStrategy> m_strategy;
 	RectD m_frame;
-	std::unique_ptr<IStyle> m_outline;
-	std::unique_ptr<IStyle> m_fill;
+	ShapeStyle m_outline;
+	ShapeStyle m_fill;
 	int m_outlineThickness;
+	ShapeObservers m_observers;
 };
 
 #endif // OOD_SHAPES_H
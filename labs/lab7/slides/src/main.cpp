@@ -3,23 +3,24 @@
 //
 
 #include "lib/Canvas.h"
+#include "lib/ShapeBatch.h"
 #include "lib/Shapes/GroupShape.h"
 #include "lib/Shapes/Shapes.h"
 
 
-void CreateScene(std::vector<std::shared_ptr<IDrawable>>& drawables)
+void CreateScene(ShapeBatch& scene)
 {
 	auto circle = std::make_shared<SimpleShape>(
 		std::make_shared<DrawingStrategy>(MakeEllipseStrategy()),
 		RectD{ 50, 50, 100, 100 }, std::make_unique<Style>(true, 0xFF0000FF),
 		std::make_unique<Style>(true, 0x000000FF), 5);
-	drawables.push_back(circle);
+	scene.AddShape(circle);
 
 	auto rect = std::make_shared<SimpleShape>(
 		std::make_shared<DrawingStrategy>(MakeRectangleStrategy()),
 		RectD{ 200, 50, 150, 80 }, std::make_unique<Style>(true, 0x00FF00FF),
 		std::make_unique<Style>(true, 0x808080FF), 2);
-	drawables.push_back(rect);
+	scene.AddShape(rect);
 
 	auto group = std::make_shared<GroupShape>();
 	group->InsertShape(circle->Clone());
@@ -34,16 +35,15 @@ void CreateScene(std::vector<std::shared_ptr<IDrawable>>& drawables)
 	group->SetOutlineThickness(3);
 	group->SetOutlineColor(0xFF00FFFF);
 
-	drawables.push_back(group);
+	scene.AddShape(group);
 }
 
 int main()
 {
 	sf::RenderWindow window(sf::VideoMode(800, 600), "SFML Canvas Demo");
-	SFMLCanvas canvas(window);
 
-	std::vector<std::shared_ptr<IDrawable>> drawables;
-	CreateScene(drawables);
+	ShapeBatch scene;
+	CreateScene(scene);
 
 	while (window.isOpen())
 	{
@@ -56,10 +56,7 @@ int main()
 
 		window.clear(sf::Color(240, 240, 240));
 
-		for (const auto& drawable : drawables)
-		{
-			drawable->Draw(canvas);
-		}
+		scene.Draw(window);
 
 		window.display();
 	}
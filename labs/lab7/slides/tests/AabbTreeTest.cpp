@@ -0,0 +1,87 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#include "../src/lib/AabbTree.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+std::vector<int> QuerySorted(const AabbTree<int>& tree, const RectD& area)
+{
+	std::vector<int> result;
+	tree.Query(area, [&](int value) { result.push_back(value); });
+	std::sort(result.begin(), result.end());
+	return result;
+}
+} // namespace
+
+TEST(AabbTreeTest, QueriesMatchBruteForceAfterInsertMoveAndRemove)
+{
+	std::mt19937 random(42);
+	std::uniform_real_distribution<double> position(0, 1000);
+	std::uniform_real_distribution<double> extent(0, 50);
+	const auto makeBox = [&] {
+		return RectD{ position(random), position(random), extent(random), extent(random) };
+	};
+
+	AabbTree<int> tree;
+	std::vector<RectD> boxes;
+	std::vector<int> leaves;
+	std::vector<bool> isAlive;
+	for (int i = 0; i < 2000; ++i)
+	{
+		boxes.push_back(makeBox());
+		leaves.push_back(tree.Insert(boxes.back(), i));
+		isAlive.push_back(true);
+	}
+	for (int i = 0; i < 2000; i += 3)
+	{
+		boxes[i] = makeBox();
+		tree.Move(leaves[i], boxes[i]);
+	}
+	for (int i = 1; i < 2000; i += 4)
+	{
+		tree.Remove(leaves[i]);
+		isAlive[i] = false;
+	}
+	EXPECT_EQ(1500u, tree.GetSize());
+	// Сбалансированное дерево из 1500 листьев.
+	EXPECT_LE(tree.GetHeight(), 24);
+
+	for (int query = 0; query < 100; ++query)
+	{
+		const RectD area{ position(random), position(random), 100, 100 };
+		std::vector<int> expected;
+		for (int i = 0; i < 2000; ++i)
+		{
+			if (isAlive[i] && AabbTree<int>::Intersects(boxes[i], area))
+			{
+				expected.push_back(i);
+			}
+		}
+		EXPECT_EQ(expected, QuerySorted(tree, area));
+	}
+}
+
+TEST(AabbTreeTest, QueryPointFindsContainingBoxes)
+{
+	AabbTree<int> tree;
+	tree.Insert({ 0, 0, 10, 10 }, 1);
+	const int leaf = tree.Insert({ 5, 5, 10, 10 }, 2);
+	tree.Insert({ 20, 20, 5, 5 }, 3);
+
+	std::vector<int> hits;
+	tree.QueryPoint(7, 7, [&](int value) { hits.push_back(value); });
+	std::sort(hits.begin(), hits.end());
+	EXPECT_EQ((std::vector<int>{ 1, 2 }), hits);
+
+	tree.Remove(leaf);
+	hits.clear();
+	tree.QueryPoint(7, 7, [&](int value) { hits.push_back(value); });
+	EXPECT_EQ((std::vector<int>{ 1 }), hits);
+	EXPECT_TRUE(QuerySorted(tree, { 100, 100, 1, 1 }).empty());
+}
@@ -1,5 +1,7 @@
+#include "lib/Canvas.h"
 #include "lib/CommonTypes.h"
-#include "lib/Shapes/IShape.h"
+#include "lib/Shapes/GroupShape.h"
+#include "lib/Shapes/Shapes.h"
 
 #include <cmath>
 #include <functional>
@@ -87,366 +89,25 @@ public:
 	MOCK_CONST_METHOD0(GetGroup, std::shared_ptr<const IGroupShape>());
 	MOCK_METHOD0(Clone, std::shared_ptr<IShape>());
 
-	MockStyle& GetMockOutlineStyle()
-	{
-		return *m_outlineStyle;
-	}
-	MockStyle& GetMockFillStyle()
-	{
-		return *m_fillStyle;
-	}
-
-private:
-	std::unique_ptr<MockStyle> m_outlineStyle;
-	std::unique_ptr<MockStyle> m_fillStyle;
-};
-
-class GroupShape final : public IGroupShape
-{
-	class GroupStyle final : public IStyle
-	{
-	public:
-		using StyleEnumerator
-			= std::function<void(const std::function<void(IStyle&)>&)>;
-		explicit GroupStyle(StyleEnumerator enumerator)
-			: m_enumerator(std::move(enumerator))
-		{
-		}
-		std::optional<bool> IsEnabled() const override
-		{
-			return m_enabled;
-		}
-		void Enable(bool enable) override
-		{
-			m_enabled = enable;
-			m_enumerator([enable](IStyle& style) { style.Enable(enable); });
-		}
-		std::optional<RGBAColor> GetColor() const override
-		{
-			return m_color;
-		}
-		void SetColor(RGBAColor color) override
-		{
-			m_color = color;
-			m_enumerator([color](IStyle& style) { style.SetColor(color); });
-		}
-		std::unique_ptr<IStyle> Clone() const override
-		{
-			return nullptr;
-		}
-		void SetCachedColor(std::optional<RGBAColor> color)
-		{
-			m_color = color;
-		}
-		void SetCachedEnabled(std::optional<bool> enabled)
-		{
-			m_enabled = enabled;
-		}
-
-	private:
-		StyleEnumerator m_enumerator;
-		std::optional<bool> m_enabled;
-		std::optional<RGBAColor> m_color;
-	};
-
-public:
-	GroupShape()
+	void AddObserver(IShapeObserver&) override
 	{
-		m_outlineStyle = std::make_shared<GroupStyle>(
-			[this](const std::function<void(IStyle&)>& fn) {
-				for (const auto& shape : m_shapes)
-				{
-					fn(shape->GetOutlineStyle());
-				}
-			});
-
-		m_fillStyle = std::make_shared<GroupStyle>(
-			[this](const std::function<void(IStyle&)>& fn) {
-				for (const auto& shape : m_shapes)
-				{
-					fn(shape->GetFillStyle());
-				}
-			});
 	}
-
-	GroupShape(const GroupShape& other)
-		: m_shapes(other.m_shapes)
-		, m_frame(other.m_frame)
-		, m_outlineThickness(other.m_outlineThickness)
-	{
-		m_outlineStyle = std::make_shared<GroupStyle>(
-			[this](const std::function<void(IStyle&)>& fn) {
-				for (const auto& shape : m_shapes)
-				{
-					fn(shape->GetOutlineStyle());
-				}
-			});
-
-		m_fillStyle = std::make_shared<GroupStyle>(
-			[this](const std::function<void(IStyle&)>& fn) {
-				for (const auto& shape : m_shapes)
-				{
-					fn(shape->GetFillStyle());
-				}
-			});
-	}
-
-	void Draw(ICanvas& canvas) const override
+	void RemoveObserver(IShapeObserver&) override
 	{
-		for (const auto& shape : m_shapes)
-		{
-			shape->Draw(canvas);
-		}
 	}
 
-	RectD GetFrame() const override
-	{
-		return m_frame;
-	}
-
-	void SetFrame(const RectD& rect) override
-	{
-		if (m_shapes.empty())
-		{
-			m_frame = rect;
-			return;
-		}
-
-		double scaleX = m_frame.width == 0 ? 0 : rect.width / m_frame.width;
-		double scaleY = m_frame.height == 0 ? 0 : rect.height / m_frame.height;
-
-		for (auto& shape : m_shapes)
-		{
-			RectD oldShapeFrame = shape->GetFrame();
-			double newX
-				= rect.left + (oldShapeFrame.left - m_frame.left) * scaleX;
-			double newY = rect.top + (oldShapeFrame.top - m_frame.top) * scaleY;
-			double newWidth = oldShapeFrame.width * scaleX;
-			double newHeight = oldShapeFrame.height * scaleY;
-
-			shape->SetFrame({ newX, newY, newWidth, newHeight });
-		}
-
-		m_frame = rect;
-	}
-
-	IStyle& GetOutlineStyle() override
-	{
-		return *m_outlineStyle;
-	}
-
-	const IStyle& GetOutlineStyle() const override
+	MockStyle& GetMockOutlineStyle()
 	{
 		return *m_outlineStyle;
 	}
-
-	IStyle& GetFillStyle() override
-	{
-		return *m_fillStyle;
-	}
-
-	const IStyle& GetFillStyle() const override
+	MockStyle& GetMockFillStyle()
 	{
 		return *m_fillStyle;
 	}
 
-	void SetOutlineColor(RGBAColor color) override
-	{
-		m_outlineStyle->SetColor(color);
-	}
-
-	void SetFillColor(RGBAColor color) override
-	{
-		m_fillStyle->SetColor(color);
-	}
-
-	void EnableOutline(bool enable) override
-	{
-		m_outlineStyle->Enable(enable);
-	}
-
-	void EnableFill(bool enable) override
-	{
-		m_fillStyle->Enable(enable);
-	}
-
-	void SetOutlineThickness(int thickness) override
-	{
-		for (auto& shape : m_shapes)
-		{
-			shape->SetOutlineThickness(thickness);
-		}
-		m_outlineThickness = thickness;
-	}
-
-	std::optional<int> GetOutlineThickness() const override
-	{
-		return m_outlineThickness;
-	}
-
-	std::shared_ptr<IGroupShape> GetGroup() override
-	{
-		return std::make_shared<GroupShape>(*this);
-	}
-
-	std::shared_ptr<const IGroupShape> GetGroup() const override
-	{
-		return std::make_shared<GroupShape>(*this);
-	}
-
-	size_t GetShapesCount() const override
-	{
-		return m_shapes.size();
-	}
-
-	void InsertShape(const std::shared_ptr<IShape>& shape,
-		size_t position = std::numeric_limits<size_t>::max()) override
-	{
-		if (position > m_shapes.size())
-		{
-			m_shapes.push_back(shape);
-		}
-		else
-		{
-			m_shapes.insert(m_shapes.begin() + position, shape);
-		}
-
-		RecalculateFrame();
-		UpdateStyles();
-		UpdateOutlineThickness();
-	}
-
-	std::shared_ptr<IShape> GetShapeAtIndex(size_t index) override
-	{
-		ValidateIndex(index);
-		return m_shapes[index];
-	}
-
-	void RemoveShapeAtIndex(size_t index) override
-	{
-		ValidateIndex(index);
-		m_shapes.erase(m_shapes.begin() + index);
-		RecalculateFrame();
-		UpdateStyles();
-		UpdateOutlineThickness();
-	}
-
-	std::shared_ptr<IShape> Clone() override
-	{
-		auto newGroup = std::make_shared<GroupShape>();
-		for (const auto& shape : m_shapes)
-		{
-			newGroup->InsertShape(shape->Clone());
-		}
-		return newGroup;
-	}
-
 private:
-	void ValidateIndex(size_t index) const
-	{
-		if (index >= m_shapes.size())
-		{
-			throw std::out_of_range("Index out of range");
-		}
-	}
-
-	void RecalculateFrame()
-	{
-		if (m_shapes.empty())
-		{
-			m_frame = { 0, 0, 0, 0 };
-			return;
-		}
-
-		double minX = std::numeric_limits<double>::max();
-		double minY = std::numeric_limits<double>::max();
-		double maxX = std::numeric_limits<double>::lowest();
-		double maxY = std::numeric_limits<double>::lowest();
-
-		for (const auto& shape : m_shapes)
-		{
-			RectD frame = shape->GetFrame();
-			if (frame.left < minX)
-				minX = frame.left;
-			if (frame.top < minY)
-				minY = frame.top;
-			if (frame.left + frame.width > maxX)
-				maxX = frame.left + frame.width;
-			if (frame.top + frame.height > maxY)
-				maxY = frame.top + frame.height;
-		}
-
-		m_frame = { minX, minY, maxX - minX, maxY - minY };
-	}
-
-	void UpdateStyles()
-	{
-		auto updateStyle = [&](std::shared_ptr<GroupStyle>& groupStyle,
-							   bool isOutline) {
-			if (m_shapes.empty())
-			{
-				groupStyle->SetCachedColor(std::nullopt);
-				groupStyle->SetCachedEnabled(std::nullopt);
-				return;
-			}
-
-			auto getStyle
-				= [&](const std::shared_ptr<IShape>& s) -> const IStyle& {
-				return isOutline ? s->GetOutlineStyle() : s->GetFillStyle();
-			};
-
-			const IStyle& firstStyle = getStyle(m_shapes[0]);
-			std::optional<RGBAColor> commonColor = firstStyle.GetColor();
-			std::optional<bool> commonEnabled = firstStyle.IsEnabled();
-
-			for (size_t i = 1; i < m_shapes.size(); ++i)
-			{
-				const IStyle& style = getStyle(m_shapes[i]);
-				if (style.GetColor() != commonColor)
-				{
-					commonColor = std::nullopt;
-				}
-				if (style.IsEnabled() != commonEnabled)
-				{
-					commonEnabled = std::nullopt;
-				}
-			}
-
-			groupStyle->SetCachedColor(commonColor);
-			groupStyle->SetCachedEnabled(commonEnabled);
-		};
-
-		updateStyle(m_outlineStyle, true);
-		updateStyle(m_fillStyle, false);
-	}
-
-	void UpdateOutlineThickness()
-	{
-		if (m_shapes.empty())
-		{
-			m_outlineThickness = std::nullopt;
-			return;
-		}
-
-		std::optional<int> commonThickness = m_shapes[0]->GetOutlineThickness();
-
-		for (size_t i = 1; i < m_shapes.size(); ++i)
-		{
-			if (m_shapes[i]->GetOutlineThickness() != commonThickness)
-			{
-				commonThickness = std::nullopt;
-				break;
-			}
-		}
-
-		m_outlineThickness = commonThickness;
-	}
-
-	std::vector<std::shared_ptr<IShape>> m_shapes;
-	RectD m_frame = { 0, 0, 0, 0 };
-	std::shared_ptr<GroupStyle> m_outlineStyle;
-	std::shared_ptr<GroupStyle> m_fillStyle;
-	std::optional<int> m_outlineThickness;
+	std::unique_ptr<MockStyle> m_outlineStyle;
+	std::unique_ptr<MockStyle> m_fillStyle;
 };
 
 TEST(GroupShapeTest, RecalculatesFrameOnInsert)
@@ -633,4 +294,151 @@ TEST(GroupShapeTest, GetShapeAtIndexThrowsOnInvalidIndex)
 
 	group->RemoveShapeAtIndex(0);
 	ASSERT_THROW(group->GetShapeAtIndex(0), std::out_of_range);
-}
\ No newline at end of file
+}
+
+std::shared_ptr<SimpleShape> MakeRectangle(RectD frame, RGBAColor fillColor)
+{
+	return std::make_shared<SimpleShape>(
+		std::make_shared<DrawingStrategy>(MakeRectangleStrategy()), frame,
+		std::make_unique<Style>(true, fillColor),
+		std::make_unique<Style>(true, 0x000000FF));
+}
+
+TEST(GroupShapeTest, ChildChangesPropagateThroughNestedGroups)
+{
+	auto shape1 = MakeRectangle({ 0, 0, 10, 10 }, 0xFF0000FF);
+	auto shape2 = MakeRectangle({ 20, 20, 10, 10 }, 0xFF0000FF);
+	auto inner = std::make_shared<GroupShape>();
+	inner->InsertShape(shape1);
+	inner->InsertShape(shape2);
+	auto outer = std::make_shared<GroupShape>();
+	outer->InsertShape(inner);
+	outer->InsertShape(MakeRectangle({ 5, 5, 5, 5 }, 0xFF0000FF));
+
+	EXPECT_EQ(outer->GetFrame(), (RectD{ 0, 0, 30, 30 }));
+	EXPECT_EQ(outer->GetFillStyle().GetColor(), 0xFF0000FF);
+
+	shape2->SetFrame({ 20, 20, 80, 40 });
+	EXPECT_EQ(inner->GetFrame(), (RectD{ 0, 0, 100, 60 }));
+	EXPECT_EQ(outer->GetFrame(), (RectD{ 0, 0, 100, 60 }));
+
+	shape1->GetFillStyle().SetColor(0x00FF00FF);
+	EXPECT_FALSE(inner->GetFillStyle().GetColor().has_value());
+	EXPECT_FALSE(outer->GetFillStyle().GetColor().has_value());
+
+	shape1->SetOutlineThickness(3);
+	EXPECT_FALSE(outer->GetOutlineThickness().has_value());
+
+	inner->SetFillColor(0xFF0000FF);
+	EXPECT_EQ(outer->GetFillStyle().GetColor(), 0xFF0000FF);
+}
+
+TEST(GroupShapeTest, RemovingShapesUpdatesFrameAndCommonStyles)
+{
+	auto group = std::make_shared<GroupShape>();
+	for (int i = 0; i < 100; ++i)
+	{
+		group->InsertShape(MakeRectangle({ i * 10.0, 0, 10, 10 + i * 1.0 }, 0xFF0000FF));
+	}
+	auto odd = MakeRectangle({ -50, -50, 10, 10 }, 0x0000FFFF);
+	group->InsertShape(odd, 50);
+	group->InsertShape(odd);
+	EXPECT_EQ(group->GetFrame(), (RectD{ -50, -50, 1050, 159 }));
+	EXPECT_FALSE(group->GetFillStyle().GetColor().has_value());
+
+	group->RemoveShapeAtIndex(50);
+	EXPECT_EQ(group->GetFrame(), (RectD{ -50, -50, 1050, 159 }));
+	group->RemoveShapeAtIndex(group->GetShapesCount() - 1);
+	EXPECT_EQ(group->GetFrame(), (RectD{ 0, 0, 1000, 109 }));
+	EXPECT_EQ(group->GetFillStyle().GetColor(), 0xFF0000FF);
+
+	// Удалённая фигура больше не влияет на группу.
+	odd->SetFrame({ -100, -100, 1, 1 });
+	EXPECT_EQ(group->GetFrame(), (RectD{ 0, 0, 1000, 109 }));
+
+	while (group->GetShapesCount() > 0)
+	{
+		group->RemoveShapeAtIndex(0);
+	}
+	EXPECT_EQ(group->GetFrame(), (RectD{ 0, 0, 0, 0 }));
+	EXPECT_FALSE(group->GetFillStyle().GetColor().has_value());
+}
+
+TEST(GroupShapeTest, GroupCopyFollowsSharedShapes)
+{
+	auto shape = MakeRectangle({ 0, 0, 10, 10 }, 0xFF0000FF);
+	auto group = std::make_shared<GroupShape>();
+	group->InsertShape(shape);
+	{
+		auto copy = group->GetGroup();
+		shape->SetFrame({ 0, 0, 20, 20 });
+		EXPECT_EQ(copy->GetFrame(), (RectD{ 0, 0, 20, 20 }));
+	}
+	shape->SetFrame({ 0, 0, 30, 30 });
+	EXPECT_EQ(group->GetFrame(), (RectD{ 0, 0, 30, 30 }));
+}
+
+TEST(GroupShapeTest, DrawVisibleSkipsShapesOutsideViewport)
+{
+	auto group = std::make_shared<GroupShape>();
+	auto visible = std::make_shared<MockShape>();
+	auto hidden = std::make_shared<MockShape>();
+	EXPECT_CALL(*visible, GetFrame()).WillRepeatedly(Return(RectD{ 0, 0, 10, 10 }));
+	EXPECT_CALL(*hidden, GetFrame()).WillRepeatedly(Return(RectD{ 500, 500, 10, 10 }));
+	group->InsertShape(hidden);
+	group->InsertShape(visible);
+
+	EXPECT_CALL(*visible, Draw(_)).Times(1);
+	EXPECT_CALL(*hidden, Draw(_)).Times(0);
+	std::vector<sf::Vertex> vertices;
+	TessellatingCanvas canvas(vertices);
+	group->DrawVisible(canvas, { -50, -50, 100, 100 });
+}
+
+TEST(GroupShapeTest, GetShapeAtPointReturnsTopmostShape)
+{
+	auto group = std::make_shared<GroupShape>();
+	auto bottom = MakeRectangle({ 0, 0, 100, 100 }, 0xFF0000FF);
+	auto top = MakeRectangle({ 50, 50, 100, 100 }, 0x00FF00FF);
+	group->InsertShape(bottom);
+	group->InsertShape(top);
+
+	EXPECT_EQ(group->GetShapeAtPoint(25, 25), bottom);
+	EXPECT_EQ(group->GetShapeAtPoint(75, 75), top);
+	EXPECT_EQ(group->GetShapeAtPoint(200, 200), nullptr);
+
+	// Порядок и рамки в индексе следуют за вставкой и перемещением.
+	group->InsertShape(MakeRectangle({ 60, 60, 10, 10 }, 0x0000FFFF), 0);
+	EXPECT_EQ(group->GetShapeAtPoint(65, 65), top);
+	top->SetFrame({ 300, 300, 10, 10 });
+	EXPECT_EQ(group->GetShapeAtPoint(75, 75), bottom);
+	EXPECT_EQ(group->GetShapeAtPoint(305, 305), top);
+	group->RemoveShapeAtIndex(0);
+	EXPECT_EQ(group->GetShapeAtPoint(65, 65), bottom);
+}
+
+TEST(GroupShapeTest, RepeatedInsertionsKeepDrawingOrder)
+{
+	auto group = std::make_shared<GroupShape>();
+	std::vector<std::shared_ptr<IShape>> expected;
+	// Вставки в начало и в одно и то же место исчерпывают промежутки
+	// между соседями.
+	for (int i = 0; i < 100; ++i)
+	{
+		auto shape = MakeRectangle({ 0, 0, 10, 10 }, 0xFF0000FF);
+		const size_t position = i % 2 == 0 ? 0 : expected.size() / 2;
+		group->InsertShape(shape, position);
+		expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(position), shape);
+	}
+	EXPECT_EQ(group->GetShapeAtPoint(5, 5), expected.back());
+
+	group->RemoveShapeAtIndex(expected.size() - 1);
+	expected.pop_back();
+	EXPECT_EQ(group->GetShapeAtPoint(5, 5), expected.back());
+
+	auto top = MakeRectangle({ 0, 0, 10, 10 }, 0xFF0000FF);
+	group->InsertShape(top, 50);
+	EXPECT_NE(group->GetShapeAtPoint(5, 5), top);
+	group->InsertShape(top);
+	EXPECT_EQ(group->GetShapeAtPoint(5, 5), top);
+}
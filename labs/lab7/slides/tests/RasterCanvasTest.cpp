@@ -0,0 +1,178 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#include "../src/lib/Raster/RasterCanvas.h"
+#include "../src/lib/Raster/ThumbnailRenderer.h"
+#include "../src/lib/Shapes/GroupShape.h"
+#include "../src/lib/Shapes/Shapes.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace
+{
+constexpr RGBAColor k_white = 0xFFFFFFFF;
+
+// Доля покрытия чёрным по красному каналу.
+double GetCoverage(const RasterImage& image, int x, int y)
+{
+	return 1.0 - static_cast<double>(image.GetPixel(x, y) >> 24) / 255.0;
+}
+
+class ThrowingSlide : public IDrawable
+{
+public:
+	void Draw(ICanvas&) const override
+	{
+		throw std::runtime_error("slide failed");
+	}
+};
+
+double GetTotalCoverage(const RasterImage& image)
+{
+	double total = 0;
+	for (int y = 0; y < image.GetHeight(); ++y)
+	{
+		for (int x = 0; x < image.GetWidth(); ++x)
+		{
+			total += GetCoverage(image, x, y);
+		}
+	}
+	return total;
+}
+
+void FillRectangle(ICanvas& canvas, double left, double top, double right, double bottom)
+{
+	canvas.BeginFill(0x000000FF);
+	canvas.SetLineColor(0);
+	canvas.MoveTo(left, top);
+	canvas.LineTo(right, top);
+	canvas.LineTo(right, bottom);
+	canvas.LineTo(left, bottom);
+	canvas.EndFill();
+}
+} // namespace
+
+TEST(RasterCanvasTest, FillsRectangleWithPartialCoverageOnEdges)
+{
+	RasterImage image(10, 10, k_white);
+	RasterCanvas canvas(image);
+	FillRectangle(canvas, 2.5, 2, 6, 5.25);
+
+	EXPECT_EQ(0x000000FFu, image.GetPixel(3, 3));
+	EXPECT_EQ(k_white, image.GetPixel(1, 3));
+	EXPECT_EQ(k_white, image.GetPixel(6, 3));
+	EXPECT_NEAR(0.5, GetCoverage(image, 2, 3), 0.01);
+	EXPECT_NEAR(0.25, GetCoverage(image, 4, 5), 0.01);
+	EXPECT_NEAR(0.125, GetCoverage(image, 2, 5), 0.01);
+	EXPECT_NEAR(3.5 * 3.25, GetTotalCoverage(image), 0.05);
+}
+
+TEST(RasterCanvasTest, ClipsShapesOutsideImage)
+{
+	RasterImage image(10, 10, k_white);
+	RasterCanvas canvas(image);
+	FillRectangle(canvas, -20, -5, 4, 30);
+	EXPECT_NEAR(40.0, GetTotalCoverage(image), 0.05);
+	EXPECT_EQ(0x000000FFu, image.GetPixel(0, 0));
+	EXPECT_EQ(0x000000FFu, image.GetPixel(3, 9));
+
+	FillRectangle(canvas, 100, 100, 200, 200);
+	FillRectangle(canvas, -1e30, -1e30, -1e29, 1e30);
+	EXPECT_NEAR(40.0, GetTotalCoverage(image), 0.05);
+}
+
+TEST(RasterCanvasTest, EllipseAreaAndOutlineRing)
+{
+	RasterImage image(100, 100, k_white);
+	RasterCanvas canvas(image);
+	canvas.BeginFill(0x000000FF);
+	canvas.SetLineColor(0);
+	canvas.DrawEllipse(10, 20, 80, 60);
+	canvas.EndFill();
+	EXPECT_NEAR(M_PI * 40 * 30, GetTotalCoverage(image), M_PI * 40 * 30 * 0.005);
+
+	// Кольцо снаружи эллипса не закрашивает его середину.
+	RasterImage ring(100, 100, k_white);
+	RasterCanvas ringCanvas(ring);
+	ringCanvas.BeginFill(0);
+	ringCanvas.SetLineColor(0x000000FF);
+	ringCanvas.SetLineWidth(4);
+	ringCanvas.DrawEllipse(20, 20, 60, 60);
+	EXPECT_EQ(k_white, ring.GetPixel(50, 50));
+	EXPECT_EQ(0x000000FFu, ring.GetPixel(50, 18));
+	EXPECT_NEAR(M_PI * (34 * 34 - 30 * 30), GetTotalCoverage(ring), M_PI * (34 * 34 - 30 * 30) * 0.005);
+}
+
+TEST(RasterCanvasTest, WritesPpmAndPng)
+{
+	RasterImage image(2, 1, 0x102030FF);
+	std::ostringstream ppm;
+	WritePpm(image, ppm);
+	EXPECT_EQ("P6\n2 1\n255\n\x10\x20\x30\x10\x20\x30"s, ppm.str());
+
+	std::ostringstream png;
+	WritePng(image, png);
+	const std::string data = png.str();
+	EXPECT_EQ("\x89PNG\r\n\x1A\n"s, data.substr(0, 8));
+	EXPECT_EQ("IHDR", data.substr(12, 4));
+	EXPECT_EQ("IEND", data.substr(data.size() - 8, 4));
+	// Две строки по байту фильтра и два пикселя RGBA в несжатом блоке.
+	EXPECT_NE(std::string::npos, data.find("\x00\x10\x20\x30\xFF\x10\x20\x30\xFF"s));
+}
+
+TEST(ThumbnailRendererTest, ParallelRenderingMatchesSequential)
+{
+	std::vector<std::shared_ptr<const IDrawable>> slides;
+	for (int i = 0; i < 16; ++i)
+	{
+		auto slide = std::make_shared<GroupShape>();
+		slide->InsertShape(std::make_shared<SimpleShape>(
+			std::make_shared<DrawingStrategy>(MakeEllipseStrategy()),
+			RectD{ 10.0 * i, 20, 300, 200 }, std::make_unique<Style>(true, 0xFF0000FF),
+			std::make_unique<Style>(true, 0x000000FF)));
+		slide->InsertShape(std::make_shared<SimpleShape>(
+			std::make_shared<DrawingStrategy>(MakePolygonStrategy(3 + i)),
+			RectD{ 400, 10.0 * i, 200, 200 }, std::make_unique<Style>(true, 0x00FF0080),
+			std::make_unique<Style>(true, 0x0000FFFF)));
+		slides.push_back(slide);
+	}
+
+	const ThumbnailOptions options;
+	const std::vector<RasterImage> sequential = ThumbnailRenderer(1).Render(slides, options);
+	ThumbnailRenderer renderer(4);
+	EXPECT_EQ(4u, renderer.GetThreadCount());
+	const std::vector<RasterImage> parallel = renderer.Render(slides, options);
+	// Второй вызов идёт на тех же потоках.
+	const std::vector<RasterImage> again = renderer.Render(slides, options);
+
+	ASSERT_EQ(slides.size(), parallel.size());
+	for (size_t i = 0; i < slides.size(); ++i)
+	{
+		for (int y = 0; y < options.height; ++y)
+		{
+			ASSERT_TRUE(std::ranges::equal(sequential[i].GetRow(y), parallel[i].GetRow(y)));
+			ASSERT_TRUE(std::ranges::equal(sequential[i].GetRow(y), again[i].GetRow(y)));
+		}
+	}
+	EXPECT_NE(options.background, parallel[0].GetPixel(40, 30));
+}
+
+TEST(ThumbnailRendererTest, RethrowsSlideErrorAndStaysUsable)
+{
+	ThumbnailRenderer renderer(3);
+	std::vector<std::shared_ptr<const IDrawable>> slides(8, std::make_shared<GroupShape>());
+	slides[5] = std::make_shared<ThrowingSlide>();
+	EXPECT_THROW(renderer.Render(slides), std::runtime_error);
+
+	slides[5] = std::make_shared<GroupShape>();
+	EXPECT_EQ(slides.size(), renderer.Render(slides).size());
+	EXPECT_TRUE(renderer.Render({}).empty());
+}
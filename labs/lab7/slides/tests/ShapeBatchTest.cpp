@@ -0,0 +1,167 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#include "../src/lib/ShapeBatch.h"
+#include "../src/lib/Shapes/GroupShape.h"
+#include "../src/lib/Shapes/Shapes.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace
+{
+std::shared_ptr<SimpleShape> MakeShape(DrawingStrategy strategy, RectD frame)
+{
+	return std::make_shared<SimpleShape>(
+		std::make_shared<DrawingStrategy>(std::move(strategy)), frame,
+		std::make_unique<Style>(true, 0xFF0000FF),
+		std::make_unique<Style>(true, 0x00FF00FF));
+}
+} // namespace
+
+TEST(TessellatingCanvasTest, RectangleBecomesFillAndOutlineTriangles)
+{
+	std::vector<sf::Vertex> vertices;
+	TessellatingCanvas canvas(vertices);
+	MakeShape(MakeRectangleStrategy(), { 10, 20, 100, 50 })->Draw(canvas);
+
+	// Веер из 5 точек контура (последняя совпадает с первой) и 5 отрезков,
+	// один из которых нулевой длины.
+	ASSERT_EQ(5u * 3 + 4u * 6, vertices.size());
+	EXPECT_EQ(toSfColor(0xFF0000FF), vertices.front().color);
+	EXPECT_EQ(toSfColor(0x00FF00FF), vertices.back().color);
+	EXPECT_FLOAT_EQ(10.0f, vertices.front().position.x);
+	EXPECT_FLOAT_EQ(20.0f, vertices.front().position.y);
+}
+
+TEST(TessellatingCanvasTest, TransparentFillIsSkipped)
+{
+	std::vector<sf::Vertex> vertices;
+	TessellatingCanvas canvas(vertices);
+	canvas.BeginFill(0xFF000000);
+	canvas.SetLineColor(0);
+	canvas.DrawEllipse(0, 0, 10, 20);
+	EXPECT_TRUE(vertices.empty());
+
+	canvas.SetLineColor(0x000000FF);
+	canvas.DrawEllipse(0, 0, 10, 20);
+	EXPECT_EQ(k_ellipsePointCount * 6, vertices.size());
+}
+
+TEST(ShapeBatchTest, RetessellatesOnlyChangedShapes)
+{
+	ShapeBatch batch;
+	auto rect = MakeShape(MakeRectangleStrategy(), { 0, 0, 10, 10 });
+	auto ellipse = MakeShape(MakeEllipseStrategy(), { 20, 0, 10, 10 });
+	auto group = std::make_shared<GroupShape>();
+	group->InsertShape(MakeShape(MakeRectangleStrategy(), { 40, 0, 10, 10 }));
+	auto nested = MakeShape(MakeEllipseStrategy(), { 60, 0, 10, 10 });
+	group->InsertShape(nested);
+	batch.AddShape(rect);
+	batch.AddShape(ellipse);
+	batch.AddShape(group);
+
+	EXPECT_EQ(4u, batch.Update());
+	EXPECT_EQ(3u, batch.GetShapesCount());
+	EXPECT_EQ(0u, batch.Update());
+	const size_t vertexCount = batch.GetVertices().size();
+
+	ellipse->SetFillColor(0x0000FFFF);
+	EXPECT_EQ(1u, batch.Update());
+	EXPECT_EQ(vertexCount, batch.GetVertices().size());
+	EXPECT_EQ(toSfColor(0x0000FFFF), batch.GetVertices()[39].color);
+
+	// Изменение внутри группы перерисовывает только изменившуюся фигуру.
+	nested->SetOutlineColor(0x00FF0000);
+	EXPECT_EQ(1u, batch.Update());
+	EXPECT_EQ(vertexCount - k_ellipsePointCount * 6, batch.GetVertices().size());
+	EXPECT_EQ(0u, batch.Update());
+}
+
+TEST(ShapeBatchTest, VisibleRangesSkipShapesOutsideViewport)
+{
+	ShapeBatch batch;
+	auto first = MakeShape(MakeRectangleStrategy(), { 0, 0, 10, 10 });
+	auto second = MakeShape(MakeRectangleStrategy(), { 20, 0, 10, 10 });
+	auto far = MakeShape(MakeRectangleStrategy(), { 1000, 1000, 10, 10 });
+	auto last = MakeShape(MakeRectangleStrategy(), { 40, 0, 10, 10 });
+	batch.AddShape(first);
+	batch.AddShape(second);
+	batch.AddShape(far);
+	batch.AddShape(last);
+
+	const std::vector<ShapeBatch::Range> ranges = batch.GetVisibleRanges({ 0, 0, 100, 100 });
+	const size_t shapeSize = batch.GetVertices().size() / 4;
+	ASSERT_EQ(2u, ranges.size());
+	EXPECT_EQ(0u, ranges[0].offset);
+	EXPECT_EQ(2 * shapeSize, ranges[0].count);
+	EXPECT_EQ(3 * shapeSize, ranges[1].offset);
+	EXPECT_EQ(shapeSize, ranges[1].count);
+
+	// Переехавшая фигура попадает в вид.
+	far->SetFrame({ 60, 0, 10, 10 });
+	EXPECT_EQ(1u, batch.GetVisibleRanges({ 0, 0, 100, 100 }).size());
+	EXPECT_TRUE(batch.GetVisibleRanges({ 500, 500, 10, 10 }).empty());
+}
+
+TEST(ShapeBatchTest, RetessellatesGroupWhenChildChangesWithoutChangingGroup)
+{
+	ShapeBatch batch;
+	auto group = std::make_shared<GroupShape>();
+	auto red = MakeShape(MakeRectangleStrategy(), { 0, 0, 10, 10 });
+	auto blue = MakeShape(MakeRectangleStrategy(), { 20, 0, 10, 10 });
+	blue->SetFillColor(0x0000FFFF);
+	group->InsertShape(red);
+	group->InsertShape(blue);
+	batch.AddShape(group);
+	EXPECT_EQ(2u, batch.Update());
+
+	// Общего цвета заливки у группы нет ни до, ни после перекраски.
+	red->SetFillColor(0xFFFF00FF);
+	EXPECT_EQ(1u, batch.Update());
+	EXPECT_EQ(toSfColor(0xFFFF00FF), batch.GetVertices().front().color);
+
+	// Фигура сдвигается внутри рамки группы, рамка не меняется.
+	red->SetFrame({ 5, 0, 5, 10 });
+	EXPECT_EQ(1u, batch.Update());
+	EXPECT_FLOAT_EQ(5.0f, batch.GetVertices().front().position.x);
+
+	// Раскладывается только вставленная фигура, остальные копируются.
+	const size_t shapeSize = batch.GetVertices().size() / 2;
+	group->InsertShape(MakeShape(MakeRectangleStrategy(), { 10, 0, 10, 10 }), 1);
+	EXPECT_EQ(1u, batch.Update());
+	EXPECT_EQ(0u, batch.Update());
+	ASSERT_EQ(3 * shapeSize, batch.GetVertices().size());
+	EXPECT_FLOAT_EQ(10.0f, batch.GetVertices()[shapeSize].position.x);
+	EXPECT_EQ(toSfColor(0x0000FFFF), batch.GetVertices()[2 * shapeSize].color);
+
+	group->RemoveShapeAtIndex(0);
+	EXPECT_EQ(0u, batch.Update());
+	ASSERT_EQ(2 * shapeSize, batch.GetVertices().size());
+	EXPECT_FLOAT_EQ(10.0f, batch.GetVertices().front().position.x);
+
+	// Удалённая фигура больше не наблюдается.
+	red->SetFillColor(0x00FF00FF);
+	EXPECT_EQ(0u, batch.Update());
+}
+
+TEST(ShapeBatchTest, VisibleRangesSkipGroupChildrenOutsideViewport)
+{
+	ShapeBatch batch;
+	auto group = std::make_shared<GroupShape>();
+	auto inner = std::make_shared<GroupShape>();
+	group->InsertShape(MakeShape(MakeRectangleStrategy(), { 0, 0, 10, 10 }));
+	inner->InsertShape(MakeShape(MakeRectangleStrategy(), { 1000, 1000, 10, 10 }));
+	inner->InsertShape(MakeShape(MakeRectangleStrategy(), { 20, 0, 10, 10 }));
+	group->InsertShape(inner);
+	batch.AddShape(group);
+
+	const std::vector<ShapeBatch::Range> ranges = batch.GetVisibleRanges({ 0, 0, 100, 100 });
+	const size_t shapeSize = batch.GetVertices().size() / 3;
+	ASSERT_EQ(2u, ranges.size());
+	EXPECT_EQ(0u, ranges[0].offset);
+	EXPECT_EQ(shapeSize, ranges[0].count);
+	EXPECT_EQ(2 * shapeSize, ranges[1].offset);
+	EXPECT_EQ(shapeSize, ranges[1].count);
+	EXPECT_EQ(1u, batch.GetShapesCount());
+}
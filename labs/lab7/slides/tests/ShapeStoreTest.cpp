@@ -0,0 +1,92 @@
+//
+// Created by smmm on 28.11.2025.
+//
+
+#include "../src/lib/Canvas.h"
+#include "../src/lib/Shapes/GroupShape.h"
+#include "../src/lib/Shapes/ShapeStore.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+namespace
+{
+std::vector<sf::Vertex> Tessellate(const IDrawable& drawable)
+{
+	std::vector<sf::Vertex> vertices;
+	TessellatingCanvas canvas(vertices);
+	drawable.Draw(canvas);
+	return vertices;
+}
+
+bool AreSame(const std::vector<sf::Vertex>& a, const std::vector<sf::Vertex>& b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const sf::Vertex& x, const sf::Vertex& y) {
+		return x.position.x == y.position.x && x.position.y == y.position.y && x.color == y.color;
+	});
+}
+} // namespace
+
+TEST(ShapeStoreTest, DrawsLikeSimpleShapes)
+{
+	auto store = std::make_shared<ShapeStore>();
+	store->AddShape(ShapeKind::Rectangle, { 0, 0, 10, 20 }, 0xFF0000FF, 0x000000FF);
+	store->AddShape(ShapeKind::Ellipse, { 30, 0, 10, 20 }, 0x00FF00FF, 0x000000FF);
+	store->AddShape(ShapeKind::Polygon, { 60, 0, 10, 20 }, 0x0000FFFF, 0x000000FF, 1, 5);
+
+	const auto makeShape = [](DrawingStrategy strategy, RectD frame, RGBAColor fill) {
+		return std::make_shared<SimpleShape>(std::make_shared<DrawingStrategy>(std::move(strategy)),
+			frame, std::make_unique<Style>(true, fill), std::make_unique<Style>(true, 0x000000FF));
+	};
+	GroupShape expected;
+	expected.InsertShape(makeShape(MakeRectangleStrategy(), { 0, 0, 10, 20 }, 0xFF0000FF));
+	expected.InsertShape(makeShape(MakeEllipseStrategy(), { 30, 0, 10, 20 }, 0x00FF00FF));
+	expected.InsertShape(makeShape(MakePolygonStrategy(5), { 60, 0, 10, 20 }, 0x0000FFFF));
+
+	std::vector<sf::Vertex> vertices;
+	TessellatingCanvas canvas(vertices);
+	store->Draw(canvas);
+	EXPECT_TRUE(AreSame(Tessellate(expected), vertices));
+}
+
+TEST(ShapeStoreTest, HandleIsViewIntoColumns)
+{
+	auto store = std::make_shared<ShapeStore>();
+	const size_t index = store->AddShape(ShapeKind::Rectangle, { 0, 0, 10, 10 }, 0xFF0000FF, 0x000000FF, 2);
+	std::shared_ptr<IShape> shape = store->GetShape(index);
+	EXPECT_EQ(shape, store->GetShape(index));
+	EXPECT_EQ(2, shape->GetOutlineThickness());
+
+	shape->SetFrame({ 5, 6, 7, 8 });
+	EXPECT_EQ(7, store->GetFrame(index).width);
+	shape->EnableFill(false);
+	EXPECT_EQ(0x000000FFu, shape->GetFillStyle().GetColor());
+
+	std::shared_ptr<IShape> clone = shape->Clone();
+	EXPECT_EQ(2u, store->GetShapesCount());
+	EXPECT_EQ(std::optional<bool>(false), clone->GetFillStyle().IsEnabled());
+	EXPECT_EQ(8, clone->GetFrame().height);
+	EXPECT_THROW(store->GetShape(2), std::out_of_range);
+}
+
+TEST(ShapeStoreTest, BulkOperationsNotifyGroups)
+{
+	auto store = std::make_shared<ShapeStore>();
+	for (int i = 0; i < 10; ++i)
+	{
+		store->AddShape(ShapeKind::Ellipse, { i * 10.0, 0, 10, 10 }, 0xFF0000FF, 0x000000FF);
+	}
+	GroupShape group;
+	group.InsertShape(store->GetShape(0));
+	group.InsertShape(store->GetShape(9));
+
+	store->Move(5, 5);
+	EXPECT_EQ(5, group.GetFrame().left);
+	EXPECT_EQ(5, group.GetFrame().top);
+	EXPECT_EQ(95, store->GetFrame(9).left);
+
+	store->SetFillColor(0x00FF00FF);
+	EXPECT_EQ(0x00FF00FFu, group.GetFillStyle().GetColor());
+	group.SetOutlineColor(0x0000FFFF);
+	EXPECT_EQ(0x0000FFFFu, store->GetShape(0)->GetOutlineStyle().GetColor());
+}
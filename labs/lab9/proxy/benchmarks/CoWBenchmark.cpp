@@ -0,0 +1,72 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#include "../src/lib/Image.h"
+
+#include <benchmark/benchmark.h>
+
+// Нагрузка из CoWConcurrencyTest: несколько потоков снимают копии одних и тех
+// же тайлов и пишут в них. Аргумент Threads — число таких потоков; все они
+// бьются за счётчик ссылок общего блока.
+namespace
+{
+const CoW<Tile>& GetSharedTile()
+{
+	static const CoW<Tile> tile(7);
+	return tile;
+}
+
+// Копия общего тайла и запись в неё: счётчик увеличивается, проверка
+// уникальности не проходит, тайл копируется, а старый счётчик уменьшается.
+void BM_CoWDetachShared(benchmark::State& state)
+{
+	const CoW<Tile>& shared = GetSharedTile();
+	Color color = 0;
+	for (auto _ : state)
+	{
+		CoW<Tile> copy = shared;
+		copy.Write()->SetPixel({ 0, 0 }, ++color);
+		benchmark::DoNotOptimize(copy);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CoWDetachShared)->ThreadRange(1, 8)->UseRealTime();
+
+// Запись в собственную копию: остаётся только проверка уникальности.
+void BM_CoWWriteUnique(benchmark::State& state)
+{
+	CoW<Tile> tile(0);
+	Color color = 0;
+	for (auto _ : state)
+	{
+		tile.Write()->SetPixel({ 0, 0 }, ++color);
+		benchmark::DoNotOptimize(tile);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CoWWriteUnique)->ThreadRange(1, 8)->UseRealTime();
+
+// Снимок общего изображения 4x4 тайла и запись по пикселю в каждый тайл
+// снимка. items/s — снимки.
+void BM_ImageSnapshotWrites(benchmark::State& state)
+{
+	static const Image master({ 4 * Tile::SIZE, 4 * Tile::SIZE }, 0);
+	Color color = 0;
+	for (auto _ : state)
+	{
+		Image snapshot = master.Snapshot();
+		++color;
+		for (int y = 0; y < 4; ++y)
+		{
+			for (int x = 0; x < 4; ++x)
+			{
+				snapshot.SetPixel({ x * Tile::SIZE, y * Tile::SIZE }, color);
+			}
+		}
+		benchmark::DoNotOptimize(snapshot);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImageSnapshotWrites)->ThreadRange(1, 8)->UseRealTime();
+} // namespace
@@ -0,0 +1,122 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#include "../src/lib/Image.h"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Сжатие изображения, в котором тайлы записаны по отдельности, но содержимое
+// у них повторяется: всего PATTERN_COUNT разных тайлов. Счётчики
+// tiles_before и tiles_after — число различных экземпляров до и после
+// сжатия, ms_per_megapixel — время сжатия в расчёте на мегапиксель
+// изображения.
+namespace
+{
+constexpr Size IMAGE_SIZE{ 4096, 4096 };
+constexpr int PATTERN_COUNT = 4;
+constexpr double MEGAPIXEL = 1e6;
+
+double GetMegapixels()
+{
+	return static_cast<double>(IMAGE_SIZE.width) * IMAGE_SIZE.height / MEGAPIXEL;
+}
+
+Image MakeRepeatingImage()
+{
+	Image image(IMAGE_SIZE, 0);
+	std::vector<Color> row(static_cast<size_t>(IMAGE_SIZE.width));
+	for (int y = 0; y < IMAGE_SIZE.height; ++y)
+	{
+		for (int x = 0; x < IMAGE_SIZE.width; ++x)
+		{
+			const int pattern = (x / Tile::SIZE) % PATTERN_COUNT;
+			row[static_cast<size_t>(x)] = static_cast<Color>((x % Tile::SIZE) ^ (y % Tile::SIZE) << 8 | pattern << 16);
+		}
+		image.WriteRow(y, row);
+	}
+	return image;
+}
+
+void SetCounters(benchmark::State& state, size_t tilesBefore, size_t tilesAfter, double seconds)
+{
+	state.counters["tiles_before"] = static_cast<double>(tilesBefore);
+	state.counters["tiles_after"] = static_cast<double>(tilesAfter);
+	state.counters["ms_per_megapixel"] = seconds * 1000 / GetMegapixels() / static_cast<double>(state.iterations());
+	state.SetLabel("tile " + std::to_string(Tile::SIZE));
+}
+
+// Полный Compact: хешируется и сравнивается каждый тайл.
+void BM_Compact(benchmark::State& state)
+{
+	size_t tilesBefore = 0;
+	size_t tilesAfter = 0;
+	double seconds = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		Image image = MakeRepeatingImage();
+		tilesBefore = image.GetUniqueTileCount();
+		state.ResumeTiming();
+
+		const auto start = std::chrono::steady_clock::now();
+		benchmark::DoNotOptimize(image.Compact());
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		state.PauseTiming();
+		tilesAfter = image.GetUniqueTileCount();
+		state.ResumeTiming();
+	}
+	SetCounters(state, tilesBefore, tilesAfter, seconds);
+}
+BENCHMARK(BM_Compact)->Unit(benchmark::kMillisecond);
+
+// Автоматическое сжатие после записи в range(0) тайлов: проход сравнивает с
+// запомненными образцами только изменённые тайлы, поэтому время на
+// мегапиксель изображения много меньше, чем у полного Compact. Засекается
+// последняя запись, которая и запускает проход. Запись не меняет пикселей,
+// и каждый тайл сливается обратно со своим образцом.
+void BM_AutoCompaction(benchmark::State& state)
+{
+	const auto changedTiles = static_cast<int>(state.range(0));
+	Image image = MakeRepeatingImage();
+	image.SetAutoCompaction(static_cast<size_t>(changedTiles));
+	image.Compact();
+	const Size grid = image.GetTileGridSize();
+
+	int next = 0;
+	auto touchNextTile = [&] {
+		const int tileIndex = next++ % (grid.width * grid.height);
+		const Point p{ tileIndex % grid.width * Tile::SIZE, tileIndex / grid.width * Tile::SIZE };
+		image.SetPixel(p, image.GetPixel(p));
+	};
+
+	size_t tilesBefore = 0;
+	size_t tilesAfter = 0;
+	double seconds = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		for (int i = 1; i < changedTiles; ++i)
+		{
+			touchNextTile();
+		}
+		// Последний тайл ещё не отделён, он добавится при записи.
+		tilesBefore = image.GetUniqueTileCount() + 1;
+		state.ResumeTiming();
+
+		const auto start = std::chrono::steady_clock::now();
+		touchNextTile();
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		state.PauseTiming();
+		tilesAfter = image.GetUniqueTileCount();
+		state.ResumeTiming();
+	}
+	SetCounters(state, tilesBefore, tilesAfter, seconds);
+}
+BENCHMARK(BM_AutoCompaction)->Arg(64)->Arg(1024)->Unit(benchmark::kMillisecond);
+} // namespace
@@ -0,0 +1,89 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#include "../src/lib/ImageProcessor.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Градиент по строкам и столбцам: все тайлы разные, как в настоящем кадре.
+Image MakeImage(Size size)
+{
+	Image image(size, 0);
+	std::vector<Color> row(static_cast<size_t>(size.width));
+	for (int y = 0; y < size.height; ++y)
+	{
+		for (int x = 0; x < size.width; ++x)
+		{
+			row[static_cast<size_t>(x)] = static_cast<Color>((x & 0xFF) << 16 | (y & 0xFF) << 8 | ((x + y) & 0xFF));
+		}
+		image.WriteRow(y, row);
+	}
+	return image;
+}
+
+std::string GetFilePath()
+{
+	return (std::filesystem::temp_directory_path() / "lab9_image_io_benchmark.pnm").string();
+}
+
+Size GetSize(const benchmark::State& state)
+{
+	return { static_cast<int>(state.range(0)), static_cast<int>(state.range(1)) };
+}
+
+// Аргументы — ширина и высота кадра; bytes/s в отчёте — байт пикселей RGB.
+void SetPixelBytes(benchmark::State& state)
+{
+	state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * 3);
+}
+
+void BM_SaveImage(benchmark::State& state, ImageFormat format)
+{
+	const Image image = MakeImage(GetSize(state));
+	const std::string path = GetFilePath();
+	for (auto _ : state)
+	{
+		SaveImage(image, path, format);
+	}
+	SetPixelBytes(state);
+	std::filesystem::remove(path);
+}
+
+// Файл остаётся в кэше страниц, поэтому измеряется разбор, а не диск.
+void BM_ImportImage(benchmark::State& state, ImageFormat format)
+{
+	const std::string path = GetFilePath();
+	SaveImage(MakeImage(GetSize(state)), path, format);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ImportImage(path));
+	}
+	SetPixelBytes(state);
+	std::filesystem::remove(path);
+}
+
+constexpr int64_t WIDTH_4K = 3840;
+constexpr int64_t HEIGHT_4K = 2160;
+constexpr int64_t WIDTH_8K = 7680;
+constexpr int64_t HEIGHT_8K = 4320;
+
+#define IMAGE_IO_BENCHMARK(func, format)                   \
+	BENCHMARK_CAPTURE(func, format, ImageFormat::format) \
+		->Args({ WIDTH_4K, HEIGHT_4K })                  \
+		->Args({ WIDTH_8K, HEIGHT_8K })                  \
+		->UseRealTime()                                  \
+		->Unit(benchmark::kMillisecond)
+
+IMAGE_IO_BENCHMARK(BM_SaveImage, PlainPpm);
+IMAGE_IO_BENCHMARK(BM_SaveImage, BinaryPpm);
+IMAGE_IO_BENCHMARK(BM_SaveImage, Pam);
+IMAGE_IO_BENCHMARK(BM_ImportImage, PlainPpm);
+IMAGE_IO_BENCHMARK(BM_ImportImage, BinaryPpm);
+IMAGE_IO_BENCHMARK(BM_ImportImage, Pam);
+} // namespace
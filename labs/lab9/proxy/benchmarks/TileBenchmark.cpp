@@ -0,0 +1,123 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#include "../src/lib/Image.h"
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+// Размер тайла задаётся при сборке, поэтому каждая сборка измеряет один
+// размер: для сравнения бенчмарки собирают с OOD_TILE_SIZE 8, 16, 32 и 64.
+// Размер тайла выводится в метке каждого результата.
+namespace
+{
+constexpr Size IMAGE_SIZE{ 4096, 4096 };
+constexpr double MEGAPIXEL = 1e6;
+
+int64_t GetPixelCount()
+{
+	return static_cast<int64_t>(IMAGE_SIZE.width) * IMAGE_SIZE.height;
+}
+
+// Все тайлы разные, как в настоящем кадре, и ни один не общий.
+Image MakeImage()
+{
+	Image image(IMAGE_SIZE, 0);
+	std::vector<Color> row(static_cast<size_t>(IMAGE_SIZE.width));
+	for (int y = 0; y < IMAGE_SIZE.height; ++y)
+	{
+		for (int x = 0; x < IMAGE_SIZE.width; ++x)
+		{
+			row[static_cast<size_t>(x)] = static_cast<Color>(x ^ y);
+		}
+		image.WriteRow(y, row);
+	}
+	return image;
+}
+
+void SetTileLabel(benchmark::State& state)
+{
+	state.SetLabel("tile " + std::to_string(Tile::SIZE));
+}
+
+// Память под пиксели в пуле и под сетку ссылок на тайлы в расчёте на
+// мегапиксель; items/s в отчёте — записанные пиксели.
+void BM_TileMemory(benchmark::State& state)
+{
+	const SlabPool& pool = Tile::allocator_type::GetPool();
+	double bytesPerMegapixel = 0;
+	for (auto _ : state)
+	{
+		const size_t liveBlocks = pool.GetLiveBlockCount();
+		Image image = MakeImage();
+		const auto grid = image.GetTileGridSize();
+		const size_t tileCount = static_cast<size_t>(grid.width) * grid.height;
+		const size_t bytes = (pool.GetLiveBlockCount() - liveBlocks) * pool.GetBlockSize()
+			+ tileCount * sizeof(CoW<Tile>);
+		bytesPerMegapixel = static_cast<double>(bytes) / (static_cast<double>(GetPixelCount()) / MEGAPIXEL);
+	}
+	state.counters["bytes_per_megapixel"] = bytesPerMegapixel;
+	state.SetItemsProcessed(state.iterations() * GetPixelCount());
+	SetTileLabel(state);
+}
+BENCHMARK(BM_TileMemory)->Unit(benchmark::kMillisecond);
+
+// Заливка прямоугольника, не выровненного по тайлам: внутренние тайлы
+// становятся общими, краевые заливаются построчно. items/s — пиксели.
+void BM_FillRect(benchmark::State& state)
+{
+	Image image = MakeImage();
+	Color color = 0;
+	for (auto _ : state)
+	{
+		image.FillRect({ 3, 3 }, { IMAGE_SIZE.width - 6, IMAGE_SIZE.height - 6 }, ++color);
+	}
+	state.SetItemsProcessed(state.iterations() * GetPixelCount());
+	SetTileLabel(state);
+}
+BENCHMARK(BM_FillRect)->Unit(benchmark::kMillisecond);
+
+// Заливка по строкам: каждый тайл остаётся собственным и переписывается
+// целиком. items/s — пиксели.
+void BM_FillSpans(benchmark::State& state)
+{
+	Image image = MakeImage();
+	Color color = 0;
+	for (auto _ : state)
+	{
+		++color;
+		for (int y = 0; y < IMAGE_SIZE.height; ++y)
+		{
+			image.FillSpan({ 0, y }, IMAGE_SIZE.width, color);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * GetPixelCount());
+	SetTileLabel(state);
+}
+BENCHMARK(BM_FillSpans)->Unit(benchmark::kMillisecond);
+
+// Копирование при записи: в копии изображения меняется по пикселю в каждом
+// тайле, так что копируются все тайлы. bytes/s — байты скопированных пикселей.
+void BM_CopyTiles(benchmark::State& state)
+{
+	const Image image = MakeImage();
+	const auto grid = image.GetTileGridSize();
+	for (auto _ : state)
+	{
+		Image copy = image;
+		for (int tileY = 0; tileY < grid.height; ++tileY)
+		{
+			for (int tileX = 0; tileX < grid.width; ++tileX)
+			{
+				copy.SetPixel({ tileX * Tile::SIZE, tileY * Tile::SIZE }, 0);
+			}
+		}
+		benchmark::DoNotOptimize(copy);
+	}
+	state.SetBytesProcessed(state.iterations() * GetPixelCount() * static_cast<int64_t>(sizeof(Color)));
+	SetTileLabel(state);
+}
+BENCHMARK(BM_CopyTiles)->Unit(benchmark::kMillisecond);
+} // namespace
@@ -1,26 +1,160 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <memory>
+#include <utility>
+
+// Счётчик ссылок живёт в том же блоке, что и объект. Проверка уникальности
+// читает его с acquire: если другой поток только что отпустил свою копию,
+// его чтения объекта гарантированно завершились до нашей записи. Поэтому
+// копии одного CoW можно менять в разных потоках одновременно.
+class CoWBlock
+{
+public:
+	CoWBlock() = default;
+	CoWBlock(const CoWBlock&) = delete;
+	CoWBlock& operator=(const CoWBlock&) = delete;
+
+	void AddRef() noexcept
+	{
+		m_refs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Release() noexcept
+	{
+		if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Destroy();
+		}
+	}
+
+	bool IsUnique() const noexcept
+	{
+		return m_refs.load(std::memory_order_acquire) == 1;
+	}
+
+	int GetRefCount() const noexcept
+	{
+		return m_refs.load(std::memory_order_relaxed);
+	}
+
+protected:
+	virtual ~CoWBlock() = default;
+	virtual void Destroy() noexcept = 0;
+
+private:
+	std::atomic<int> m_refs = 1;
+};
+
+// Объект внутри блока. Если у T есть allocator_type, блок размещается через
+// него, иначе через std::allocator.
+template <typename T, typename Allocator>
+class CoWInlineBlock final : public CoWBlock
+{
+	using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<CoWInlineBlock>;
+	using Traits = std::allocator_traits<BlockAllocator>;
+
+public:
+	template <typename... Args>
+	static CoWInlineBlock* Create(Args&&... args)
+	{
+		BlockAllocator allocator;
+		CoWInlineBlock* block = Traits::allocate(allocator, 1);
+		try
+		{
+			Traits::construct(allocator, block, std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			Traits::deallocate(allocator, block, 1);
+			throw;
+		}
+		return block;
+	}
+
+	template <typename... Args>
+	explicit CoWInlineBlock(Args&&... args)
+		: m_object(std::forward<Args>(args)...)
+	{
+	}
+
+	T* GetObject() noexcept
+	{
+		return &m_object;
+	}
+
+private:
+	void Destroy() noexcept override
+	{
+		BlockAllocator allocator;
+		Traits::destroy(allocator, this);
+		Traits::deallocate(allocator, this, 1);
+	}
+
+	T m_object;
+};
+
+// Объект, созданный отдельно, например через Clone().
+template <typename T>
+class CoWOwningBlock final : public CoWBlock
+{
+public:
+	explicit CoWOwningBlock(std::unique_ptr<T> object)
+		: m_object(std::move(object))
+	{
+	}
+
+	T* GetObject() noexcept
+	{
+		return m_object.get();
+	}
+
+private:
+	void Destroy() noexcept override
+	{
+		delete this;
+	}
+
+	std::unique_ptr<T> m_object;
+};
 
 template <typename T>
 class CoW
 {
+	template <typename U>
+	friend class CoW;
+
+	template <typename U>
+	struct AllocatorOf
+	{
+		using type = std::allocator<U>;
+	};
+
+	template <typename U>
+		requires requires { typename U::allocator_type; }
+	struct AllocatorOf<U>
+	{
+		using type = typename U::allocator_type;
+	};
+
+	using InlineBlock = CoWInlineBlock<T, typename AllocatorOf<T>::type>;
+
 	template <typename U>
 	struct CopyConstr
 	{
-		static std::unique_ptr<U> Copy(U const& other)
+		static CoW Copy(U const& other)
 		{
-			return std::make_unique<T>(other);
+			return CoW(other);
 		}
 	};
 
 	template <typename U>
 	struct CloneConstr
 	{
-		static std::unique_ptr<U> Copy(U const& other)
+		static CoW Copy(U const& other)
 		{
-			return other.Clone();
+			return CoW(other.Clone());
 		}
 	};
 	using CopyClass = typename std::conditional<!std::is_abstract<T>::value
@@ -57,94 +191,142 @@ public:
 	template <typename... Args,
 		typename = std::enable_if<!std::is_abstract<T>::value>::type>
 	CoW(Args&&... args)
-		: m_shared(std::make_shared<T>(std::forward<Args>(args)...))
 	{
+		auto* block = InlineBlock::Create(std::forward<Args>(args)...);
+		m_block = block;
+		m_object = block->GetObject();
 	}
 
 	// avoid duplicate object
-	CoW(CoW<T>&& rhs)
-		: m_shared(std::move(rhs.m_shared))
+	CoW(CoW<T>&& rhs) noexcept
+		: m_block(std::exchange(rhs.m_block, nullptr))
+		, m_object(std::exchange(rhs.m_object, nullptr))
 	{
 	}
 
 	CoW(std::unique_ptr<T> pUniqueObj)
-		: m_shared(std::move(pUniqueObj))
 	{
+		auto* block = new CoWOwningBlock<T>(std::move(pUniqueObj));
+		m_block = block;
+		m_object = block->GetObject();
 	}
 
-	CoW& operator=(CoW<T>&& rhs)
+	CoW& operator=(CoW<T>&& rhs) noexcept
 	{
-		m_shared = std::move(rhs.m_shared);
+		if (this != &rhs)
+		{
+			Reset();
+			m_block = std::exchange(rhs.m_block, nullptr);
+			m_object = std::exchange(rhs.m_object, nullptr);
+		}
 		return *this;
 	}
 
 	template <typename U>
 	CoW(CoW<U>& rhs)
-		: m_shared(rhs.m_shared)
+		: m_block(rhs.m_block)
+		, m_object(rhs.m_object)
 	{
+		AddRef();
 	}
 
 	template <typename U>
 	CoW& operator=(CoW<U>& rhs)
 	{
-		m_shared = rhs.m_shared;
-		return *this;
+		return Assign(rhs.m_block, rhs.m_object);
 	}
 
 	// vc generate copy, but c++11 don't allow this, implement for gcc
 
 	CoW(CoW const& rhs)
-		: m_shared(rhs.m_shared)
+		: m_block(rhs.m_block)
+		, m_object(rhs.m_object)
 	{
+		AddRef();
 	}
 
 	CoW& operator=(CoW const& rhs)
 	{
-		m_shared = rhs.m_shared;
-		return *this;
+		return Assign(rhs.m_block, rhs.m_object);
+	}
+
+	~CoW()
+	{
+		Reset();
 	}
 
 	T const& operator*() const&& noexcept = delete;
 	T const& operator*() const& noexcept
 	{
-		assert(m_shared);
-		return *m_shared;
+		assert(m_object);
+		return *m_object;
 	}
 
 	T const* operator->() const&& noexcept = delete;
 	T const* operator->() const& noexcept
 	{
-		assert(m_shared);
-		return m_shared.get();
+		assert(m_object);
+		return m_object;
 	}
 
 	[[nodiscard]] WriteProxy operator--(int) &
 	{
-		assert(m_shared);
+		assert(m_object);
 		EnsureUnique();
-		return WriteProxy(m_shared.get());
+		return WriteProxy(m_object);
 	}
 
 	WriteProxy Write() &
 	{
-		assert(m_shared);
+		assert(m_object);
 		EnsureUnique();
-		return WriteProxy(m_shared.get());
+		return WriteProxy(m_object);
 	}
 
 	int GetLinksCount() const noexcept
 	{
-		return m_shared.use_count();
+		return m_block ? m_block->GetRefCount() : 0;
 	}
 
 private:
+	void AddRef() noexcept
+	{
+		if (m_block)
+		{
+			m_block->AddRef();
+		}
+	}
+
+	void Reset() noexcept
+	{
+		if (m_block)
+		{
+			m_block->Release();
+			m_block = nullptr;
+			m_object = nullptr;
+		}
+	}
+
+	CoW& Assign(CoWBlock* block, T* object) noexcept
+	{
+		if (block)
+		{
+			block->AddRef();
+		}
+		Reset();
+		m_block = block;
+		m_object = object;
+		return *this;
+	}
+
 	void EnsureUnique()
 	{
-		if (m_shared.use_count() != 1)
+		if (!m_block->IsUnique())
 		{
-			m_shared = CopyClass::Copy(*m_shared);
+			*this = CopyClass::Copy(*m_object);
 		}
 	}
 
-	std::shared_ptr<T> m_shared;
+	CoWBlock* m_block = nullptr;
+	T* m_object = nullptr;
 };
@@ -0,0 +1,232 @@
+//
+// Created by smmm on 05.12.2025.
+//
+#include "Compositor.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPOSITOR_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+constexpr uint32_t ALPHA_SHIFT = 24;
+
+// x / 255 с округлением, точно для x из [0, 255 * 255].
+uint32_t Div255(uint32_t x) noexcept
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+// Смешивание одного канала: b — цвет режима, затем наложение поверх d с
+// альфой источника. Векторное ядро повторяет эти же шаги по 16 бит.
+template <BlendMode Mode>
+uint32_t BlendChannel(uint32_t s, uint32_t d, uint32_t alpha) noexcept
+{
+	uint32_t b = s;
+	if constexpr (Mode == BlendMode::Multiply)
+	{
+		b = Div255(s * d);
+	}
+	else if constexpr (Mode == BlendMode::Screen)
+	{
+		b = s + d - Div255(s * d);
+	}
+	return Div255(b * alpha + d * (255 - alpha));
+}
+
+template <BlendMode Mode>
+void BlendScalar(const Color* src, Color* dst, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Color s = src[i];
+		const Color d = dst[i];
+		const uint32_t alpha = s >> ALPHA_SHIFT;
+		Color result = Div255(255 * alpha + (d >> ALPHA_SHIFT) * (255 - alpha)) << ALPHA_SHIFT;
+		for (uint32_t shift = 0; shift < ALPHA_SHIFT; shift += 8)
+		{
+			result |= BlendChannel<Mode>(s >> shift & 0xFF, d >> shift & 0xFF, alpha) << shift;
+		}
+		dst[i] = result;
+	}
+}
+
+#ifdef COMPOSITOR_X86
+// Восемь пикселей за шаг: байты раскладываются в 16-битные поля, альфа
+// каждого пикселя размножается на его четыре поля. В поле альфы цвет режима
+// равен 255, поэтому та же формула даёт sa + da * (1 - sa).
+__attribute__((target("avx2"))) __m256i Div255Avx2(__m256i x)
+{
+	x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+template <BlendMode Mode>
+__attribute__((target("avx2"))) __m256i BlendHalfAvx2(__m256i s, __m256i d)
+{
+	const __m256i alphaLanes = _mm256_set1_epi64x(static_cast<int64_t>(0x00FF000000000000));
+	__m256i alpha = _mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+	const __m256i inverseAlpha = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+
+	__m256i b = s;
+	if constexpr (Mode == BlendMode::Multiply)
+	{
+		b = Div255Avx2(_mm256_mullo_epi16(s, d));
+	}
+	else if constexpr (Mode == BlendMode::Screen)
+	{
+		b = _mm256_sub_epi16(_mm256_add_epi16(s, d), Div255Avx2(_mm256_mullo_epi16(s, d)));
+	}
+	b = _mm256_or_si256(b, alphaLanes);
+	return Div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(b, alpha), _mm256_mullo_epi16(d, inverseAlpha)));
+}
+
+template <BlendMode Mode>
+__attribute__((target("avx2"))) void BlendAvx2(const Color* src, Color* dst, size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+		const __m256i low = BlendHalfAvx2<Mode>(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+		const __m256i high = BlendHalfAvx2<Mode>(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(low, high));
+	}
+	BlendScalar<Mode>(src + i, dst + i, count - i);
+}
+#endif
+
+BlendKernel SelectKernel(BlendMode mode)
+{
+	const BlendKernel kernel = GetAvx2BlendKernel(mode);
+	return kernel ? kernel : GetScalarBlendKernel(mode);
+}
+
+BlendKernel GetKernel(BlendMode mode)
+{
+	static const BlendKernel kernels[] = {
+		SelectKernel(BlendMode::Over),
+		SelectKernel(BlendMode::Multiply),
+		SelectKernel(BlendMode::Screen),
+	};
+	return kernels[static_cast<int>(mode)];
+}
+
+// Проходит по прямоугольнику area приёмника полосами высотой в тайл:
+// readSource(top, width, height, pixels) заполняет источник для полосы,
+// а каждый тайл полосы копируется при записи один раз и смешивается
+// построчно.
+template <typename ReadSource>
+void CompositeArea(Image& dst, Rect area, BlendMode mode, ReadSource&& readSource)
+{
+	const Size size = dst.GetSize();
+	const int left = std::max(area.topLeft.x, 0);
+	const int top = std::max(area.topLeft.y, 0);
+	const int right = std::min(area.topLeft.x + area.size.width, size.width);
+	const int bottom = std::min(area.topLeft.y + area.size.height, size.height);
+	if (left >= right || top >= bottom)
+	{
+		return;
+	}
+
+	const BlendKernel kernel = GetKernel(mode);
+	const int width = right - left;
+	std::vector<Color> band(static_cast<size_t>(width) * Tile::SIZE);
+	for (int bandTop = top; bandTop < bottom;)
+	{
+		const int tileY = bandTop / Tile::SIZE;
+		const int bandBottom = std::min(bottom, (tileY + 1) * Tile::SIZE);
+		readSource({ left, bandTop }, Size{ width, bandBottom - bandTop }, band);
+		for (int x = left; x < right;)
+		{
+			const int tileX = x / Tile::SIZE;
+			const int tileRight = std::min(right, (tileX + 1) * Tile::SIZE);
+			Tile& tile = dst.GetMutableTile(tileX, tileY);
+			for (int y = bandTop; y < bandBottom; ++y)
+			{
+				const Color* src = band.data() + static_cast<size_t>(y - bandTop) * width + (x - left);
+				kernel(src, tile.GetRow(y - tileY * Tile::SIZE).data() + (x - tileX * Tile::SIZE), tileRight - x);
+			}
+			x = tileRight;
+		}
+		bandTop = bandBottom;
+	}
+}
+
+} // namespace
+
+BlendKernel GetScalarBlendKernel(BlendMode mode)
+{
+	switch (mode)
+	{
+	case BlendMode::Multiply:
+		return &BlendScalar<BlendMode::Multiply>;
+	case BlendMode::Screen:
+		return &BlendScalar<BlendMode::Screen>;
+	default:
+		return &BlendScalar<BlendMode::Over>;
+	}
+}
+
+BlendKernel GetAvx2BlendKernel(BlendMode mode)
+{
+#ifdef COMPOSITOR_X86
+	if (__builtin_cpu_supports("avx2"))
+	{
+		switch (mode)
+		{
+		case BlendMode::Multiply:
+			return &BlendAvx2<BlendMode::Multiply>;
+		case BlendMode::Screen:
+			return &BlendAvx2<BlendMode::Screen>;
+		default:
+			return &BlendAvx2<BlendMode::Over>;
+		}
+	}
+#endif
+	(void)mode;
+	return nullptr;
+}
+
+void Composite(Image& dst, Point position, const Image& src, BlendMode mode)
+{
+	if (&src == &dst)
+	{
+		// Источник читается полосами по ходу записи, поэтому наложение
+		// изображения на само себя идёт из снимка.
+		Composite(dst, position, src.Snapshot(), mode);
+		return;
+	}
+	const Rect area{ position, src.GetSize() };
+	CompositeArea(dst, area, mode, [&](Point from, Size size, std::vector<Color>& pixels) {
+		src.ReadRect({ from.x - position.x, from.y - position.y }, size, pixels);
+	});
+}
+
+void Composite(Image& dst, Rect rect, Color color, BlendMode mode)
+{
+	if (mode == BlendMode::Over && color >> ALPHA_SHIFT == 0xFF)
+	{
+		// Непрозрачный цвет просто заменяет пиксели, и закрытые целиком тайлы
+		// остаются общими.
+		dst.FillRect(rect.topLeft, rect.size, color);
+		return;
+	}
+	bool isFilled = false;
+	CompositeArea(dst, rect, mode, [&](Point, Size, std::vector<Color>& pixels) {
+		if (!isFilled)
+		{
+			std::fill(pixels.begin(), pixels.end(), color);
+			isFilled = true;
+		}
+	});
+}
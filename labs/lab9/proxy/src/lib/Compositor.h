@@ -0,0 +1,41 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#ifndef OOD_COMPOSITOR_H
+#define OOD_COMPOSITOR_H
+#include "Image.h"
+
+#include <cstddef>
+
+/**
+ * Наложение слоёв на изображение.
+ *
+ * Цвет при наложении читается как 0xAARRGGBB без предумножения альфы.
+ * Изображение-приёмник считается непрозрачной подложкой: режим смешивает
+ * цвета источника и приёмника, а результат кладётся поверх приёмника с
+ * альфой источника (Porter-Duff source-over). Альфа результата —
+ * sa + da * (1 - sa).
+ */
+enum class BlendMode
+{
+	Over,
+	Multiply,
+	Screen,
+};
+
+// Накладывает src на dst так, что левый верхний угол src попадает в
+// точку position. Всё, что выходит за пределы dst, отсекается.
+void Composite(Image& dst, Point position, const Image& src, BlendMode mode);
+
+// Накладывает сплошной цвет на прямоугольник rect.
+void Composite(Image& dst, Rect rect, Color color, BlendMode mode);
+
+// Ядро смешивания одной строки: src и dst длиной count, результат в dst.
+using BlendKernel = void (*)(const Color* src, Color* dst, size_t count);
+
+BlendKernel GetScalarBlendKernel(BlendMode mode);
+// nullptr, если процессор не поддерживает AVX2.
+BlendKernel GetAvx2BlendKernel(BlendMode mode);
+
+#endif // OOD_COMPOSITOR_H
@@ -0,0 +1,435 @@
+//
+// Created by smmm on 05.12.2025.
+//
+#include "DrawList.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+
+int Sign(int value)
+{
+	return (0 < value) - (value < 0);
+}
+
+// Часть тайла внутри изображения: [left, right) x [top, bottom) в координатах
+// изображения; left и top совпадают с началом тайла.
+struct Clip
+{
+	int left;
+	int top;
+	int right;
+	int bottom;
+};
+
+// Отрезок Брезенхэма из DrawLine в замкнутой форме: координата по короткой
+// оси вычисляется для любой точки длинной оси без прохода от начала отрезка,
+// поэтому каждый тайл растеризует только свой кусок.
+struct LineRaster
+{
+	bool isSteep;
+	int majorFrom;
+	int majorTo;
+	int minorFrom;
+	int step;
+	int64_t deltaErr;
+	int64_t threshold;
+
+	int MinorAt(int major) const noexcept
+	{
+		const int64_t error = deltaErr / 2 + (major - majorFrom) * deltaErr;
+		return minorFrom + step * static_cast<int>(error / threshold);
+	}
+
+	Point ToPoint(int major, int minor) const noexcept
+	{
+		return isSteep ? Point{ minor, major } : Point{ major, minor };
+	}
+};
+
+LineRaster MakeLineRaster(Point from, Point to)
+{
+	const int deltaX = std::abs(to.x - from.x);
+	const int deltaY = std::abs(to.y - from.y);
+	if (deltaY > deltaX)
+	{
+		if (from.y > to.y)
+		{
+			std::swap(from, to);
+		}
+		return { true, from.y, to.y, from.x, Sign(to.x - from.x), deltaX + 1, deltaY + 1 };
+	}
+	if (from.x > to.x)
+	{
+		std::swap(from, to);
+	}
+	return { false, from.x, to.x, from.y, Sign(to.y - from.y), deltaY + 1, deltaX + 1 };
+}
+
+// Строка окружности на расстоянии dy от центра: точки Брезенхэма (x, y)
+// дают в строке y столбцы ±[runFrom, runTo], а в строке x — столбцы ±point.
+struct CircleRow
+{
+	int runFrom = -1;
+	int runTo = -1;
+	int point = -1;
+
+	int GetHalfWidth() const noexcept
+	{
+		return std::max(runTo, point);
+	}
+};
+
+std::vector<CircleRow> GetCircleRows(int radius)
+{
+	std::vector<CircleRow> rows(static_cast<size_t>(radius) + 1);
+	int x = 0;
+	int y = radius;
+	int d = 3 - 2 * radius;
+	while (y >= x)
+	{
+		CircleRow& run = rows[static_cast<size_t>(y)];
+		if (run.runFrom < 0)
+		{
+			run.runFrom = x;
+		}
+		run.runTo = x;
+		rows[static_cast<size_t>(x)].point = y;
+		if (d <= 0)
+		{
+			d += 4 * x + 6;
+		}
+		else
+		{
+			d += 4 * (x - y) + 10;
+			--y;
+		}
+		++x;
+	}
+	return rows;
+}
+
+Clip GetTileClip(int tileX, int tileY, Size size) noexcept
+{
+	const int left = tileX * Tile::SIZE;
+	const int top = tileY * Tile::SIZE;
+	return { left, top, std::min(left + Tile::SIZE, size.width), std::min(top + Tile::SIZE, size.height) };
+}
+
+// Закрывает ли круг всю видимую часть тайла.
+bool IsClipCovered(const Clip& clip, Point center, const std::vector<CircleRow>& rows) noexcept
+{
+	const int radius = static_cast<int>(rows.size()) - 1;
+	for (int y = clip.top; y < clip.bottom; ++y)
+	{
+		const int dy = std::abs(y - center.y);
+		if (dy > radius)
+		{
+			return false;
+		}
+		const int halfWidth = rows[static_cast<size_t>(dy)].GetHalfWidth();
+		if (center.x - halfWidth > clip.left || center.x + halfWidth < clip.right - 1)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FillClippedRow(Tile& tile, const Clip& clip, int y, int fromX, int toX, Color color)
+{
+	fromX = std::max(fromX, clip.left);
+	toX = std::min(toX, clip.right);
+	if (fromX < toX)
+	{
+		tile.FillRow(y - clip.top, fromX - clip.left, toX - clip.left, color);
+	}
+}
+
+void RasterizeLine(Tile& tile, const Clip& clip, const LineRaster& line, Color color)
+{
+	const int majorLo = line.isSteep ? clip.top : clip.left;
+	const int majorHi = line.isSteep ? clip.bottom : clip.right;
+	const int minorLo = line.isSteep ? clip.left : clip.top;
+	const int minorHi = line.isSteep ? clip.right : clip.bottom;
+	for (int major = std::max(line.majorFrom, majorLo); major <= std::min(line.majorTo, majorHi - 1); ++major)
+	{
+		const int minor = line.MinorAt(major);
+		if (minor >= minorLo && minor < minorHi)
+		{
+			const Point p = line.ToPoint(major, minor);
+			tile.SetPixel({ p.x - clip.left, p.y - clip.top }, color);
+		}
+	}
+}
+
+void RasterizeCircle(Tile& tile, const Clip& clip, Point center, const std::vector<CircleRow>& rows, bool isFilled, Color color)
+{
+	const int radius = static_cast<int>(rows.size()) - 1;
+	for (int y = std::max(clip.top, center.y - radius); y < std::min(clip.bottom, center.y + radius + 1); ++y)
+	{
+		const CircleRow& row = rows[static_cast<size_t>(std::abs(y - center.y))];
+		if (isFilled)
+		{
+			const int halfWidth = row.GetHalfWidth();
+			FillClippedRow(tile, clip, y, center.x - halfWidth, center.x + halfWidth + 1, color);
+			continue;
+		}
+		if (row.runFrom >= 0)
+		{
+			FillClippedRow(tile, clip, y, center.x + row.runFrom, center.x + row.runTo + 1, color);
+			FillClippedRow(tile, clip, y, center.x - row.runTo, center.x - row.runFrom + 1, color);
+		}
+		if (row.point >= 0)
+		{
+			FillClippedRow(tile, clip, y, center.x + row.point, center.x + row.point + 1, color);
+			FillClippedRow(tile, clip, y, center.x - row.point, center.x - row.point + 1, color);
+		}
+	}
+}
+
+// Корзины примитивов для прямоугольника тайлов, который задевают примитивы,
+// а не для всей сетки: небольшой список на большом или постраничном
+// изображении не требует работы и памяти по размеру сетки.
+class TileBins
+{
+public:
+	// Прямоугольник [left, right] x [top, bottom] в координатах тайлов.
+	TileBins(int left, int top, int right, int bottom)
+		: m_left(left)
+		, m_top(top)
+		, m_width(right - left + 1)
+		, m_height(bottom - top + 1)
+		, m_bins(static_cast<size_t>(m_width) * m_height)
+	{
+	}
+
+	int GetLeft() const noexcept
+	{
+		return m_left;
+	}
+
+	int GetTop() const noexcept
+	{
+		return m_top;
+	}
+
+	int GetRight() const noexcept
+	{
+		return m_left + m_width - 1;
+	}
+
+	int GetBottom() const noexcept
+	{
+		return m_top + m_height - 1;
+	}
+
+	std::vector<uint32_t>& At(int tileX, int tileY) noexcept
+	{
+		assert(tileX >= m_left && tileX <= GetRight() && tileY >= m_top && tileY <= GetBottom());
+		return m_bins[static_cast<size_t>(tileY - m_top) * m_width + (tileX - m_left)];
+	}
+
+private:
+	int m_left;
+	int m_top;
+	int m_width;
+	int m_height;
+	std::vector<std::vector<uint32_t>> m_bins;
+};
+
+} // namespace
+
+void DrawList::AddLine(Point from, Point to, Color color)
+{
+	m_primitives.push_back({ PrimitiveType::Line, from, to, 0, color });
+}
+
+void DrawList::AddCircle(Point center, int radius, Color color)
+{
+	if (radius >= 0)
+	{
+		m_primitives.push_back({ PrimitiveType::Circle, center, center, radius, color });
+	}
+}
+
+void DrawList::AddFilledCircle(Point center, int radius, Color color)
+{
+	if (radius >= 0)
+	{
+		m_primitives.push_back({ PrimitiveType::FilledCircle, center, center, radius, color });
+	}
+}
+
+size_t DrawList::GetSize() const noexcept
+{
+	return m_primitives.size();
+}
+
+void DrawList::Clear() noexcept
+{
+	m_primitives.clear();
+}
+
+void DrawList::Render(Image& image, unsigned threadCount) const
+{
+	// Корзины заводятся только для тайлов описанного прямоугольника всех
+	// примитивов, обрезанного по изображению.
+	const Size size = image.GetSize();
+	int left = size.width;
+	int top = size.height;
+	int right = -1;
+	int bottom = -1;
+	for (const Primitive& primitive : m_primitives)
+	{
+		const int reach = primitive.type == PrimitiveType::Line ? 0 : primitive.radius;
+		left = std::min({ left, primitive.from.x - reach, primitive.to.x - reach });
+		top = std::min({ top, primitive.from.y - reach, primitive.to.y - reach });
+		right = std::max({ right, primitive.from.x + reach, primitive.to.x + reach });
+		bottom = std::max({ bottom, primitive.from.y + reach, primitive.to.y + reach });
+	}
+	left = std::max(left, 0);
+	top = std::max(top, 0);
+	right = std::min(right, size.width - 1);
+	bottom = std::min(bottom, size.height - 1);
+	if (left > right || top > bottom)
+	{
+		return;
+	}
+	TileBins bins(left / Tile::SIZE, top / Tile::SIZE, right / Tile::SIZE, bottom / Tile::SIZE);
+	auto addToTiles = [&](uint32_t index, int tileLeft, int tileTop, int tileRight, int tileBottom) {
+		for (int tileY = tileTop; tileY <= tileBottom; ++tileY)
+		{
+			for (int tileX = tileLeft; tileX <= tileRight; ++tileX)
+			{
+				bins.At(tileX, tileY).push_back(index);
+			}
+		}
+	};
+
+	// Раскладка по тайлам. Отрезок разбивается на куски по тайлам вдоль
+	// длинной оси; окружность попадает во все тайлы описанного квадрата.
+	std::vector<LineRaster> lines(m_primitives.size());
+	std::vector<std::vector<CircleRow>> circles(m_primitives.size());
+	for (uint32_t index = 0; index < m_primitives.size(); ++index)
+	{
+		const Primitive& primitive = m_primitives[index];
+		if (primitive.type == PrimitiveType::Line)
+		{
+			const LineRaster& line = lines[index] = MakeLineRaster(primitive.from, primitive.to);
+			const int majorExtent = line.isSteep ? size.height : size.width;
+			const int minorExtent = line.isSteep ? size.width : size.height;
+			const int majorEnd = std::min(line.majorTo, majorExtent - 1);
+			for (int major = std::max(line.majorFrom, 0); major <= majorEnd;)
+			{
+				const int chunkEnd = std::min(majorEnd, major / Tile::SIZE * Tile::SIZE + Tile::SIZE - 1);
+				const int minorLo = std::max(std::min(line.MinorAt(major), line.MinorAt(chunkEnd)), 0);
+				const int minorHi = std::min(std::max(line.MinorAt(major), line.MinorAt(chunkEnd)), minorExtent - 1);
+				if (minorLo <= minorHi)
+				{
+					const int majorTile = major / Tile::SIZE;
+					if (line.isSteep)
+					{
+						addToTiles(index, minorLo / Tile::SIZE, majorTile, minorHi / Tile::SIZE, majorTile);
+					}
+					else
+					{
+						addToTiles(index, majorTile, minorLo / Tile::SIZE, majorTile, minorHi / Tile::SIZE);
+					}
+				}
+				major = chunkEnd + 1;
+			}
+			continue;
+		}
+
+		circles[index] = GetCircleRows(primitive.radius);
+		const Point center = primitive.from;
+		const int left = std::max(center.x - primitive.radius, 0);
+		const int top = std::max(center.y - primitive.radius, 0);
+		const int right = std::min(center.x + primitive.radius, size.width - 1);
+		const int bottom = std::min(center.y + primitive.radius, size.height - 1);
+		if (left > right || top > bottom)
+		{
+			continue;
+		}
+		for (int tileY = top / Tile::SIZE; tileY <= bottom / Tile::SIZE; ++tileY)
+		{
+			for (int tileX = left / Tile::SIZE; tileX <= right / Tile::SIZE; ++tileX)
+			{
+				// Закрашенный целиком тайл перекрывает всё, что было нарисовано
+				// в нём раньше, и эти примитивы можно не растеризовать.
+				auto& bin = bins.At(tileX, tileY);
+				if (primitive.type == PrimitiveType::FilledCircle
+					&& IsClipCovered(GetTileClip(tileX, tileY, size), center, circles[index]))
+				{
+					bin.clear();
+				}
+				bin.push_back(index);
+			}
+		}
+	}
+
+	// Копирование при записи выполняется здесь, до раздачи тайлов: дальше у
+	// каждого тайла свой экземпляр, и потоки не касаются общих CoW<Tile>.
+	// Постраничное изображение держит в памяти ограниченное число тайлов,
+	// поэтому тайлы обрабатываются пакетами не больше этого числа.
+	struct TileTask
+	{
+		int tileX;
+		int tileY;
+		Tile* tile;
+		const std::vector<uint32_t>* primitives;
+	};
+	std::vector<TileTask> tasks;
+	for (int tileY = bins.GetTop(); tileY <= bins.GetBottom(); ++tileY)
+	{
+		for (int tileX = bins.GetLeft(); tileX <= bins.GetRight(); ++tileX)
+		{
+			const auto& bin = bins.At(tileX, tileY);
+			if (!bin.empty())
+			{
+				tasks.push_back({ tileX, tileY, nullptr, &bin });
+			}
+		}
+	}
+
+	auto draw = [&](size_t taskIndex) {
+		const TileTask& task = tasks[taskIndex];
+		const Clip clip = GetTileClip(task.tileX, task.tileY, size);
+		for (uint32_t index : *task.primitives)
+		{
+			const Primitive& primitive = m_primitives[index];
+			if (primitive.type == PrimitiveType::Line)
+			{
+				RasterizeLine(*task.tile, clip, lines[index], primitive.color);
+			}
+			else
+			{
+				RasterizeCircle(*task.tile, clip, primitive.from, circles[index],
+					primitive.type == PrimitiveType::FilledCircle, primitive.color);
+			}
+		}
+	};
+
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	// Потоки общего пула переживают и пакеты, и вызовы Render.
+	WorkerPool& pool = WorkerPool::GetShared();
+	const size_t batchSize = image.GetResidentTileLimit();
+	for (size_t batchStart = 0; batchStart < tasks.size(); batchStart += batchSize)
+	{
+		const size_t batchEnd = batchStart + std::min(batchSize, tasks.size() - batchStart);
+		for (size_t i = batchStart; i < batchEnd; ++i)
+		{
+			tasks[i].tile = &image.GetMutableTile(tasks[i].tileX, tasks[i].tileY);
+		}
+		pool.Run(batchEnd - batchStart, [&](size_t i) { draw(batchStart + i); }, threadCount);
+	}
+}
@@ -0,0 +1,52 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#ifndef OOD_DRAWLIST_H
+#define OOD_DRAWLIST_H
+#include "Image.h"
+
+#include <vector>
+
+/**
+ * Список примитивов для отрисовки одним пакетом.
+ *
+ * Render раскладывает примитивы по тайлам, которые они задевают, и
+ * растеризует тайлы параллельно: каждый тайл целиком обрабатывает один
+ * поток, применяя свои примитивы в порядке добавления. Результат побитово
+ * совпадает с последовательными вызовами DrawLine, DrawCircle и FillCircle.
+ */
+class DrawList
+{
+public:
+	void AddLine(Point from, Point to, Color color);
+	void AddCircle(Point center, int radius, Color color);
+	void AddFilledCircle(Point center, int radius, Color color);
+
+	size_t GetSize() const noexcept;
+	void Clear() noexcept;
+
+	// threadCount == 0 — по числу аппаратных потоков.
+	void Render(Image& image, unsigned threadCount = 0) const;
+
+private:
+	enum class PrimitiveType
+	{
+		Line,
+		Circle,
+		FilledCircle,
+	};
+
+	struct Primitive
+	{
+		PrimitiveType type;
+		Point from;
+		Point to;
+		int radius;
+		Color color;
+	};
+
+	std::vector<Primitive> m_primitives;
+};
+
+#endif // OOD_DRAWLIST_H
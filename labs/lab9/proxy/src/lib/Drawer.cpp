@@ -2,8 +2,10 @@
 // Created by smmm on 05.12.2025.
 //
 #include "Drawer.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <vector>
 
 namespace
 {
@@ -13,6 +15,12 @@ int Sign(int value)
 	return (0 < value) - (value < 0);
 }
 
+// Начало тайла, в который попадает координата, в том числе отрицательная.
+int FloorToTile(int value)
+{
+	return value >= 0 ? value / Tile::SIZE * Tile::SIZE : -((Tile::SIZE - 1 - value) / Tile::SIZE * Tile::SIZE);
+}
+
 void DrawSteepLine(Image& image, Point from, Point to, Color color)
 {
 	const int deltaX = std::abs(to.x - from.x);
@@ -110,33 +118,19 @@ void DrawCirclePoints(Image& image, Point c, int x, int y, Color color)
 	image.SetPixel({ c.x - y, c.y - x }, color);
 }
 
-void FillCirclePoints(Image& image, Point c, int x, int y, Color color)
+// Полуширина каждой строки круга относительно центра: индекс — смещение
+// строки dy. Набор пикселей тот же, что у заливки по точкам Брезенхэма,
+// но каждая строка закрашивается один раз.
+std::vector<int> GetCircleHalfWidths(int radius)
 {
-	for (int xx = c.x - x; xx <= c.x + x; ++xx)
-	{
-		image.SetPixel({ xx, c.y + y }, color);
-		image.SetPixel({ xx, c.y - y }, color);
-	}
-	for (int xx = c.x - y; xx <= c.x + y; ++xx)
-	{
-		image.SetPixel({ xx, c.y + x }, color);
-		image.SetPixel({ xx, c.y - x }, color);
-	}
-}
-} // namespace
-
-void FillCircle(Image& image, Point center, int radius, Color color)
-{
-	if (radius < 0)
-	{
-		return;
-	}
+	std::vector<int> halfWidths(static_cast<size_t>(radius) + 1, -1);
 	int x = 0;
 	int y = radius;
 	int d = 3 - 2 * radius;
 	while (y >= x)
 	{
-		FillCirclePoints(image, center, x, y, color);
+		halfWidths[static_cast<size_t>(y)] = std::max(halfWidths[static_cast<size_t>(y)], x);
+		halfWidths[static_cast<size_t>(x)] = std::max(halfWidths[static_cast<size_t>(x)], y);
 		if (d <= 0)
 		{
 			d += 4 * x + 6;
@@ -148,6 +142,57 @@ void FillCircle(Image& image, Point center, int radius, Color color)
 		}
 		++x;
 	}
+	return halfWidths;
+}
+
+// Заливает строки полосами по высоте тайла: общая для всей полосы часть
+// идёт одним FillRect (целиком закрытые тайлы при этом разделяются), а края
+// дорисовываются построчно.
+void FillCircleRows(Image& image, Point center, const std::vector<int>& halfWidths, Color color)
+{
+	const int radius = static_cast<int>(halfWidths.size()) - 1;
+	auto halfWidthAt = [&](int y) {
+		return halfWidths[static_cast<size_t>(std::abs(y - center.y))];
+	};
+
+	const int top = center.y - radius;
+	const int bottom = center.y + radius;
+	for (int bandTop = top; bandTop <= bottom;)
+	{
+		const int bandEnd = std::min(bottom + 1, FloorToTile(bandTop) + Tile::SIZE);
+		int commonHalfWidth = halfWidthAt(bandTop);
+		for (int y = bandTop; y < bandEnd; ++y)
+		{
+			commonHalfWidth = std::min(commonHalfWidth, halfWidthAt(y));
+		}
+
+		if (commonHalfWidth >= 0)
+		{
+			image.FillRect({ center.x - commonHalfWidth, bandTop },
+				{ 2 * commonHalfWidth + 1, bandEnd - bandTop }, color);
+		}
+		for (int y = bandTop; y < bandEnd; ++y)
+		{
+			const int halfWidth = halfWidthAt(y);
+			const int edge = halfWidth - std::max(commonHalfWidth, -1);
+			if (edge > 0)
+			{
+				image.FillSpan({ center.x - halfWidth, y }, edge, color);
+				image.FillSpan({ center.x + halfWidth - edge + 1, y }, edge, color);
+			}
+		}
+		bandTop = bandEnd;
+	}
+}
+} // namespace
+
+void FillCircle(Image& image, Point center, int radius, Color color)
+{
+	if (radius < 0)
+	{
+		return;
+	}
+	FillCircleRows(image, center, GetCircleHalfWidths(radius), color);
 }
 void DrawCircle(Image& image, Point center, int radius, Color color)
 {
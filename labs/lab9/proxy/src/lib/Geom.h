@@ -20,6 +20,12 @@ struct Size
 	int height = 0;
 };
 
+struct Rect
+{
+	Point topLeft;
+	Size size;
+};
+
 // Точка передаётся в локальных координатах.
 inline bool IsPointInSize(Point p, Size size) noexcept
 {
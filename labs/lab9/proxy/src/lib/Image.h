@@ -8,8 +8,18 @@
 #include "Geom.h"
 
 #include "Tile.h"
+#include "TilePager.h"
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class Image
 {
@@ -17,23 +27,69 @@ public:
 	explicit Image(Size size, Color color = 0)
 		: m_size(size)
 	{
-		if (size.width <= 0 || size.height <= 0)
+		InitTileGrid();
+		CoW<Tile> commonTile(color);
+		m_tiles.assign(static_cast<size_t>(m_tilesX) * m_tilesY, commonTile);
+	}
+
+	// Постраничное изображение: тайлы хранятся в файле подкачки, а в памяти
+	// держится не больше paging.residentTiles из них (см. TilePager). Для
+	// очень больших изображений стоит собирать с OOD_TILE_SIZE 32 или 64,
+	// чтобы таблица состояний тайлов оставалась небольшой. Ссылки из
+	// GetTile и GetMutableTile действительны, пока не прочитаны
+	// residentTiles - 1 других тайлов. Уровни пирамиды (GetMipTile)
+	// хранятся в памяти. Копировать такое изображение нельзя.
+	Image(Size size, Color color, const PagingOptions& paging)
+		: m_size(size)
+	{
+		InitTileGrid();
+		m_pager = std::make_unique<TilePager>(static_cast<size_t>(m_tilesX) * m_tilesY, color, paging);
+	}
+
+	Image(const Image& other)
+		: m_size(other.m_size)
+		, m_tilesX(other.m_tilesX)
+		, m_tilesY(other.m_tilesY)
+		, m_tiles(other.m_tiles)
+		, m_compactionThreshold(other.m_compactionThreshold)
+		, m_detachedTiles(other.m_detachedTiles)
+		, m_interned(other.m_interned)
+		, m_changedTiles(other.m_changedTiles)
+		, m_isTileChanged(other.m_isTileChanged)
+		, m_mipLevels(other.m_mipLevels)
+	{
+		if (other.m_pager)
 		{
-			throw std::out_of_range("Image size must be positive");
+			throw std::logic_error("Paged image cannot be copied");
 		}
-		m_tilesX = (size.width + Tile::SIZE - 1) / Tile::SIZE;
-		m_tilesY = (size.height + Tile::SIZE - 1) / Tile::SIZE;
-		const int tileCount = m_tilesX * m_tilesY;
-		CoW<Tile> commonTile(color);
-		m_tiles.assign(static_cast<size_t>(tileCount), commonTile);
 	}
 
+	Image& operator=(const Image& other)
+	{
+		if (this != &other)
+		{
+			*this = Image(other);
+		}
+		return *this;
+	}
+
+	Image(Image&&) noexcept = default;
+	Image& operator=(Image&&) noexcept = default;
+
 	Size GetSize() const noexcept
 	{
 		return m_size;
 	}
 
-	Color GetPixel(Point p) const noexcept
+	// Снимок для отмены или сравнения через Diff. Копируются только ссылки на
+	// тайлы, поэтому снимок стоит O(числа тайлов), а пиксели копируются
+	// позже и лишь для тех тайлов, которые изменятся.
+	Image Snapshot() const
+	{
+		return *this;
+	}
+
+	Color GetPixel(Point p) const
 	{
 		if (!IsPointInSize(p, m_size))
 		{
@@ -41,9 +97,8 @@ public:
 		}
 		int tileX = p.x / Tile::SIZE;
 		int tileY = p.y / Tile::SIZE;
-		int index = tileY * m_tilesX + tileX;
 		Point local{ p.x % Tile::SIZE, p.y % Tile::SIZE };
-		return m_tiles[static_cast<size_t>(index)]->GetPixel(local);
+		return GetTile(tileX, tileY).GetPixel(local);
 	}
 
 	void SetPixel(Point p, Color color)
@@ -54,9 +109,278 @@ public:
 		}
 		int tileX = p.x / Tile::SIZE;
 		int tileY = p.y / Tile::SIZE;
-		int index = tileY * m_tilesX + tileX;
 		Point local{ p.x % Tile::SIZE, p.y % Tile::SIZE };
-		m_tiles[static_cast<size_t>(index)]--->SetPixel(local, color);
+		GetMutableTile(tileX, tileY).SetPixel(local, color);
+		CompactIfNeeded();
+	}
+
+	// Массовые операции обходят изображение по тайлам: деление, проверка
+	// границ и копирование при записи выполняются один раз на тайл, а не на
+	// каждый пиксель. Всё, что выходит за пределы изображения, отсекается.
+
+	// Заливает length пикселей строки from.y, начиная с from.x.
+	void FillSpan(Point from, int length, Color color)
+	{
+		FillRect(from, { length, 1 }, color);
+	}
+
+	void FillRect(Point topLeft, Size size, Color color)
+	{
+		const int left = std::max(topLeft.x, 0);
+		const int top = std::max(topLeft.y, 0);
+		const int right = std::min(topLeft.x + std::max(size.width, 0), m_size.width);
+		const int bottom = std::min(topLeft.y + std::max(size.height, 0), m_size.height);
+		if (left >= right || top >= bottom)
+		{
+			return;
+		}
+
+		// Полностью закрытые тайлы не копируются, а делят один новый тайл.
+		CoW<Tile> filledTile(color);
+		for (int tileY = top / Tile::SIZE; tileY <= (bottom - 1) / Tile::SIZE; ++tileY)
+		{
+			const int tileTop = tileY * Tile::SIZE;
+			const int fromY = std::max(top - tileTop, 0);
+			const int toY = std::min(bottom - tileTop, Tile::SIZE);
+			for (int tileX = left / Tile::SIZE; tileX <= (right - 1) / Tile::SIZE; ++tileX)
+			{
+				const int tileLeft = tileX * Tile::SIZE;
+				const int fromX = std::max(left - tileLeft, 0);
+				const int toX = std::min(right - tileLeft, Tile::SIZE);
+				if (fromX == 0 && fromY == 0 && toX == Tile::SIZE && toY == Tile::SIZE)
+				{
+					if (m_pager)
+					{
+						m_pager->Fill(GetTileIndex(tileX, tileY), color);
+					}
+					else
+					{
+						GetTileAt(tileX, tileY) = filledTile;
+						MarkTileChanged(tileX, tileY);
+					}
+					InvalidateMipTiles(tileX, tileY);
+					continue;
+				}
+				Tile& tile = GetMutableTile(tileX, tileY);
+				for (int y = fromY; y < toY; ++y)
+				{
+					tile.FillRow(y, fromX, toX, color);
+				}
+			}
+		}
+		CompactIfNeeded();
+	}
+
+	// Читает pixels.size() пикселей строки from.y, начиная с from.x. Пиксели
+	// вне изображения читаются как 0, как и в GetPixel.
+	void ReadSpan(Point from, std::span<Color> pixels) const
+	{
+		std::fill(pixels.begin(), pixels.end(), 0);
+		ForEachTileInSpan(from, static_cast<int>(pixels.size()), [&](int tileX, int tileY, int localY, int fromX, int toX, int offset) {
+			auto row = GetTile(tileX, tileY).GetRow(localY);
+			std::copy(row.begin() + fromX, row.begin() + toX, pixels.begin() + offset);
+		});
+	}
+
+	void WriteSpan(Point from, std::span<const Color> pixels)
+	{
+		ForEachTileInSpan(from, static_cast<int>(pixels.size()), [&](int tileX, int tileY, int localY, int fromX, int toX, int offset) {
+			auto row = GetMutableTile(tileX, tileY).GetRow(localY);
+			std::copy(pixels.begin() + offset, pixels.begin() + offset + (toX - fromX), row.begin() + fromX);
+		});
+		CompactIfNeeded();
+	}
+
+	// Читает прямоугольник построчно в pixels, где должно быть не меньше
+	// size.width * size.height элементов.
+	void ReadRect(Point topLeft, Size size, std::span<Color> pixels) const
+	{
+		for (int y = 0; y < size.height; ++y)
+		{
+			ReadSpan({ topLeft.x, topLeft.y + y }, pixels.subspan(static_cast<size_t>(y) * size.width, size.width));
+		}
+	}
+
+	void ReadRow(int y, std::span<Color> pixels) const
+	{
+		ReadSpan({ 0, y }, pixels.first(std::min(pixels.size(), static_cast<size_t>(m_size.width))));
+	}
+
+	void WriteRow(int y, std::span<const Color> pixels)
+	{
+		WriteSpan({ 0, y }, pixels.first(std::min(pixels.size(), static_cast<size_t>(m_size.width))));
+	}
+
+	// Сетка тайлов: сколько их по горизонтали и по вертикали.
+	Size GetTileGridSize() const noexcept
+	{
+		return { m_tilesX, m_tilesY };
+	}
+
+	const Tile& GetTile(int tileX, int tileY) const
+	{
+		return *GetTileRef(tileX, tileY);
+	}
+
+	// Изменяемый вид тайла для примитивов рисования. Копирование при записи
+	// происходит здесь, один раз; ссылка действительна, пока тайл не заменён
+	// другим (например, через FillRect).
+	Tile& GetMutableTile(int tileX, int tileY)
+	{
+		if (m_pager)
+		{
+			InvalidateMipTiles(tileX, tileY);
+			return m_pager->GetMutableTile(GetTileIndex(tileX, tileY));
+		}
+		CoW<Tile>& tile = GetTileAt(tileX, tileY);
+		CountDetach(tile);
+		MarkTileChanged(tileX, tileY);
+		InvalidateMipTiles(tileX, tileY);
+		return *tile.Write();
+	}
+
+	// Снова делает общими тайлы с одинаковым содержимым: тайлы хешируются,
+	// и совпавшие заменяются ссылкой на один экземпляр. Возвращает число
+	// тайлов, которые стали ссылаться на другой экземпляр. Ссылки, полученные
+	// через GetMutableTile, после этого недействительны.
+	// В постраничном режиме однотонные тайлы и так хранятся одним цветом, а
+	// остальные не сравниваются: Compact только записывает изменённые тайлы.
+	size_t Compact()
+	{
+		m_detachedTiles = 0;
+		ClearInterned();
+		if (m_pager)
+		{
+			m_pager->Flush();
+			return 0;
+		}
+		// Экземпляр, уже встреченный под другим индексом, не хешируется снова.
+		std::unordered_map<const Tile*, const CoW<Tile>*> representatives;
+		size_t relinked = 0;
+		for (size_t index = 0; index < m_tiles.size(); ++index)
+		{
+			auto known = representatives.find(&*m_tiles[index]);
+			if (known == representatives.end())
+			{
+				known = representatives.emplace(&*m_tiles[index], &Intern(index)).first;
+			}
+			if (&**known->second != &*m_tiles[index])
+			{
+				m_tiles[index] = *known->second;
+				++relinked;
+			}
+		}
+		if (m_compactionThreshold != 0)
+		{
+			m_isTileChanged.assign(m_tiles.size(), false);
+		}
+		else
+		{
+			ClearInterned();
+		}
+		return relinked;
+	}
+
+	// Автоматическое сжатие после того, как массовая операция или SetPixel
+	// отделили от общих не меньше detachedTiles тайлов. Первый проход — это
+	// полный Compact, который запоминает по хешу по одному экземпляру каждого
+	// содержимого. Следующие проходы сравнивают с ними только тайлы,
+	// изменённые с прошлого прохода, поэтому их цена пропорциональна записи,
+	// а не размеру изображения. Запомненные экземпляры общие, поэтому первая
+	// запись в такой тайл копирует его. 0 отключает автоматическое сжатие.
+	void SetAutoCompaction(size_t detachedTiles) noexcept
+	{
+		m_compactionThreshold = detachedTiles;
+		if (detachedTiles == 0)
+		{
+			ClearInterned();
+		}
+	}
+
+	// Число различных экземпляров тайлов, на которые ссылается изображение.
+	size_t GetUniqueTileCount() const
+	{
+		if (m_pager)
+		{
+			return m_pager->GetDistinctTileCount();
+		}
+		std::unordered_set<const Tile*> unique;
+		for (const auto& tile : m_tiles)
+		{
+			unique.insert(&*tile);
+		}
+		return unique.size();
+	}
+
+	bool IsPaged() const noexcept
+	{
+		return m_pager != nullptr;
+	}
+
+	// Сколько тайлов можно держать изменяемыми одновременно.
+	size_t GetResidentTileLimit() const noexcept
+	{
+		return m_pager ? m_pager->GetResidentLimit() : std::numeric_limits<size_t>::max();
+	}
+
+	// Пирамида уменьшенных копий: уровень 0 — само изображение, каждый
+	// следующий вдвое меньше по каждой стороне (усреднение блоков 2x2), до
+	// размера 1x1. Тайлы уровней строятся лениво при первом чтении из тайлов
+	// предыдущего уровня и запоминаются; запись в тайл изображения
+	// сбрасывает только тайлы над ним. Чтение уровней меняет этот кеш, поэтому
+	// одновременно читать уровни одного изображения из разных потоков нельзя.
+	int GetMipLevelCount() const noexcept
+	{
+		int count = 1;
+		for (Size size = m_size; size.width > 1 || size.height > 1; size = GetHalfSize(size))
+		{
+			++count;
+		}
+		return count;
+	}
+
+	Size GetMipSize(int level) const
+	{
+		CheckMipLevel(level);
+		Size size = m_size;
+		for (int i = 0; i < level; ++i)
+		{
+			size = GetHalfSize(size);
+		}
+		return size;
+	}
+
+	const Tile& GetMipTile(int level, int tileX, int tileY) const
+	{
+		CheckMipLevel(level);
+		return *GetMipTileRef(level, tileX, tileY);
+	}
+
+	Color GetMipPixel(int level, Point p) const
+	{
+		if (!IsPointInSize(p, GetMipSize(level)))
+		{
+			return 0;
+		}
+		return GetMipTile(level, p.x / Tile::SIZE, p.y / Tile::SIZE).GetPixel({ p.x % Tile::SIZE, p.y % Tile::SIZE });
+	}
+
+	// Строка y уровня level; строятся только тайлы, через которые она проходит.
+	void ReadMipRow(int level, int y, std::span<Color> pixels) const
+	{
+		const Size size = GetMipSize(level);
+		std::fill(pixels.begin(), pixels.end(), 0);
+		if (y < 0 || y >= size.height)
+		{
+			return;
+		}
+		const int width = std::min(static_cast<int>(pixels.size()), size.width);
+		for (int tileX = 0; tileX * Tile::SIZE < width; ++tileX)
+		{
+			const auto row = GetMipTile(level, tileX, y / Tile::SIZE).GetRow(y % Tile::SIZE);
+			const int count = std::min(Tile::SIZE, width - tileX * Tile::SIZE);
+			std::copy(row.begin(), row.begin() + count, pixels.begin() + tileX * Tile::SIZE);
+		}
 	}
 
 protected:
@@ -66,10 +390,400 @@ protected:
 	}
 
 private:
+	void InitTileGrid()
+	{
+		if (m_size.width <= 0 || m_size.height <= 0)
+		{
+			throw std::out_of_range("Image size must be positive");
+		}
+		m_tilesX = (m_size.width + Tile::SIZE - 1) / Tile::SIZE;
+		m_tilesY = (m_size.height + Tile::SIZE - 1) / Tile::SIZE;
+	}
+
+	size_t GetTileIndex(int tileX, int tileY) const noexcept
+	{
+		assert(tileX >= 0 && tileX < m_tilesX && tileY >= 0 && tileY < m_tilesY);
+		return static_cast<size_t>(tileY) * m_tilesX + tileX;
+	}
+
+	const CoW<Tile>& GetTileRef(int tileX, int tileY) const
+	{
+		if (m_pager)
+		{
+			return m_pager->GetTile(GetTileIndex(tileX, tileY));
+		}
+		return m_tiles[GetTileIndex(tileX, tileY)];
+	}
+
+	CoW<Tile>& GetTileAt(int tileX, int tileY)
+	{
+		return m_tiles[GetTileIndex(tileX, tileY)];
+	}
+
+	struct MipLevel
+	{
+		int tilesX;
+		std::vector<std::optional<CoW<Tile>>> tiles;
+	};
+
+	static Size GetHalfSize(Size size) noexcept
+	{
+		return { std::max((size.width + 1) / 2, 1), std::max((size.height + 1) / 2, 1) };
+	}
+
+	void CheckMipLevel(int level) const
+	{
+		if (level < 0 || level >= GetMipLevelCount())
+		{
+			throw std::out_of_range("Mip level is out of range");
+		}
+	}
+
+	// Сбрасывает построенные тайлы уровней над тайлом изображения. Над
+	// несобранным тайлом все тайлы тоже не собраны, поэтому подъём
+	// останавливается на первом пустом.
+	void InvalidateMipTiles(int tileX, int tileY) noexcept
+	{
+		for (auto& level : m_mipLevels)
+		{
+			tileX /= 2;
+			tileY /= 2;
+			auto& tile = level.tiles[static_cast<size_t>(tileY * level.tilesX + tileX)];
+			if (!tile)
+			{
+				break;
+			}
+			tile.reset();
+		}
+	}
+
+	const CoW<Tile>& GetMipTileRef(int level, int tileX, int tileY) const
+	{
+		if (level == 0)
+		{
+			return GetTileRef(tileX, tileY);
+		}
+		if (m_mipLevels.empty())
+		{
+			for (Size size = GetHalfSize(m_size); m_mipLevels.size() + 1 < static_cast<size_t>(GetMipLevelCount()); size = GetHalfSize(size))
+			{
+				const int tilesX = (size.width + Tile::SIZE - 1) / Tile::SIZE;
+				const int tilesY = (size.height + Tile::SIZE - 1) / Tile::SIZE;
+				m_mipLevels.push_back({ tilesX, std::vector<std::optional<CoW<Tile>>>(static_cast<size_t>(tilesX * tilesY)) });
+			}
+		}
+		MipLevel& mipLevel = m_mipLevels[static_cast<size_t>(level - 1)];
+		assert(tileX >= 0 && tileX < mipLevel.tilesX && tileY >= 0 && tileY * mipLevel.tilesX < static_cast<int>(mipLevel.tiles.size()));
+		auto& tile = mipLevel.tiles[static_cast<size_t>(tileY * mipLevel.tilesX + tileX)];
+		if (!tile)
+		{
+			tile = BuildMipTile(level, tileX, tileY);
+		}
+		return *tile;
+	}
+
+	// Тайл уровня level из четырёх тайлов предыдущего уровня: каждый из них
+	// даёт свою четверть. Если все они — один и тот же однотонный экземпляр,
+	// он же и становится тайлом уровня.
+	CoW<Tile> BuildMipTile(int level, int tileX, int tileY) const
+	{
+		const Size childSize = GetMipSize(level - 1);
+		const Size size = GetMipSize(level);
+		const int childTilesX = (childSize.width + Tile::SIZE - 1) / Tile::SIZE;
+		const int childTilesY = (childSize.height + Tile::SIZE - 1) / Tile::SIZE;
+
+		const CoW<Tile>* children[2][2] = {};
+		bool isSameUniform = true;
+		for (int cy = 0; cy < 2; ++cy)
+		{
+			for (int cx = 0; cx < 2; ++cx)
+			{
+				const int childX = 2 * tileX + cx;
+				const int childY = 2 * tileY + cy;
+				if (childX < childTilesX && childY < childTilesY)
+				{
+					children[cy][cx] = &GetMipTileRef(level - 1, childX, childY);
+					isSameUniform = isSameUniform && &**children[cy][cx] == &**children[0][0];
+				}
+			}
+		}
+		if (isSameUniform && (*children[0][0])->IsUniform())
+		{
+			return *children[0][0];
+		}
+
+		constexpr int HALF = Tile::SIZE / 2;
+		CoW<Tile> result(0);
+		Tile& tile = *result.Write();
+		for (int cy = 0; cy < 2; ++cy)
+		{
+			for (int cx = 0; cx < 2; ++cx)
+			{
+				if (!children[cy][cx])
+				{
+					continue;
+				}
+				const Tile& child = **children[cy][cx];
+				const int childLeft = (2 * tileX + cx) * Tile::SIZE;
+				const int childTop = (2 * tileY + cy) * Tile::SIZE;
+				for (int y = 0; y < HALF && tileY * Tile::SIZE + cy * HALF + y < size.height; ++y)
+				{
+					const int rowCount = std::min(2, childSize.height - childTop - 2 * y);
+					const int width = std::min(HALF, size.width - tileX * Tile::SIZE - cx * HALF);
+					auto dst = tile.GetRow(cy * HALF + y).subspan(cx * HALF);
+					int x = 0;
+					if (rowCount == 2)
+					{
+						// Полные блоки 2x2 внутри изображения — основной случай.
+						const auto top = child.GetRow(2 * y);
+						const auto bottom = child.GetRow(2 * y + 1);
+						for (; x < width && childLeft + 2 * x + 1 < childSize.width; ++x)
+						{
+							dst[x] = AverageFour(top[2 * x], top[2 * x + 1], bottom[2 * x], bottom[2 * x + 1]);
+						}
+					}
+					for (; x < width; ++x)
+					{
+						const int columnCount = std::min(2, childSize.width - childLeft - 2 * x);
+						dst[x] = AverageBlock(child, 2 * x, 2 * y, columnCount, rowCount);
+					}
+				}
+			}
+		}
+		return result;
+	}
+
+	static Color AverageFour(Color a, Color b, Color c, Color d) noexcept
+	{
+		constexpr Color EVEN_BYTES = 0x00FF00FF;
+		const Color evenSum = (a & EVEN_BYTES) + (b & EVEN_BYTES) + (c & EVEN_BYTES) + (d & EVEN_BYTES) + 0x00020002;
+		const Color oddSum = (a >> 8 & EVEN_BYTES) + (b >> 8 & EVEN_BYTES) + (c >> 8 & EVEN_BYTES) + (d >> 8 & EVEN_BYTES) + 0x00020002;
+		return (evenSum >> 2 & EVEN_BYTES) | (oddSum >> 2 & EVEN_BYTES) << 8;
+	}
+
+	// Среднее по каждому байту цвета для блока columns x rows (1 или 2 по
+	// каждой стороне) из левого верхнего угла (x, y) тайла, с округлением.
+	// Байты через один складываются парами в 16-битных полях одного числа.
+	static Color AverageBlock(const Tile& tile, int x, int y, int columns, int rows) noexcept
+	{
+		constexpr Color EVEN_BYTES = 0x00FF00FF;
+		Color evenSum = 0;
+		Color oddSum = 0;
+		for (int dy = 0; dy < rows; ++dy)
+		{
+			const auto row = tile.GetRow(y + dy);
+			for (int dx = 0; dx < columns; ++dx)
+			{
+				evenSum += row[x + dx] & EVEN_BYTES;
+				oddSum += row[x + dx] >> 8 & EVEN_BYTES;
+			}
+		}
+		const int shift = (columns - 1) + (rows - 1);
+		const Color half = (1u << shift >> 1) * 0x00010001;
+		return ((evenSum + half) >> shift & EVEN_BYTES) | ((oddSum + half) >> shift & EVEN_BYTES) << 8;
+	}
+
+	void CountDetach(const CoW<Tile>& tile) noexcept
+	{
+		if (tile.GetLinksCount() != 1)
+		{
+			++m_detachedTiles;
+		}
+	}
+
+	void CompactIfNeeded()
+	{
+		if (m_compactionThreshold == 0 || m_detachedTiles < m_compactionThreshold)
+		{
+			return;
+		}
+		if (m_isTileChanged.empty())
+		{
+			Compact();
+			return;
+		}
+		CompactChanged();
+	}
+
+	// Запомненные экземпляры не меняются (запись в них копирует тайл),
+	// поэтому изменённые тайлы просто сравниваются с ними по одному.
+	size_t CompactChanged()
+	{
+		m_detachedTiles = 0;
+		size_t relinked = 0;
+		for (size_t index : m_changedTiles)
+		{
+			m_isTileChanged[index] = false;
+			const CoW<Tile>& representative = Intern(index);
+			if (&*representative != &*m_tiles[index])
+			{
+				m_tiles[index] = representative;
+				++relinked;
+			}
+		}
+		m_changedTiles.clear();
+		return relinked;
+	}
+
+	// Запомненный экземпляр с тем же содержимым, что у тайла index. Если
+	// такого нет, запоминает сам тайл.
+	const CoW<Tile>& Intern(size_t index)
+	{
+		const Tile& tile = *m_tiles[index];
+		const size_t hash = tile.GetHash();
+		for (auto [it, end] = m_interned.equal_range(hash); it != end; ++it)
+		{
+			if (&*it->second == &tile || *it->second == tile)
+			{
+				return it->second;
+			}
+		}
+		// Экземпляры, на которые ссылается только таблица, больше не нужны.
+		if (m_interned.size() >= 2 * m_tiles.size())
+		{
+			std::erase_if(m_interned, [](const auto& entry) { return entry.second.GetLinksCount() == 1; });
+		}
+		return m_interned.emplace(hash, m_tiles[index])->second;
+	}
+
+	void ClearInterned() noexcept
+	{
+		m_interned.clear();
+		m_changedTiles.clear();
+		m_isTileChanged.clear();
+	}
+
+	// Изменения запоминаются, только пока есть таблица образцов.
+	void MarkTileChanged(int tileX, int tileY)
+	{
+		if (m_isTileChanged.empty())
+		{
+			return;
+		}
+		const size_t index = GetTileIndex(tileX, tileY);
+		if (!m_isTileChanged[index])
+		{
+			m_isTileChanged[index] = true;
+			m_changedTiles.push_back(index);
+		}
+	}
+
+	// Вызывает f для каждого куска строки from.y длиной length, попавшего в
+	// один тайл: f(tileX, tileY, localY, fromX, toX, offset), где [fromX, toX) —
+	// столбцы внутри тайла, а offset — смещение куска от from.x.
+	template <typename F>
+	void ForEachTileInSpan(Point from, int length, F&& f) const
+	{
+		if (from.y < 0 || from.y >= m_size.height)
+		{
+			return;
+		}
+		const int left = std::max(from.x, 0);
+		const int right = std::min(from.x + length, m_size.width);
+		const int tileY = from.y / Tile::SIZE;
+		const int localY = from.y % Tile::SIZE;
+		for (int x = left; x < right;)
+		{
+			const int tileX = x / Tile::SIZE;
+			const int fromX = x - tileX * Tile::SIZE;
+			const int toX = std::min(right - tileX * Tile::SIZE, Tile::SIZE);
+			f(tileX, tileY, localY, fromX, toX, x - from.x);
+			x += toX - fromX;
+		}
+	}
+
 	Size m_size{};
 	int m_tilesX = 0;
 	int m_tilesY = 0;
 	std::vector<CoW<Tile>> m_tiles;
+	size_t m_compactionThreshold = 0;
+	size_t m_detachedTiles = 0;
+	// Таблица образцов для автоматического сжатия (хеш -> экземпляр) и
+	// тайлы, изменённые с прошлого прохода.
+	std::unordered_multimap<size_t, CoW<Tile>> m_interned;
+	std::vector<size_t> m_changedTiles;
+	std::vector<bool> m_isTileChanged;
+	mutable std::vector<MipLevel> m_mipLevels;
+	std::unique_ptr<TilePager> m_pager;
 };
 
+// Совпадают ли видимые пиксели тайлов. Общий экземпляр совпадает без
+// сравнения пикселей.
+inline bool AreTilesEqual(const Image& a, const Image& b, int tileX, int tileY)
+{
+	const Tile& tileA = a.GetTile(tileX, tileY);
+	const Tile& tileB = b.GetTile(tileX, tileY);
+	if (&tileA == &tileB)
+	{
+		return true;
+	}
+	const Size size = a.GetSize();
+	const int width = std::min(Tile::SIZE, size.width - tileX * Tile::SIZE);
+	const int height = std::min(Tile::SIZE, size.height - tileY * Tile::SIZE);
+	for (int y = 0; y < height; ++y)
+	{
+		const auto rowA = tileA.GetRow(y);
+		const auto rowB = tileB.GetRow(y);
+		if (!std::equal(rowA.begin(), rowA.begin() + width, rowB.begin()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Прямоугольники, в которых изображения различаются. Границы проходят по
+// тайлам (и по краю изображения): соседние изменённые тайлы строки
+// объединяются, а одинаковые по ширине полосы соседних строк — в один
+// прямоугольник.
+inline std::vector<Rect> Diff(const Image& a, const Image& b)
+{
+	const Size size = a.GetSize();
+	if (size.width != b.GetSize().width || size.height != b.GetSize().height)
+	{
+		throw std::invalid_argument("Images must have the same size");
+	}
+
+	std::vector<Rect> rects;
+	// Прямоугольники, доходящие до предыдущей строки тайлов, по столбцу
+	// своего первого тайла.
+	std::unordered_map<int, size_t> open;
+	const Size grid = a.GetTileGridSize();
+	for (int tileY = 0; tileY < grid.height; ++tileY)
+	{
+		const int top = tileY * Tile::SIZE;
+		const int bottom = std::min(top + Tile::SIZE, size.height);
+		std::unordered_map<int, size_t> current;
+		for (int tileX = 0; tileX < grid.width;)
+		{
+			if (AreTilesEqual(a, b, tileX, tileY))
+			{
+				++tileX;
+				continue;
+			}
+			const int runStart = tileX;
+			while (tileX < grid.width && !AreTilesEqual(a, b, tileX, tileY))
+			{
+				++tileX;
+			}
+			const int left = runStart * Tile::SIZE;
+			const int right = std::min(tileX * Tile::SIZE, size.width);
+
+			auto above = open.find(runStart);
+			if (above != open.end() && rects[above->second].size.width == right - left)
+			{
+				rects[above->second].size.height = bottom - rects[above->second].topLeft.y;
+				current.emplace(runStart, above->second);
+			}
+			else
+			{
+				current.emplace(runStart, rects.size());
+				rects.push_back({ { left, top }, { right - left, bottom - top } });
+			}
+		}
+		open = std::move(current);
+	}
+	return rects;
+}
+
 #endif // OOD_IMAGE_H
@@ -5,17 +5,25 @@
 #ifndef OOD_IMAGEPROCESSOR_H
 #define OOD_IMAGEPROCESSOR_H
 #include "Image.h"
+#include "MappedFile.h"
 
+#include <algorithm>
+#include <charconv>
 #include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 inline void Print(const Image& img, std::ostream& out)
 {
 	const auto size = img.GetSize();
+	std::vector<Color> row(static_cast<size_t>(size.width));
 	for (int y = 0; y < size.height; ++y)
 	{
-		for (int x = 0; x < size.width; ++x)
+		img.ReadRow(y, row);
+		for (Color c : row)
 		{
-			Color c = img.GetPixel({ x, y });
 			out.put(static_cast<char>(c & 0xFF));
 		}
 		out.put('\n');
@@ -37,31 +45,39 @@ inline Image LoadImage(const std::string& pixels)
 
 	s.clear();
 	s.str(pixels);
+	std::vector<Color> row;
 	for (int y = 0; y < size.height; ++y)
 	{
 		if (!std::getline(s, line))
 			break;
 
-		int x = 0;
-		for (char ch : line)
-		{
-			img.SetPixel({ x++, y }, static_cast<unsigned char>(ch));
-		}
+		row.resize(line.size());
+		std::transform(line.begin(), line.end(), row.begin(), [](char ch) {
+			return static_cast<Color>(static_cast<unsigned char>(ch));
+		});
+		img.WriteSpan({ 0, y }, row);
 	}
 
 	return img;
 }
 
-inline void SaveImage(const Image& image, const std::string& dst)
+// P3 — текстовый PPM, P6 — двоичный PPM, P7 — PAM с тремя каналами.
+enum class ImageFormat
+{
+	PlainPpm,
+	BinaryPpm,
+	Pam,
+};
+
+inline void WritePlainPixels(const Image& image, std::ostream& out)
 {
-	std::ofstream out(dst, std::ios::binary);
 	const auto size = image.GetSize();
-	out << "P3\n" << size.width << " " << size.height << "\n255\n";
+	std::vector<Color> row(static_cast<size_t>(size.width));
 	for (int y = 0; y < size.height; ++y)
 	{
-		for (int x = 0; x < size.width; ++x)
+		image.ReadRow(y, row);
+		for (Color c : row)
 		{
-			Color c = image.GetPixel({ x, y });
 			unsigned r = c >> 16 & 0xFF;
 			unsigned g = c >> 8 & 0xFF;
 			unsigned b = c & 0xFF;
@@ -70,37 +86,291 @@ inline void SaveImage(const Image& image, const std::string& dst)
 	}
 }
 
-inline Image ImportImage(const std::string& source)
+// Пиксели выводятся полосами высотой в тайл: строки каждого тайла полосы
+// переводятся в RGB и вся полоса уходит в поток одной записью.
+inline void WriteBinaryPixels(const Image& image, std::ostream& out)
 {
-	std::ifstream in(source, std::ios::binary);
-	std::string magic;
-	in >> magic;
-	int width = 0;
-	int height = 0;
-	int maxv = 0;
-	in >> width >> height >> maxv;
-	Image img({ width, height }, 0);
-	for (int y = 0; y < height; ++y)
-	{
-		for (int x = 0; x < width; ++x)
+	const auto size = image.GetSize();
+	const auto grid = image.GetTileGridSize();
+	const size_t rowBytes = static_cast<size_t>(size.width) * 3;
+	std::vector<char> band(rowBytes * Tile::SIZE);
+	for (int tileY = 0; tileY < grid.height; ++tileY)
+	{
+		const int bandHeight = std::min(Tile::SIZE, size.height - tileY * Tile::SIZE);
+		for (int tileX = 0; tileX < grid.width; ++tileX)
+		{
+			const Tile& tile = image.GetTile(tileX, tileY);
+			const int left = tileX * Tile::SIZE;
+			const int columns = std::min(Tile::SIZE, size.width - left);
+			for (int y = 0; y < bandHeight; ++y)
+			{
+				const auto row = tile.GetRow(y);
+				char* dst = band.data() + y * rowBytes + static_cast<size_t>(left) * 3;
+				for (int x = 0; x < columns; ++x)
+				{
+					const Color c = row[x];
+					*dst++ = static_cast<char>(c >> 16 & 0xFF);
+					*dst++ = static_cast<char>(c >> 8 & 0xFF);
+					*dst++ = static_cast<char>(c & 0xFF);
+				}
+			}
+		}
+		out.write(band.data(), static_cast<std::streamsize>(rowBytes * bandHeight));
+	}
+}
+
+inline void SaveImage(const Image& image, const std::string& dst, ImageFormat format = ImageFormat::PlainPpm)
+{
+	std::ofstream out(dst, std::ios::binary);
+	if (!out)
+	{
+		throw std::runtime_error("Failed to open file: " + dst);
+	}
+	const auto size = image.GetSize();
+	switch (format)
+	{
+	case ImageFormat::PlainPpm:
+		out << "P3\n" << size.width << " " << size.height << "\n255\n";
+		WritePlainPixels(image, out);
+		break;
+	case ImageFormat::BinaryPpm:
+		out << "P6\n" << size.width << " " << size.height << "\n255\n";
+		WriteBinaryPixels(image, out);
+		break;
+	case ImageFormat::Pam:
+		out << "P7\nWIDTH " << size.width << "\nHEIGHT " << size.height
+			<< "\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n";
+		WriteBinaryPixels(image, out);
+		break;
+	}
+	if (!out.flush())
+	{
+		throw std::runtime_error("Failed to write file: " + dst);
+	}
+}
+
+// Разбор заголовков и текстовых данных PNM прямо из отображённого файла.
+class PnmParser
+{
+public:
+	explicit PnmParser(std::string_view data)
+		: m_data(data)
+	{
+	}
+
+	std::string_view ReadToken()
+	{
+		SkipSpacesAndComments();
+		const size_t begin = m_position;
+		while (m_position < m_data.size() && !IsSpace(m_data[m_position]))
+		{
+			++m_position;
+		}
+		return m_data.substr(begin, m_position - begin);
+	}
+
+	bool ReadInt(int& value)
+	{
+		SkipSpacesAndComments();
+		const char* begin = m_data.data() + m_position;
+		const auto [end, error] = std::from_chars(begin, m_data.data() + m_data.size(), value);
+		if (error != std::errc())
+		{
+			return false;
+		}
+		m_position += static_cast<size_t>(end - begin);
+		return true;
+	}
+
+	int ReadHeaderInt()
+	{
+		int value = 0;
+		if (!ReadInt(value))
+		{
+			throw std::runtime_error("Invalid image header");
+		}
+		return value;
+	}
+
+	// Двоичные данные начинаются после ровно одного пробельного символа.
+	std::string_view GetBinaryData()
+	{
+		if (m_position >= m_data.size() || !IsSpace(m_data[m_position]))
+		{
+			throw std::runtime_error("Invalid image header");
+		}
+		return m_data.substr(m_position + 1);
+	}
+
+	// Строки заголовка PAM заканчиваются переводом строки, поэтому данные
+	// идут сразу после ENDHDR и перевода строки.
+	std::string_view GetDataAfterLine()
+	{
+		const size_t end = m_data.find('\n', m_position);
+		if (end == std::string_view::npos)
+		{
+			throw std::runtime_error("Invalid image header");
+		}
+		return m_data.substr(end + 1);
+	}
+
+private:
+	static bool IsSpace(char ch) noexcept
+	{
+		return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f';
+	}
+
+	void SkipSpacesAndComments()
+	{
+		while (m_position < m_data.size())
+		{
+			if (m_data[m_position] == '#')
+			{
+				const size_t end = m_data.find('\n', m_position);
+				m_position = end == std::string_view::npos ? m_data.size() : end;
+			}
+			else if (IsSpace(m_data[m_position]))
+			{
+				++m_position;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	std::string_view m_data;
+	size_t m_position = 0;
+};
+
+inline Color MakeColor(int r, int g, int b, int maxValue) noexcept
+{
+	if (maxValue != 255 && maxValue > 0)
+	{
+		r = r * 255 / maxValue;
+		g = g * 255 / maxValue;
+		b = b * 255 / maxValue;
+	}
+	return (static_cast<Color>(r & 0xFF) << 16)
+		| (static_cast<Color>(g & 0xFF) << 8)
+		| static_cast<Color>(b & 0xFF);
+}
+
+// Неполные текстовые данные не считаются ошибкой: недостающие пиксели
+// остаются чёрными.
+inline void ReadPlainPixels(Image& img, PnmParser& parser, int maxValue)
+{
+	const auto size = img.GetSize();
+	std::vector<Color> row(static_cast<size_t>(size.width));
+	bool isComplete = true;
+	for (int y = 0; y < size.height && isComplete; ++y)
+	{
+		std::fill(row.begin(), row.end(), 0);
+		for (int x = 0; x < size.width; ++x)
 		{
 			int r = 0;
 			int g = 0;
 			int b = 0;
-			if (!(in >> r >> g >> b))
+			if (!parser.ReadInt(r) || !parser.ReadInt(g) || !parser.ReadInt(b))
+			{
+				isComplete = false;
 				break;
-			if (maxv != 255 && maxv > 0)
+			}
+			row[static_cast<size_t>(x)] = MakeColor(r, g, b, maxValue);
+		}
+		img.WriteRow(y, row);
+	}
+}
+
+// Каналы читаются прямо из отображённого файла в строки тайлов, без
+// промежуточного буфера. Каналы сверх трёх (например, альфа) пропускаются.
+inline void ReadBinaryPixels(Image& img, std::string_view pixels, int depth, int maxValue)
+{
+	const auto size = img.GetSize();
+	const size_t rowBytes = static_cast<size_t>(size.width) * depth;
+	if (pixels.size() < rowBytes * size.height)
+	{
+		throw std::runtime_error("Image data is truncated");
+	}
+	const auto* data = reinterpret_cast<const unsigned char*>(pixels.data());
+	const auto grid = img.GetTileGridSize();
+	for (int tileY = 0; tileY < grid.height; ++tileY)
+	{
+		const int top = tileY * Tile::SIZE;
+		const int bandHeight = std::min(Tile::SIZE, size.height - top);
+		for (int tileX = 0; tileX < grid.width; ++tileX)
+		{
+			Tile& tile = img.GetMutableTile(tileX, tileY);
+			const int left = tileX * Tile::SIZE;
+			const int columns = std::min(Tile::SIZE, size.width - left);
+			for (int y = 0; y < bandHeight; ++y)
 			{
-				r = r * 255 / maxv;
-				g = g * 255 / maxv;
-				b = b * 255 / maxv;
+				auto row = tile.GetRow(y);
+				const unsigned char* src = data + (top + y) * rowBytes + static_cast<size_t>(left) * depth;
+				for (int x = 0; x < columns; ++x, src += depth)
+				{
+					row[x] = MakeColor(src[0], src[1], src[2], maxValue);
+				}
 			}
-			Color c = (static_cast<Color>(r & 0xFF) << 16)
-				| (static_cast<Color>(g & 0xFF) << 8)
-				| static_cast<Color>(b & 0xFF);
-			img.SetPixel({ x, y }, c);
 		}
 	}
-	return img;
+}
+
+inline Image ImportImage(const std::string& source)
+{
+	const MappedFile file(source);
+	PnmParser parser(file.GetData());
+	const auto magic = parser.ReadToken();
+	if (magic == "P3" || magic == "P6")
+	{
+		const int width = parser.ReadHeaderInt();
+		const int height = parser.ReadHeaderInt();
+		const int maxValue = parser.ReadHeaderInt();
+		Image img({ width, height }, 0);
+		if (magic == "P3")
+		{
+			ReadPlainPixels(img, parser, maxValue);
+		}
+		else
+		{
+			if (maxValue <= 0 || maxValue > 255)
+			{
+				throw std::runtime_error("Unsupported max value: " + std::to_string(maxValue));
+			}
+			ReadBinaryPixels(img, parser.GetBinaryData(), 3, maxValue);
+		}
+		return img;
+	}
+	if (magic == "P7")
+	{
+		int width = 0;
+		int height = 0;
+		int depth = 0;
+		int maxValue = 0;
+		for (auto key = parser.ReadToken(); key != "ENDHDR"; key = parser.ReadToken())
+		{
+			if (key == "WIDTH")
+				width = parser.ReadHeaderInt();
+			else if (key == "HEIGHT")
+				height = parser.ReadHeaderInt();
+			else if (key == "DEPTH")
+				depth = parser.ReadHeaderInt();
+			else if (key == "MAXVAL")
+				maxValue = parser.ReadHeaderInt();
+			else if (key == "TUPLTYPE")
+				parser.ReadToken();
+			else
+				throw std::runtime_error("Invalid image header");
+		}
+		if (depth < 3 || maxValue <= 0 || maxValue > 255)
+		{
+			throw std::runtime_error("Unsupported PAM image");
+		}
+		Image img({ width, height }, 0);
+		ReadBinaryPixels(img, parser.GetDataAfterLine(), depth, maxValue);
+		return img;
+	}
+	throw std::runtime_error("Unsupported image format: " + std::string(magic));
 }
 #endif // OOD_IMAGEPROCESSOR_H
@@ -0,0 +1,70 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#ifndef OOD_MAPPEDFILE_H
+#define OOD_MAPPEDFILE_H
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Файл, отображённый в память только для чтения. Содержимое доступно без
+// копирования, пока жив объект.
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& fileName)
+	{
+		const int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			throw std::runtime_error("Failed to open file: " + fileName);
+		}
+		struct stat info{};
+		if (::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Failed to read file: " + fileName);
+		}
+		m_size = static_cast<size_t>(info.st_size);
+		if (m_size > 0)
+		{
+			m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		::close(fd);
+		if (m_data == MAP_FAILED)
+		{
+			throw std::runtime_error("Failed to map file: " + fileName);
+		}
+		if (m_data)
+		{
+			::madvise(m_data, m_size, MADV_SEQUENTIAL);
+		}
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile()
+	{
+		if (m_data)
+		{
+			::munmap(m_data, m_size);
+		}
+	}
+
+	std::string_view GetData() const noexcept
+	{
+		return { static_cast<const char*>(m_data), m_size };
+	}
+
+private:
+	void* m_data = nullptr;
+	size_t m_size = 0;
+};
+
+#endif // OOD_MAPPEDFILE_H
@@ -0,0 +1,188 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#ifndef OOD_SLABPOOL_H
+#define OOD_SLABPOOL_H
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Пул блоков одного размера. Память берётся слябами по нескольку блоков и
+// возвращается в пул, а не в систему: освобождённый блок сразу уходит
+// следующему выделению. Размер блока фиксируется первым выделением; более
+// крупные запросы пул не обслуживает.
+class SlabPool
+{
+public:
+	explicit SlabPool(size_t alignment, size_t blocksPerSlab = 256)
+		: m_alignment(alignment)
+		, m_blocksPerSlab(blocksPerSlab)
+	{
+	}
+
+	SlabPool(const SlabPool&) = delete;
+	SlabPool& operator=(const SlabPool&) = delete;
+
+	~SlabPool()
+	{
+		for (void* slab : m_slabs)
+		{
+			::operator delete(slab, std::align_val_t(m_alignment));
+		}
+	}
+
+	// Возвращает nullptr, если блок такого размера пулу не подходит.
+	void* Allocate(size_t size)
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_blockSize == 0)
+		{
+			m_blockSize = (std::max(size, sizeof(FreeBlock)) + m_alignment - 1) / m_alignment * m_alignment;
+		}
+		if (size > m_blockSize)
+		{
+			return nullptr;
+		}
+		++m_liveBlocks;
+		if (m_freeList)
+		{
+			FreeBlock* block = m_freeList;
+			m_freeList = block->next;
+			return block;
+		}
+		if (m_slabCursor == m_slabEnd)
+		{
+			AddSlab();
+		}
+		void* block = m_slabCursor;
+		m_slabCursor += m_blockSize;
+		return block;
+	}
+
+	bool Owns(size_t size) const
+	{
+		std::lock_guard lock(m_mutex);
+		return size <= m_blockSize;
+	}
+
+	void Deallocate(void* p) noexcept
+	{
+		std::lock_guard lock(m_mutex);
+		--m_liveBlocks;
+		m_freeList = new (p) FreeBlock{ m_freeList };
+	}
+
+	size_t GetBlockSize() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_blockSize;
+	}
+
+	size_t GetLiveBlockCount() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_liveBlocks;
+	}
+
+	size_t GetReservedBytes() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_slabs.size() * m_blockSize * m_blocksPerSlab;
+	}
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	void AddSlab()
+	{
+		const size_t bytes = m_blockSize * m_blocksPerSlab;
+		auto* slab = static_cast<std::byte*>(::operator new(bytes, std::align_val_t(m_alignment)));
+		m_slabs.push_back(slab);
+		m_slabCursor = slab;
+		m_slabEnd = slab + bytes;
+	}
+
+	const size_t m_alignment;
+	const size_t m_blocksPerSlab;
+
+	mutable std::mutex m_mutex;
+	size_t m_blockSize = 0;
+	std::vector<void*> m_slabs;
+	std::byte* m_slabCursor = nullptr;
+	std::byte* m_slabEnd = nullptr;
+	FreeBlock* m_freeList = nullptr;
+	size_t m_liveBlocks = 0;
+};
+
+// Пул намеренно не разрушается: объекты в статических переменных могут
+// освобождаться уже после выхода из main.
+template <typename Tag, size_t Alignment>
+SlabPool& GetSlabPool()
+{
+	static SlabPool* pool = new SlabPool(Alignment);
+	return *pool;
+}
+
+// Аллокатор для блоков CoW: объект и его атомарный счётчик ссылок лежат в
+// одном блоке пула. CoW перепривязывает аллокатор к типу своего блока,
+// поэтому пул выбирается по Tag, а не по T.
+template <typename T, typename Tag = T>
+class PoolAllocator
+{
+public:
+	using value_type = T;
+	static constexpr size_t ALIGNMENT = 64;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = PoolAllocator<U, Tag>;
+	};
+
+	PoolAllocator() noexcept = default;
+
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U, Tag>&) noexcept
+	{
+	}
+
+	T* allocate(size_t n)
+	{
+		static_assert(alignof(T) <= ALIGNMENT);
+		void* block = n == 1 ? GetPool().Allocate(sizeof(T)) : nullptr;
+		if (!block)
+		{
+			block = ::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT));
+		}
+		return static_cast<T*>(block);
+	}
+
+	void deallocate(T* p, size_t n) noexcept
+	{
+		if (n == 1 && GetPool().Owns(sizeof(T)))
+		{
+			GetPool().Deallocate(p);
+			return;
+		}
+		::operator delete(p, std::align_val_t(ALIGNMENT));
+	}
+
+	static SlabPool& GetPool()
+	{
+		return GetSlabPool<Tag, ALIGNMENT>();
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U, Tag>&) const noexcept
+	{
+		return true;
+	}
+};
+
+#endif // OOD_SLABPOOL_H
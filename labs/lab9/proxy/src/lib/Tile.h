@@ -4,35 +4,52 @@
 
 #ifndef OOD_TILE_H
 #define OOD_TILE_H
+#include <algorithm>
 #include <array>
 #include <cassert>
 
 #include "Geom.h"
+#include "SlabPool.h"
 
-#include <vector>
+#include <atomic>
+#include <functional>
+#include <span>
+#include <string_view>
+
+// Размер стороны тайла задаётся при сборке.
+#ifndef OOD_TILE_SIZE
+#define OOD_TILE_SIZE 8
+#endif
 
 class Tile
 {
 public:
-	constexpr static int SIZE = 8;
+	constexpr static int SIZE = OOD_TILE_SIZE;
+	static_assert(SIZE == 8 || SIZE == 16 || SIZE == 32 || SIZE == 64, "Tile size must be 8, 16, 32 or 64");
+
+	// CoW создаёт тайлы через этот аллокатор, поэтому тайл вместе со счётчиком
+	// ссылок занимает один блок пула и не требует отдельных выделений памяти.
+	using allocator_type = PoolAllocator<Tile>;
 
 	Tile(Color color = 0) noexcept
-		: m_pixels(SIZE * SIZE, color)
 	{
+		m_pixels.fill(color);
 		assert(m_instanceCount >= 0);
-		++m_instanceCount;
+		m_instanceCount.fetch_add(1, std::memory_order_relaxed);
 	}
 
-	Tile(const Tile& other)
+	Tile(const Tile& other) noexcept
 		: m_pixels(other.m_pixels)
 	{
 		assert(m_instanceCount >= 0);
-		++m_instanceCount;
+		m_instanceCount.fetch_add(1, std::memory_order_relaxed);
 	}
 
+	Tile& operator=(const Tile& other) noexcept = default;
+
 	~Tile()
 	{
-		--m_instanceCount;
+		m_instanceCount.fetch_sub(1, std::memory_order_relaxed);
 		assert(m_instanceCount >= 0);
 	}
 
@@ -54,13 +71,62 @@ public:
 		return m_pixels[p.y * SIZE + p.x];
 	}
 
+	// Строка тайла целиком; y должен лежать в [0, SIZE).
+	std::span<Color, SIZE> GetRow(int y) noexcept
+	{
+		assert(y >= 0 && y < SIZE);
+		return std::span<Color, SIZE>(m_pixels.data() + y * SIZE, SIZE);
+	}
+
+	std::span<const Color, SIZE> GetRow(int y) const noexcept
+	{
+		assert(y >= 0 && y < SIZE);
+		return std::span<const Color, SIZE>(m_pixels.data() + y * SIZE, SIZE);
+	}
+
+	// Все пиксели тайла строка за строкой.
+	std::span<Color, SIZE * SIZE> GetPixels() noexcept
+	{
+		return m_pixels;
+	}
+
+	std::span<const Color, SIZE * SIZE> GetPixels() const noexcept
+	{
+		return m_pixels;
+	}
+
+	// Заливает пиксели [fromX, toX) строки y.
+	void FillRow(int y, int fromX, int toX, Color color) noexcept
+	{
+		auto row = GetRow(y);
+		std::fill(row.begin() + fromX, row.begin() + toX, color);
+	}
+
+	bool IsUniform() const noexcept
+	{
+		return std::all_of(m_pixels.begin(), m_pixels.end(), [this](Color c) {
+			return c == m_pixels[0];
+		});
+	}
+
+	size_t GetHash() const noexcept
+	{
+		const auto* bytes = reinterpret_cast<const char*>(m_pixels.data());
+		return std::hash<std::string_view>{}(std::string_view(bytes, sizeof(m_pixels)));
+	}
+
+	bool operator==(const Tile& other) const noexcept
+	{
+		return m_pixels == other.m_pixels;
+	}
+
 	static int GetInstanceCount() noexcept
 	{
-		return m_instanceCount;
+		return m_instanceCount.load(std::memory_order_relaxed);
 	}
 
 private:
-	inline static int m_instanceCount = 0;
-	std::vector<Color> m_pixels;
+	inline static std::atomic<int> m_instanceCount = 0;
+	alignas(64) std::array<Color, SIZE * SIZE> m_pixels;
 };
 #endif // OOD_TILE_H
@@ -0,0 +1,291 @@
+//
+// Created by smmm on 05.12.2025.
+//
+#include "TilePager.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace
+{
+
+constexpr size_t MIN_RESIDENT_TILES = 4;
+constexpr size_t TILE_BYTES = sizeof(Color) * Tile::SIZE * Tile::SIZE;
+
+// Файл подкачки удаляется сразу после создания и исчезает вместе с
+// дескриптором.
+int CreatePageFile(const std::filesystem::path& directory)
+{
+	std::string name = (directory / "ood-tiles-XXXXXX").string();
+	const int fd = ::mkstemp(name.data());
+	if (fd < 0)
+	{
+		throw std::runtime_error("Failed to create page file in " + directory.string());
+	}
+	::unlink(name.c_str());
+	return fd;
+}
+
+off_t GetSlotOffset(uint32_t slot)
+{
+	return static_cast<off_t>(slot) * static_cast<off_t>(TILE_BYTES);
+}
+
+bool WriteSlot(int fd, uint32_t slot, std::span<const Color> pixels)
+{
+	const auto* data = reinterpret_cast<const char*>(pixels.data());
+	for (size_t done = 0; done < TILE_BYTES;)
+	{
+		const ssize_t written = ::pwrite(fd, data + done, TILE_BYTES - done, GetSlotOffset(slot) + static_cast<off_t>(done));
+		if (written <= 0)
+		{
+			return false;
+		}
+		done += static_cast<size_t>(written);
+	}
+	return true;
+}
+
+bool ReadSlot(int fd, uint32_t slot, std::span<Color> pixels)
+{
+	auto* data = reinterpret_cast<char*>(pixels.data());
+	for (size_t done = 0; done < TILE_BYTES;)
+	{
+		const ssize_t read = ::pread(fd, data + done, TILE_BYTES - done, GetSlotOffset(slot) + static_cast<off_t>(done));
+		if (read <= 0)
+		{
+			return false;
+		}
+		done += static_cast<size_t>(read);
+	}
+	return true;
+}
+
+} // namespace
+
+TilePager::TilePager(size_t tileCount, Color color, const PagingOptions& options)
+	: m_residentLimit(std::max(options.residentTiles, MIN_RESIDENT_TILES))
+	, m_states(tileCount, TileState{ color, false })
+	, m_fd(CreatePageFile(options.directory))
+	, m_writer([this](std::stop_token stopToken) {
+		RunWriter(stopToken);
+	})
+{
+}
+
+TilePager::~TilePager()
+{
+	// Незаписанные тайлы больше не нужны: файл удаляется вместе с хранилищем.
+	m_writer.request_stop();
+	m_writer.join();
+	::close(m_fd);
+}
+
+const CoW<Tile>& TilePager::GetTile(size_t index)
+{
+	return FaultIn(index).tile;
+}
+
+Tile& TilePager::GetMutableTile(size_t index)
+{
+	Resident& resident = FaultIn(index);
+	resident.isDirty = true;
+	return *resident.tile.Write();
+}
+
+void TilePager::Fill(size_t index, Color color)
+{
+	auto resident = m_resident.find(index);
+	if (resident != m_resident.end())
+	{
+		m_lru.erase(resident->second.lruPosition);
+		m_resident.erase(resident);
+	}
+	SetUniform(index, color);
+}
+
+void TilePager::Flush()
+{
+	for (auto& [index, resident] : m_resident)
+	{
+		if (resident.isDirty)
+		{
+			WriteBack(index, resident);
+		}
+	}
+	{
+		std::unique_lock lock(m_mutex);
+		m_changed.wait(lock, [this] {
+			return m_jobsInFlight == 0;
+		});
+	}
+	CheckWriterError();
+}
+
+size_t TilePager::GetResidentLimit() const noexcept
+{
+	return m_residentLimit;
+}
+
+size_t TilePager::GetResidentCount() const noexcept
+{
+	return m_resident.size();
+}
+
+size_t TilePager::GetStoredTileCount() const noexcept
+{
+	return m_slotCount - m_freeSlots.size();
+}
+
+size_t TilePager::GetDistinctTileCount()
+{
+	Flush();
+	std::unordered_set<Color> colors;
+	for (const TileState& state : m_states)
+	{
+		if (!state.isStored)
+		{
+			colors.insert(state.value);
+		}
+	}
+	return colors.size() + GetStoredTileCount();
+}
+
+TilePager::Resident& TilePager::FaultIn(size_t index)
+{
+	auto resident = m_resident.find(index);
+	if (resident != m_resident.end())
+	{
+		m_lru.splice(m_lru.begin(), m_lru, resident->second.lruPosition);
+		return resident->second;
+	}
+	CheckWriterError();
+	if (m_resident.size() >= m_residentLimit)
+	{
+		Evict();
+	}
+	CoW<Tile> tile = LoadTile(index);
+	m_lru.push_front(index);
+	return m_resident.emplace(index, Resident{ std::move(tile), false, m_lru.begin() }).first->second;
+}
+
+CoW<Tile> TilePager::LoadTile(size_t index)
+{
+	const TileState state = m_states[index];
+	if (!state.isStored)
+	{
+		return CoW<Tile>(state.value);
+	}
+	{
+		std::lock_guard lock(m_mutex);
+		auto pending = m_pending.find(index);
+		if (pending != m_pending.end())
+		{
+			return pending->second;
+		}
+	}
+	CoW<Tile> tile(0);
+	if (!ReadSlot(m_fd, state.value, tile.Write()->GetPixels()))
+	{
+		throw std::runtime_error("Failed to read tile from page file");
+	}
+	return tile;
+}
+
+void TilePager::Evict()
+{
+	const size_t index = m_lru.back();
+	auto resident = m_resident.find(index);
+	if (resident->second.isDirty)
+	{
+		WriteBack(index, resident->second);
+	}
+	m_lru.pop_back();
+	m_resident.erase(resident);
+}
+
+void TilePager::WriteBack(size_t index, Resident& resident)
+{
+	resident.isDirty = false;
+	if (resident.tile->IsUniform())
+	{
+		SetUniform(index, resident.tile->GetPixel({ 0, 0 }));
+		return;
+	}
+	TileState& state = m_states[index];
+	if (!state.isStored)
+	{
+		if (m_freeSlots.empty())
+		{
+			state = { m_slotCount++, true };
+		}
+		else
+		{
+			state = { m_freeSlots.back(), true };
+			m_freeSlots.pop_back();
+		}
+	}
+
+	// Очередь ограничена, чтобы ожидающие записи тайлы не заняли больше
+	// памяти, чем загруженные.
+	std::unique_lock lock(m_mutex);
+	m_changed.wait(lock, [this] {
+		return m_jobsInFlight < m_residentLimit;
+	});
+	m_pending.insert_or_assign(index, resident.tile);
+	m_queue.push_back({ index, state.value, resident.tile });
+	++m_jobsInFlight;
+	m_changed.notify_all();
+}
+
+// Место в файле освобождается сразу: если запись в него ещё в очереди, она
+// выполнится раньше записи нового владельца, так как очередь одна.
+void TilePager::SetUniform(size_t index, Color color)
+{
+	TileState& state = m_states[index];
+	if (state.isStored)
+	{
+		m_freeSlots.push_back(state.value);
+	}
+	state = { color, false };
+	std::lock_guard lock(m_mutex);
+	m_pending.erase(index);
+}
+
+void TilePager::CheckWriterError()
+{
+	std::lock_guard lock(m_mutex);
+	if (m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+}
+
+void TilePager::RunWriter(std::stop_token stopToken)
+{
+	std::unique_lock lock(m_mutex);
+	while (m_changed.wait(lock, stopToken, [this] { return !m_queue.empty(); }))
+	{
+		WriteJob job = std::move(m_queue.front());
+		m_queue.pop_front();
+		lock.unlock();
+		const bool isWritten = WriteSlot(m_fd, job.slot, job.tile->GetPixels());
+		lock.lock();
+
+		if (!isWritten && !m_error)
+		{
+			m_error = std::make_exception_ptr(std::runtime_error("Failed to write tile to page file"));
+		}
+		// Запись уже в файле, если с тех пор тайл не поставлен в очередь снова.
+		auto pending = m_pending.find(job.index);
+		if (pending != m_pending.end() && &*pending->second == &*job.tile)
+		{
+			m_pending.erase(pending);
+		}
+		--m_jobsInFlight;
+		m_changed.notify_all();
+	}
+}
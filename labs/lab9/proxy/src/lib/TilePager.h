@@ -0,0 +1,114 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#ifndef OOD_TILEPAGER_H
+#define OOD_TILEPAGER_H
+#include "CoW.h"
+#include "Tile.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct PagingOptions
+{
+	// Сколько тайлов держать в памяти; не меньше 4.
+	size_t residentTiles = 4096;
+	// Каталог для файла подкачки.
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+};
+
+/**
+ * Хранилище тайлов в файле подкачки с вытеснением давно не использованных.
+ *
+ * В памяти находится не больше residentTiles тайлов. Однотонный тайл
+ * хранится одним цветом и в файл не пишется; остальные при вытеснении
+ * ставятся в очередь, которую фоновый поток записывает в файл. Пока запись не
+ * завершилась, тайл читается из очереди. Ссылка на тайл действительна, пока
+ * не загружены residentTiles - 1 других тайлов или тайл не залит через Fill.
+ * Методы вызываются из одного потока.
+ */
+class TilePager
+{
+public:
+	TilePager(size_t tileCount, Color color, const PagingOptions& options);
+	~TilePager();
+
+	TilePager(const TilePager&) = delete;
+	TilePager& operator=(const TilePager&) = delete;
+
+	const CoW<Tile>& GetTile(size_t index);
+	// Тайл помечается изменённым и будет записан при вытеснении.
+	Tile& GetMutableTile(size_t index);
+	void Fill(size_t index, Color color);
+
+	// Записывает изменённые тайлы и ждёт окончания записи.
+	void Flush();
+
+	size_t GetResidentLimit() const noexcept;
+	size_t GetResidentCount() const noexcept;
+	// Число тайлов, занимающих место в файле.
+	size_t GetStoredTileCount() const noexcept;
+	// Число различных тайлов: хранящиеся в файле плюс различные цвета
+	// однотонных.
+	size_t GetDistinctTileCount();
+
+private:
+	// Цвет однотонного тайла или номер его места в файле.
+	struct TileState
+	{
+		uint32_t value;
+		bool isStored;
+	};
+
+	struct Resident
+	{
+		CoW<Tile> tile;
+		bool isDirty;
+		std::list<size_t>::iterator lruPosition;
+	};
+
+	struct WriteJob
+	{
+		size_t index;
+		uint32_t slot;
+		CoW<Tile> tile;
+	};
+
+	Resident& FaultIn(size_t index);
+	CoW<Tile> LoadTile(size_t index);
+	void Evict();
+	void WriteBack(size_t index, Resident& resident);
+	void SetUniform(size_t index, Color color);
+	void CheckWriterError();
+	void RunWriter(std::stop_token stopToken);
+
+	size_t m_residentLimit;
+	std::vector<TileState> m_states;
+	std::vector<uint32_t> m_freeSlots;
+	uint32_t m_slotCount = 0;
+	std::unordered_map<size_t, Resident> m_resident;
+	// Загруженные тайлы, недавно использованные в начале.
+	std::list<size_t> m_lru;
+	int m_fd = -1;
+
+	// Общее с потоком записи.
+	std::mutex m_mutex;
+	std::condition_variable_any m_changed;
+	std::deque<WriteJob> m_queue;
+	// Последнее поставленное в очередь содержимое тайлов, ещё не записанное.
+	std::unordered_map<size_t, CoW<Tile>> m_pending;
+	size_t m_jobsInFlight = 0;
+	std::exception_ptr m_error;
+	std::jthread m_writer;
+};
+
+#endif // OOD_TILEPAGER_H
@@ -0,0 +1,155 @@
+//
+// Created by smmm on 05.12.2025.
+//
+
+#ifndef OOD_WORKERPOOL_H
+#define OOD_WORKERPOOL_H
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Потоки, которые запускаются один раз и ждут следующего пакета задач:
+// пакет стоит пробуждения, а не запуска потока. Вызывающий Run поток тоже
+// берёт задачи. Пакеты выполняются по одному; Run из нескольких потоков
+// ждут друг друга.
+class WorkerPool
+{
+public:
+	WorkerPool() = default;
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_changed.notify_all();
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	// Общий пул процесса. Потоки добавляются, когда Run просит больше,
+	// чем уже запущено, и живут до выхода из программы.
+	static WorkerPool& GetShared()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+
+	size_t GetThreadCount() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_threads.size();
+	}
+
+	// Выполняет job(0) ... job(count - 1) не более чем в threadCount потоках,
+	// считая вызывающий, и возвращается, когда все задачи закончены. После
+	// исключения в задаче ещё не начатые задачи пропускаются, а первое
+	// исключение пробрасывается отсюда.
+	template <typename Job>
+	void Run(size_t count, Job&& job, unsigned threadCount)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::lock_guard run(m_runMutex);
+		std::unique_lock lock(m_mutex);
+		const size_t helperCount = std::min<size_t>(std::max(threadCount, 1u), count) - 1;
+		while (m_threads.size() < helperCount)
+		{
+			m_threads.emplace_back([this] { Work(); });
+		}
+		m_job = std::ref(job);
+		m_count = count;
+		m_next = 0;
+		m_freeHelpers = helperCount;
+		m_changed.notify_all();
+
+		RunJobs(lock);
+		m_finished.wait(lock, [&] { return m_active == 0; });
+
+		m_job = nullptr;
+		m_count = m_next = 0;
+		m_freeHelpers = 0;
+		if (auto error = std::exchange(m_error, nullptr))
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+private:
+	void Work()
+	{
+		std::unique_lock lock(m_mutex);
+		while (true)
+		{
+			m_changed.wait(lock, [&] { return m_isStopped || (m_next < m_count && m_freeHelpers > 0); });
+			if (m_isStopped)
+			{
+				return;
+			}
+			--m_freeHelpers;
+			RunJobs(lock);
+		}
+	}
+
+	// Берёт задачи, пока они не кончатся; на время задачи мьютекс отпускается.
+	void RunJobs(std::unique_lock<std::mutex>& lock)
+	{
+		while (m_next < m_count)
+		{
+			const size_t index = m_next++;
+			++m_active;
+			lock.unlock();
+			std::exception_ptr error;
+			try
+			{
+				m_job(index);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			lock.lock();
+			--m_active;
+			if (error && !m_error)
+			{
+				m_error = error;
+				m_next = m_count;
+			}
+		}
+		if (m_active == 0)
+		{
+			m_finished.notify_all();
+		}
+	}
+
+	std::vector<std::thread> m_threads;
+	// Держится всё время Run.
+	std::mutex m_runMutex;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::condition_variable m_finished;
+	std::function<void(size_t)> m_job;
+	size_t m_count = 0;
+	size_t m_next = 0;
+	size_t m_active = 0;
+	// Сколько ещё потоков пула может присоединиться к текущему пакету.
+	size_t m_freeHelpers = 0;
+	std::exception_ptr m_error;
+	bool m_isStopped = false;
+};
+
+#endif // OOD_WORKERPOOL_H
@@ -0,0 +1,110 @@
+//
+// Created by smmm on 05.12.2025.
+//
+#include "../src/lib/Compositor.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+const BlendMode MODES[] = { BlendMode::Over, BlendMode::Multiply, BlendMode::Screen };
+
+Color Blend(BlendMode mode, Color src, Color dst)
+{
+	GetScalarBlendKernel(mode)(&src, &dst, 1);
+	return dst;
+}
+} // namespace
+
+TEST(CompositorTest, BlendModesOnSimpleValues)
+{
+	EXPECT_EQ(0xFF123456u, Blend(BlendMode::Over, 0xFF123456, 0xFFABCDEF));
+	EXPECT_EQ(0xFFABCDEFu, Blend(BlendMode::Over, 0x00123456, 0xFFABCDEF));
+	EXPECT_EQ(0xFF808080u, Blend(BlendMode::Over, 0x80FFFFFF, 0xFF000000));
+	EXPECT_EQ(0x80000000u | 0x00808080u, Blend(BlendMode::Over, 0x80FFFFFF, 0x00000000));
+
+	EXPECT_EQ(0xFFABCDEFu, Blend(BlendMode::Multiply, 0xFFFFFFFF, 0xFFABCDEF));
+	EXPECT_EQ(0xFF000000u, Blend(BlendMode::Multiply, 0xFF000000, 0xFFABCDEF));
+	EXPECT_EQ(0xFFABCDEFu, Blend(BlendMode::Screen, 0xFF000000, 0xFFABCDEF));
+	EXPECT_EQ(0xFFFFFFFFu, Blend(BlendMode::Screen, 0xFFFFFFFF, 0xFFABCDEF));
+	EXPECT_EQ(0xFFC0C0C0u, Blend(BlendMode::Screen, 0xFF808080, 0xFF808080));
+}
+
+TEST(CompositorTest, VectorKernelMatchesScalar)
+{
+	std::mt19937 random(7);
+	std::vector<Color> src(1000);
+	std::vector<Color> dst(src.size());
+	for (size_t i = 0; i < src.size(); ++i)
+	{
+		src[i] = random();
+		dst[i] = random();
+	}
+	// Крайние значения альфы и каналов.
+	src[0] = 0x00FFFFFF;
+	src[1] = 0xFF000000;
+	src[2] = 0xFFFFFFFF;
+	dst[2] = 0xFFFFFFFF;
+
+	for (BlendMode mode : MODES)
+	{
+		const BlendKernel vector = GetAvx2BlendKernel(mode);
+		if (!vector)
+		{
+			GTEST_SKIP() << "AVX2 is not supported";
+		}
+		std::vector<Color> expected = dst;
+		std::vector<Color> actual = dst;
+		GetScalarBlendKernel(mode)(src.data(), expected.data(), expected.size());
+		vector(src.data(), actual.data(), actual.size() - 3);
+		GetScalarBlendKernel(mode)(src.data() + actual.size() - 3, actual.data() + actual.size() - 3, 3);
+		EXPECT_EQ(expected, actual);
+	}
+}
+
+TEST(CompositorTest, CompositesImageWithClipping)
+{
+	Image dst({ 3 * Tile::SIZE, 2 * Tile::SIZE }, 0xFF000000);
+	Image src({ 2 * Tile::SIZE, Tile::SIZE + 3 }, 0x80FFFFFF);
+	src.SetPixel({ 0, 0 }, 0xFF00FF00);
+
+	const Point position{ 2 * Tile::SIZE - 3, Tile::SIZE / 2 };
+	Composite(dst, position, src, BlendMode::Over);
+
+	for (int y = 0; y < dst.GetSize().height; ++y)
+	{
+		for (int x = 0; x < dst.GetSize().width; ++x)
+		{
+			const Point local{ x - position.x, y - position.y };
+			const bool isCovered = IsPointInSize(local, src.GetSize());
+			const Color expected = !isCovered ? 0xFF000000 : Blend(BlendMode::Over, src.GetPixel(local), 0xFF000000);
+			ASSERT_EQ(expected, dst.GetPixel({ x, y })) << x << "," << y;
+		}
+	}
+	EXPECT_EQ(0xFF00FF00u, dst.GetPixel(position));
+}
+
+TEST(CompositorTest, CompositesSolidColor)
+{
+	Image img({ 2 * Tile::SIZE, 2 * Tile::SIZE }, 0xFF404040);
+	Composite(img, Rect{ { 1, 1 }, { Tile::SIZE, 2 } }, 0xFF808080, BlendMode::Multiply);
+	EXPECT_EQ(0xFF404040u, img.GetPixel({ 0, 0 }));
+	EXPECT_EQ(0xFF202020u, img.GetPixel({ 1, 1 }));
+	EXPECT_EQ(0xFF202020u, img.GetPixel({ Tile::SIZE, 2 }));
+	EXPECT_EQ(0xFF404040u, img.GetPixel({ Tile::SIZE + 1, 2 }));
+
+	const int instances = Tile::GetInstanceCount();
+	Composite(img, Rect{ { 0, 0 }, { 2 * Tile::SIZE, 2 * Tile::SIZE } }, 0xFF00FF00, BlendMode::Over);
+	EXPECT_EQ(0xFF00FF00u, img.GetPixel({ 5, 5 }));
+	EXPECT_GT(instances, Tile::GetInstanceCount());
+}
+
+TEST(CompositorTest, CompositesImageOntoItself)
+{
+	Image img({ Tile::SIZE, 2 }, 0xFF000000);
+	img.SetPixel({ 0, 0 }, 0xFFFFFFFF);
+	Composite(img, { 0, 1 }, img, BlendMode::Screen);
+	EXPECT_EQ(0xFFFFFFFFu, img.GetPixel({ 0, 1 }));
+	EXPECT_EQ(0xFF000000u, img.GetPixel({ 1, 1 }));
+}
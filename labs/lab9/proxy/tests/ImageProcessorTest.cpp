@@ -0,0 +1,114 @@
+//
+// Created by smmm on 05.12.2025.
+//
+#include "../src/lib/ImageProcessor.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace std::string_literals;
+
+namespace
+{
+std::string GetTempPath(const std::string& name)
+{
+	return (std::filesystem::temp_directory_path() / ("ood_lab9_" + name)).string();
+}
+
+void WriteFile(const std::string& path, const std::string& content)
+{
+	std::ofstream out(path, std::ios::binary);
+	out << content;
+}
+
+std::string ReadFile(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	return { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+}
+
+Image MakeGradient(Size size)
+{
+	Image img(size, 0);
+	for (int y = 0; y < size.height; ++y)
+	{
+		for (int x = 0; x < size.width; ++x)
+		{
+			img.SetPixel({ x, y }, static_cast<Color>((x * 7) << 16 | (y * 5) << 8 | (x + y)) & 0xFFFFFF);
+		}
+	}
+	return img;
+}
+
+void ExpectSamePixels(const Image& expected, const Image& actual)
+{
+	ASSERT_EQ(expected.GetSize().width, actual.GetSize().width);
+	ASSERT_EQ(expected.GetSize().height, actual.GetSize().height);
+	for (int y = 0; y < expected.GetSize().height; ++y)
+	{
+		for (int x = 0; x < expected.GetSize().width; ++x)
+		{
+			ASSERT_EQ(expected.GetPixel({ x, y }), actual.GetPixel({ x, y })) << "at " << x << "," << y;
+		}
+	}
+}
+} // namespace
+
+TEST(ImageFormatTest, EveryFormatRoundTrips)
+{
+	const Image original = MakeGradient({ 2 * Tile::SIZE + 3, Tile::SIZE + 5 });
+	for (auto format : { ImageFormat::PlainPpm, ImageFormat::BinaryPpm, ImageFormat::Pam })
+	{
+		const auto path = GetTempPath("roundtrip.pnm");
+		SaveImage(original, path, format);
+		ExpectSamePixels(original, ImportImage(path));
+		std::filesystem::remove(path);
+	}
+}
+
+TEST(ImageFormatTest, BinaryPpmLayout)
+{
+	Image img({ 2, 1 }, 0);
+	img.SetPixel({ 0, 0 }, 0x102030);
+	img.SetPixel({ 1, 0 }, 0xA0B0C0);
+	const auto path = GetTempPath("layout.ppm");
+	SaveImage(img, path, ImageFormat::BinaryPpm);
+
+	EXPECT_EQ("P6\n2 1\n255\n\x10\x20\x30\xA0\xB0\xC0"s, ReadFile(path));
+	std::filesystem::remove(path);
+}
+
+TEST(ImageFormatTest, ReadsCommentsScaledValuesAndAlpha)
+{
+	const auto path = GetTempPath("input.pnm");
+
+	WriteFile(path, "P6\n# comment\n1 1\n15\n\x0F\x00\x05"s);
+	EXPECT_EQ(0xFF0055u, ImportImage(path).GetPixel({ 0, 0 }));
+
+	WriteFile(path, "P7\nWIDTH 2\nHEIGHT 1\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n"
+					"\x01\x02\x03\xFF\x04\x05\x06\x00"s);
+	const Image pam = ImportImage(path);
+	EXPECT_EQ(0x010203u, pam.GetPixel({ 0, 0 }));
+	EXPECT_EQ(0x040506u, pam.GetPixel({ 1, 0 }));
+
+	WriteFile(path, "P3\n# comment\n2 1 255\n1 2 3\n");
+	const Image plain = ImportImage(path);
+	EXPECT_EQ(0x010203u, plain.GetPixel({ 0, 0 }));
+	EXPECT_EQ(0u, plain.GetPixel({ 1, 0 }));
+
+	std::filesystem::remove(path);
+}
+
+TEST(ImageFormatTest, RejectsBrokenFiles)
+{
+	const auto path = GetTempPath("broken.pnm");
+
+	WriteFile(path, "P6\n2 2\n255\n\x01\x02\x03");
+	EXPECT_THROW(ImportImage(path), std::runtime_error);
+
+	WriteFile(path, "P5\n1 1\n255\n\x01");
+	EXPECT_THROW(ImportImage(path), std::runtime_error);
+
+	std::filesystem::remove(path);
+	EXPECT_THROW(ImportImage(path), std::runtime_error);
+}
@@ -1,8 +1,12 @@
 //
 // Created by smmm on 05.12.2025.
 //
+#include "../src/lib/DrawList.h"
+#include "../src/lib/Drawer.h"
 #include "../src/lib/Image.h"
+#include <cstdint>
 #include <exception>
+#include <thread>
 #include <gtest/gtest.h>
 
 class TestImage : public Image
@@ -191,3 +195,601 @@ TEST(ImageTilesTest, SixteenBySixteenModifySameTileTwiceKeepsSharingPattern)
 	// TODO: проверить Tile::GetIN... у каждого тайла. Надо.
 	EXPECT_EQ(1, tiles[static_cast<size_t>(index)].GetLinksCount());
 }
+
+TEST(ImageBulkAccessTest, FillRectSharesFullyCoveredTiles)
+{
+	TestImage img({ 32, 32 }, 0);
+	img.FillRect({ 4, 4 }, { 24, 24 }, 0xABCDEF);
+
+	for (int y = 0; y < 32; ++y)
+	{
+		for (int x = 0; x < 32; ++x)
+		{
+			bool inside = x >= 4 && x < 28 && y >= 4 && y < 28;
+			ASSERT_EQ(inside ? 0xABCDEFu : 0u, img.GetPixel({ x, y })) << x << "," << y;
+		}
+	}
+
+	auto& tiles = img.Tiles();
+	for (int tileY = 1; tileY <= 2; ++tileY)
+	{
+		for (int tileX = 1; tileX <= 2; ++tileX)
+		{
+			EXPECT_EQ(4, tiles[static_cast<size_t>(tileY * 4 + tileX)].GetLinksCount());
+		}
+	}
+	EXPECT_EQ(1, tiles[0].GetLinksCount());
+}
+
+TEST(ImageBulkAccessTest, SpansAreClippedAndCrossTiles)
+{
+	TestImage img({ 20, 10 }, 0x111111);
+	std::vector<Color> written(30);
+	for (size_t i = 0; i < written.size(); ++i)
+	{
+		written[i] = static_cast<Color>(i + 1);
+	}
+	img.WriteSpan({ -3, 9 }, written);
+	img.WriteSpan({ 0, 10 }, written);
+
+	for (int x = 0; x < 20; ++x)
+	{
+		EXPECT_EQ(static_cast<Color>(x + 4), img.GetPixel({ x, 9 }));
+	}
+
+	std::vector<Color> read(24, 0xFFFFFFFF);
+	img.ReadSpan({ -2, 9 }, read);
+	EXPECT_EQ(0u, read[0]);
+	EXPECT_EQ(0u, read[1]);
+	EXPECT_EQ(4u, read[2]);
+	EXPECT_EQ(23u, read[21]);
+	EXPECT_EQ(0u, read[22]);
+
+	std::vector<Color> row(20);
+	img.ReadRow(8, row);
+	EXPECT_EQ(std::vector<Color>(20, 0x111111), row);
+
+	img.FillSpan({ 5, 8 }, 0, 0x222222);
+	img.FillSpan({ 18, 8 }, 10, 0x222222);
+	EXPECT_EQ(0x111111u, img.GetPixel({ 17, 8 }));
+	EXPECT_EQ(0x222222u, img.GetPixel({ 19, 8 }));
+}
+
+TEST(ImageBulkAccessTest, ReadRectMatchesGetPixel)
+{
+	Image img({ 19, 13 }, 0);
+	for (int y = 0; y < 13; ++y)
+	{
+		for (int x = 0; x < 19; ++x)
+		{
+			img.SetPixel({ x, y }, static_cast<Color>(y * 100 + x));
+		}
+	}
+
+	std::vector<Color> rect(7 * 5);
+	img.ReadRect({ 6, 5 }, { 7, 5 }, rect);
+	for (int y = 0; y < 5; ++y)
+	{
+		for (int x = 0; x < 7; ++x)
+		{
+			EXPECT_EQ(img.GetPixel({ 6 + x, 5 + y }), rect[static_cast<size_t>(y * 7 + x)]);
+		}
+	}
+}
+
+TEST(ImageBulkAccessTest, MutableTileCopiesSharedTileOnce)
+{
+	TestImage img({ 16, 8 }, 0x0F0F0F);
+	Tile& tile = img.GetMutableTile(1, 0);
+	tile.FillRow(3, 2, 6, 0xF0F0F0);
+
+	EXPECT_EQ(1, img.Tiles()[1].GetLinksCount());
+	EXPECT_EQ(1, img.Tiles()[0].GetLinksCount());
+	EXPECT_EQ(0xF0F0F0u, img.GetPixel({ 10, 3 }));
+	EXPECT_EQ(0x0F0F0Fu, img.GetPixel({ 14, 3 }));
+	EXPECT_EQ(0x0F0F0Fu, img.GetPixel({ 2, 3 }));
+	EXPECT_EQ(&tile, &img.GetTile(1, 0));
+}
+
+// Заливка по точкам Брезенхэма, как её делал FillCircle через SetPixel.
+Image FillCirclePerPixel(Size size, Point center, int radius, Color color)
+{
+	Image image(size, 0);
+	int x = 0;
+	int y = radius;
+	int d = 3 - 2 * radius;
+	while (y >= x)
+	{
+		for (int xx = center.x - x; xx <= center.x + x; ++xx)
+		{
+			image.SetPixel({ xx, center.y + y }, color);
+			image.SetPixel({ xx, center.y - y }, color);
+		}
+		for (int xx = center.x - y; xx <= center.x + y; ++xx)
+		{
+			image.SetPixel({ xx, center.y + x }, color);
+			image.SetPixel({ xx, center.y - x }, color);
+		}
+		d += d <= 0 ? 4 * x + 6 : 4 * (x - y--) + 10;
+		++x;
+	}
+	return image;
+}
+
+TEST(DrawerTest, FillCircleMatchesPerPixelFill)
+{
+	const Size size{ 40, 30 };
+	const Point centers[] = { { 17, 12 }, { -5, 3 }, { 39, 29 }, { 20, -9 } };
+	for (Point center : centers)
+	{
+		for (int radius : { 0, 1, 4, 9, 15, 30 })
+		{
+			Image expected = FillCirclePerPixel(size, center, radius, 0x00FF00);
+			Image actual(size, 0);
+			FillCircle(actual, center, radius, 0x00FF00);
+
+			for (int y = 0; y < size.height; ++y)
+			{
+				for (int x = 0; x < size.width; ++x)
+				{
+					ASSERT_EQ(expected.GetPixel({ x, y }), actual.GetPixel({ x, y }))
+						<< "center " << center.x << "," << center.y << " radius " << radius
+						<< " at " << x << "," << y;
+				}
+			}
+		}
+	}
+}
+
+TEST(TileStorageTest, PixelsAreCacheLineAligned)
+{
+	TestImage img({ 3 * Tile::SIZE, 2 * Tile::SIZE }, 0);
+	img.SetPixel({ 0, 0 }, 1);
+	img.SetPixel({ 2 * Tile::SIZE, Tile::SIZE }, 2);
+
+	for (const auto& tile : img.Tiles())
+	{
+		const auto address = reinterpret_cast<std::uintptr_t>(tile->GetRow(0).data());
+		EXPECT_EQ(0u, address % 64);
+	}
+}
+
+TEST(TileStorageTest, ReleasedTilesReturnToPool)
+{
+	const auto liveBefore = Tile::allocator_type::GetPool().GetLiveBlockCount();
+	{
+		Image img({ 4 * Tile::SIZE, 4 * Tile::SIZE }, 0);
+		for (int i = 0; i < 4; ++i)
+		{
+			img.SetPixel({ i * Tile::SIZE, i * Tile::SIZE }, 0xFF);
+		}
+		EXPECT_EQ(5, Tile::GetInstanceCount());
+		EXPECT_EQ(liveBefore + 5, Tile::allocator_type::GetPool().GetLiveBlockCount());
+	}
+	EXPECT_EQ(0, Tile::GetInstanceCount());
+	EXPECT_EQ(liveBefore, Tile::allocator_type::GetPool().GetLiveBlockCount());
+
+	const auto reservedBefore = Tile::allocator_type::GetPool().GetReservedBytes();
+	for (int round = 0; round < 10; ++round)
+	{
+		Image img({ 4 * Tile::SIZE, 4 * Tile::SIZE }, 0);
+		img.FillRect({ 0, 0 }, { 4 * Tile::SIZE, 4 * Tile::SIZE }, 1);
+		img.SetPixel({ 0, 0 }, 2);
+	}
+	EXPECT_EQ(reservedBefore, Tile::allocator_type::GetPool().GetReservedBytes());
+}
+
+TEST(DrawListTest, MatchesSerialDrawing)
+{
+	const Size size{ 5 * Tile::SIZE + 3, 4 * Tile::SIZE + 1 };
+	std::srand(42);
+	auto randomCoord = [](int extent) {
+		return std::rand() % (extent + 20) - 10;
+	};
+
+	Image expected(size, 0x101010);
+	DrawList list;
+	for (Color color = 1; color <= 600; ++color)
+	{
+		const Point a{ randomCoord(size.width), randomCoord(size.height) };
+		const Point b{ randomCoord(size.width), randomCoord(size.height) };
+		const int radius = std::rand() % 25;
+		switch (color % 3)
+		{
+		case 0:
+			DrawLine(expected, a, b, color);
+			list.AddLine(a, b, color);
+			break;
+		case 1:
+			DrawCircle(expected, a, radius, color);
+			list.AddCircle(a, radius, color);
+			break;
+		default:
+			FillCircle(expected, a, radius, color);
+			list.AddFilledCircle(a, radius, color);
+			break;
+		}
+	}
+	ASSERT_EQ(600u, list.GetSize());
+
+	for (unsigned threadCount : { 1u, 4u })
+	{
+		TestImage actual(size, 0x101010);
+		list.Render(actual, threadCount);
+		const auto grid = actual.GetTileGridSize();
+		for (int tileY = 0; tileY < grid.height; ++tileY)
+		{
+			for (int tileX = 0; tileX < grid.width; ++tileX)
+			{
+				for (int y = 0; y < Tile::SIZE; ++y)
+				{
+					auto expectedRow = expected.GetTile(tileX, tileY).GetRow(y);
+					auto actualRow = actual.GetTile(tileX, tileY).GetRow(y);
+					ASSERT_TRUE(std::equal(expectedRow.begin(), expectedRow.end(), actualRow.begin()))
+						<< "tile " << tileX << "," << tileY << " row " << y << " threads " << threadCount;
+				}
+			}
+		}
+	}
+}
+
+TEST(DrawListTest, BinsOnlyTilesNearPrimitives)
+{
+	const Size size{ 64 * Tile::SIZE, 48 * Tile::SIZE };
+	Image expected(size, 0);
+	TestImage actual(size, 0);
+	DrawList list;
+
+	const Point center{ 20 * Tile::SIZE + 3, 30 * Tile::SIZE + 5 };
+	FillCircle(expected, center, Tile::SIZE, 5);
+	list.AddFilledCircle(center, Tile::SIZE, 5);
+	DrawLine(expected, { -7, 3 }, { 2 * Tile::SIZE, Tile::SIZE + 1 }, 6);
+	list.AddLine({ -7, 3 }, { 2 * Tile::SIZE, Tile::SIZE + 1 }, 6);
+	list.Render(actual, 2);
+
+	std::vector<Color> expectedRow(static_cast<size_t>(size.width));
+	std::vector<Color> actualRow(static_cast<size_t>(size.width));
+	for (int y = 0; y < size.height; ++y)
+	{
+		expected.ReadRow(y, expectedRow);
+		actual.ReadRow(y, actualRow);
+		ASSERT_EQ(expectedRow, actualRow) << "row " << y;
+	}
+
+	// Список целиком за пределами изображения ничего не меняет.
+	const size_t uniqueTiles = actual.GetUniqueTileCount();
+	DrawList outside;
+	outside.AddLine({ -20, -5 }, { -1, -30 }, 7);
+	outside.AddFilledCircle({ size.width + 10, 5 }, 9, 7);
+	outside.Render(actual);
+	EXPECT_EQ(uniqueTiles, actual.GetUniqueTileCount());
+}
+
+TEST(ImageCompactionTest, ClearedTilesShareAgain)
+{
+	TestImage img({ 4 * Tile::SIZE, 4 * Tile::SIZE }, 0);
+	for (int tileY = 0; tileY < 4; ++tileY)
+	{
+		for (int tileX = 0; tileX < 4; ++tileX)
+		{
+			img.SetPixel({ tileX * Tile::SIZE + tileX, tileY * Tile::SIZE + tileY }, 0xFF0000);
+		}
+	}
+	EXPECT_EQ(16u, img.GetUniqueTileCount());
+
+	for (int y = 0; y < 2 * Tile::SIZE; ++y)
+	{
+		for (int x = 0; x < 4 * Tile::SIZE; ++x)
+		{
+			img.SetPixel({ x, y }, 0);
+		}
+	}
+	EXPECT_EQ(16, Tile::GetInstanceCount());
+
+	EXPECT_EQ(7u, img.Compact());
+	EXPECT_EQ(9u, img.GetUniqueTileCount());
+	EXPECT_EQ(9, Tile::GetInstanceCount());
+	EXPECT_EQ(8, img.Tiles()[0].GetLinksCount());
+	EXPECT_EQ(0u, img.GetPixel({ 0, 0 }));
+	EXPECT_EQ(0xFF0000u, img.GetPixel({ 2 * Tile::SIZE + 2, 2 * Tile::SIZE + 2 }));
+	EXPECT_EQ(0u, img.Compact());
+}
+
+TEST(ImageCompactionTest, MergesEqualTilesWrittenSeparately)
+{
+	Image img({ 3 * Tile::SIZE, Tile::SIZE }, 0);
+	for (int tileX = 0; tileX < 3; ++tileX)
+	{
+		img.SetPixel({ tileX * Tile::SIZE + 1, 2 }, 0x123456);
+	}
+	EXPECT_EQ(3u, img.GetUniqueTileCount());
+	EXPECT_EQ(2u, img.Compact());
+	EXPECT_EQ(1u, img.GetUniqueTileCount());
+
+	img.SetPixel({ 1, 2 }, 0);
+	EXPECT_EQ(0x123456u, img.GetPixel({ Tile::SIZE + 1, 2 }));
+	EXPECT_EQ(0u, img.GetPixel({ 1, 2 }));
+}
+
+TEST(ImageCompactionTest, AutoCompactionRunsAfterThreshold)
+{
+	Image img({ 8 * Tile::SIZE, Tile::SIZE }, 0);
+	img.SetAutoCompaction(4);
+	for (int tileX = 0; tileX < 3; ++tileX)
+	{
+		img.SetPixel({ tileX * Tile::SIZE, 0 }, 1);
+	}
+	EXPECT_EQ(4u, img.GetUniqueTileCount());
+
+	img.SetPixel({ 3 * Tile::SIZE, 0 }, 1);
+	EXPECT_EQ(2u, img.GetUniqueTileCount());
+	EXPECT_EQ(1u, img.GetPixel({ 3 * Tile::SIZE, 0 }));
+}
+
+TEST(ImageCompactionTest, LaterAutoPassesMergeChangedTilesWithInterned)
+{
+	TestImage img({ 8 * Tile::SIZE, Tile::SIZE }, 0);
+	img.SetAutoCompaction(2);
+	img.SetPixel({ 0, 0 }, 1);
+	img.SetPixel({ Tile::SIZE, 0 }, 1);
+	EXPECT_EQ(2u, img.GetUniqueTileCount());
+
+	// Проход сравнивает изменённые тайлы с запомненными: одинаковые с тайлом 0
+	// сливаются с ним, а возвращённый к фону тайл — с общим фоновым.
+	img.SetPixel({ 2 * Tile::SIZE, 0 }, 1);
+	img.SetPixel({ 3 * Tile::SIZE, 0 }, 1);
+	EXPECT_EQ(2u, img.GetUniqueTileCount());
+	EXPECT_EQ(&img.GetTile(0, 0), &img.GetTile(3, 0));
+
+	img.SetPixel({ 3 * Tile::SIZE, 0 }, 0);
+	img.SetPixel({ 4 * Tile::SIZE + 5, 0 }, 2);
+	EXPECT_EQ(3u, img.GetUniqueTileCount());
+	EXPECT_EQ(&img.GetTile(3, 0), &img.GetTile(7, 0));
+	EXPECT_EQ(2u, img.GetPixel({ 4 * Tile::SIZE + 5, 0 }));
+	EXPECT_EQ(0u, img.GetPixel({ 3 * Tile::SIZE, 0 }));
+
+	// Запись в запомненный экземпляр копирует тайл, остальные его не видят.
+	img.SetPixel({ 0, 0 }, 3);
+	img.SetPixel({ 5 * Tile::SIZE, 0 }, 3);
+	EXPECT_EQ(1u, img.GetPixel({ Tile::SIZE, 0 }));
+	EXPECT_EQ(3u, img.GetPixel({ 0, 0 }));
+	EXPECT_EQ(&img.GetTile(0, 0), &img.GetTile(5, 0));
+}
+
+TEST(ImageSnapshotTest, SnapshotSharesTilesAndRestoresImage)
+{
+	TestImage img({ 2 * Tile::SIZE, 2 * Tile::SIZE }, 0);
+	img.SetPixel({ 1, 1 }, 0xFF);
+	const Image snapshot = img.Snapshot();
+	EXPECT_EQ(2, img.Tiles()[0].GetLinksCount());
+	EXPECT_EQ(2, Tile::GetInstanceCount());
+
+	img.SetPixel({ 1, 1 }, 0xAA);
+	EXPECT_EQ(3, Tile::GetInstanceCount());
+
+	static_cast<Image&>(img) = snapshot;
+	EXPECT_EQ(0xFFu, img.GetPixel({ 1, 1 }));
+	EXPECT_EQ(2, Tile::GetInstanceCount());
+}
+
+TEST(ImageSnapshotTest, DiffReportsChangedTilesOnly)
+{
+	Image img({ 4 * Tile::SIZE + 3, 3 * Tile::SIZE }, 0);
+	const Image before = img.Snapshot();
+	EXPECT_TRUE(Diff(before, img).empty());
+
+	img.SetPixel({ 4 * Tile::SIZE + 1, 0 }, 1);
+	img.FillRect({ Tile::SIZE, Tile::SIZE }, { 2 * Tile::SIZE, 2 * Tile::SIZE }, 2);
+	// Записанный, но совпадающий по пикселям тайл не считается изменённым.
+	img.SetPixel({ 0, 2 * Tile::SIZE }, 0);
+
+	const auto rects = Diff(before, img);
+	ASSERT_EQ(2u, rects.size());
+	EXPECT_EQ(4 * Tile::SIZE, rects[0].topLeft.x);
+	EXPECT_EQ(0, rects[0].topLeft.y);
+	EXPECT_EQ(3, rects[0].size.width);
+	EXPECT_EQ(Tile::SIZE, rects[0].size.height);
+	EXPECT_EQ(Tile::SIZE, rects[1].topLeft.x);
+	EXPECT_EQ(Tile::SIZE, rects[1].topLeft.y);
+	EXPECT_EQ(2 * Tile::SIZE, rects[1].size.width);
+	EXPECT_EQ(2 * Tile::SIZE, rects[1].size.height);
+
+	EXPECT_THROW(Diff(img, Image({ 1, 1 })), std::invalid_argument);
+}
+
+TEST(CoWConcurrencyTest, WritersOnSnapshotsDoNotAffectEachOther)
+{
+	const Size size{ 4 * Tile::SIZE, 4 * Tile::SIZE };
+	Image master(size, 0);
+	master.FillRect({ 0, 0 }, { Tile::SIZE, Tile::SIZE }, 7);
+
+	for (int round = 0; round < 20; ++round)
+	{
+		std::vector<Color> original(static_cast<size_t>(size.width * size.height));
+		master.ReadRect({ 0, 0 }, size, original);
+
+		std::vector<Image> copies;
+		for (int t = 0; t < 4; ++t)
+		{
+			copies.push_back(master.Snapshot());
+		}
+		std::vector<std::thread> writers;
+		for (int t = 0; t < 4; ++t)
+		{
+			writers.emplace_back([&image = copies[t], size, t] {
+				for (int y = 0; y < size.height; ++y)
+				{
+					for (int x = (y + t) % 3; x < size.width; x += 3)
+					{
+						image.SetPixel({ x, y }, static_cast<Color>(t + 1));
+					}
+				}
+			});
+		}
+		// Исходное изображение меняется и снимается, пока копии меняются в
+		// других потоках.
+		for (int x = 0; x < size.width; ++x)
+		{
+			master.SetPixel({ x, x }, static_cast<Color>(100 + round));
+			const Image snapshot = master.Snapshot();
+			EXPECT_EQ(static_cast<Color>(100 + round), snapshot.GetPixel({ x, x }));
+		}
+		for (auto& writer : writers)
+		{
+			writer.join();
+		}
+
+		for (int t = 0; t < 4; ++t)
+		{
+			for (int y = 0; y < size.height; ++y)
+			{
+				for (int x = 0; x < size.width; ++x)
+				{
+					const bool isWritten = x >= (y + t) % 3 && (x - (y + t) % 3) % 3 == 0;
+					const Color expected = isWritten ? static_cast<Color>(t + 1) : original[y * size.width + x];
+					ASSERT_EQ(expected, copies[t].GetPixel({ x, y }));
+				}
+			}
+		}
+	}
+	EXPECT_EQ(7u, master.GetPixel({ 1, 0 }));
+	EXPECT_EQ(119u, master.GetPixel({ 5, 5 }));
+}
+
+TEST(ImageMipTest, LevelsAverageTwoByTwoBlocks)
+{
+	Image img({ 3, 2 }, 0);
+	img.SetPixel({ 0, 0 }, 0x0000FF);
+	img.SetPixel({ 1, 1 }, 0x000001);
+	img.SetPixel({ 2, 0 }, 0x102030);
+	img.SetPixel({ 2, 1 }, 0x102032);
+
+	ASSERT_EQ(3, img.GetMipLevelCount());
+	EXPECT_EQ(2, img.GetMipSize(1).width);
+	EXPECT_EQ(1, img.GetMipSize(1).height);
+	EXPECT_EQ(0x000040u, img.GetMipPixel(1, { 0, 0 }));
+	EXPECT_EQ(0x102031u, img.GetMipPixel(1, { 1, 0 }));
+	EXPECT_EQ(0x081039u, img.GetMipPixel(2, { 0, 0 }));
+	EXPECT_THROW(img.GetMipSize(3), std::out_of_range);
+}
+
+TEST(ImageMipTest, UniformRegionsShareTheBaseTile)
+{
+	TestImage img({ 64 * Tile::SIZE, 64 * Tile::SIZE }, 0x123456);
+	const int level = 3;
+	std::vector<Color> row(static_cast<size_t>(img.GetMipSize(level).width));
+	img.ReadMipRow(level, 5, row);
+	EXPECT_TRUE(std::all_of(row.begin(), row.end(), [](Color c) { return c == 0x123456; }));
+	EXPECT_EQ(1, Tile::GetInstanceCount());
+	EXPECT_EQ(&*img.Tiles()[0], &img.GetMipTile(level, 0, 0));
+}
+
+TEST(ImageMipTest, WritesInvalidateOnlyAncestorTiles)
+{
+	Image img({ 16 * Tile::SIZE, 16 * Tile::SIZE }, 0);
+	img.FillRect({ 0, 0 }, { 16 * Tile::SIZE, 16 * Tile::SIZE / 2 }, 0xFFFFFF);
+	img.SetPixel({ 3, 3 }, 0);
+
+	const Tile* untouched = &img.GetMipTile(1, 7, 7);
+	EXPECT_EQ(0xFFFFFFu, img.GetMipPixel(1, { 0, 0 }));
+	const Color before = img.GetMipPixel(1, { 1, 1 });
+
+	img.FillRect({ 0, 0 }, { 4, 4 }, 0x000000);
+	EXPECT_EQ(untouched, &img.GetMipTile(1, 7, 7));
+	EXPECT_EQ(0u, img.GetMipPixel(1, { 1, 1 }));
+	EXPECT_NE(before, img.GetMipPixel(1, { 1, 1 }));
+	EXPECT_EQ(0u, img.GetMipPixel(1, { 0, 0 }));
+
+	// Снимок сохраняет свои уровни независимо от изменений оригинала.
+	const Image snapshot = img.Snapshot();
+	img.SetPixel({ 16 * Tile::SIZE - 1, 0 }, 0);
+	EXPECT_EQ(0xFFFFFFu, snapshot.GetMipPixel(1, { 8 * Tile::SIZE - 1, 0 }));
+	EXPECT_NE(0xFFFFFFu, img.GetMipPixel(1, { 8 * Tile::SIZE - 1, 0 }));
+}
+
+namespace
+{
+void DrawScene(Image& img)
+{
+	const Size size = img.GetSize();
+	DrawLine(img, { 0, 0 }, { size.width - 1, size.height - 1 }, 0xFF0000);
+	DrawLine(img, { size.width - 1, 3 }, { 2, size.height - 5 }, 0x00FF00);
+	DrawCircle(img, { size.width / 2, size.height / 2 }, size.height / 3, 0x0000FF);
+	FillCircle(img, { size.width / 3, size.height / 2 }, size.height / 4, 0xFFFF00);
+	img.FillRect({ 5, 7 }, { 3 * Tile::SIZE, 2 * Tile::SIZE + 1 }, 0x00FFFF);
+	std::vector<Color> span(static_cast<size_t>(size.width));
+	for (size_t i = 0; i < span.size(); ++i)
+	{
+		span[i] = static_cast<Color>(i * 2654435761u);
+	}
+	img.WriteRow(size.height - 2, span);
+
+	DrawList list;
+	list.AddLine({ 0, size.height - 1 }, { size.width - 1, 0 }, 0x808080);
+	list.AddFilledCircle({ size.width - 10, 10 }, 2 * Tile::SIZE, 0x102030);
+	list.AddCircle({ 10, size.height - 10 }, Tile::SIZE, 0x405060);
+	list.Render(img, 2);
+}
+} // namespace
+
+TEST(ImagePagingTest, DrawingMatchesInMemoryImage)
+{
+	const Size size{ 12 * Tile::SIZE + 3, 9 * Tile::SIZE + 5 };
+	Image expected(size, 0x111111);
+	Image paged(size, 0x111111, PagingOptions{ 4 });
+	ASSERT_TRUE(paged.IsPaged());
+	DrawScene(expected);
+	DrawScene(paged);
+
+	for (int y = 0; y < size.height; ++y)
+	{
+		for (int x = 0; x < size.width; ++x)
+		{
+			ASSERT_EQ(expected.GetPixel({ x, y }), paged.GetPixel({ x, y })) << x << "," << y;
+		}
+	}
+	const Size mipSize = expected.GetMipSize(1);
+	for (int y = 0; y < mipSize.height; ++y)
+	{
+		for (int x = 0; x < mipSize.width; ++x)
+		{
+			ASSERT_EQ(expected.GetMipPixel(1, { x, y }), paged.GetMipPixel(1, { x, y })) << x << "," << y;
+		}
+	}
+	EXPECT_TRUE(Diff(expected, paged).empty());
+}
+
+TEST(ImagePagingTest, KeepsOnlyResidentTilesInMemory)
+{
+	const size_t resident = 16;
+	Image img({ 64 * Tile::SIZE, 64 * Tile::SIZE }, 0, PagingOptions{ resident });
+	for (int i = 0; i < 64 * Tile::SIZE; i += 3)
+	{
+		DrawLine(img, { 0, i }, { 64 * Tile::SIZE - 1, 64 * Tile::SIZE - 1 - i }, static_cast<Color>(i));
+	}
+	// Загруженные тайлы и не больше стольких же в очереди записи.
+	EXPECT_LE(Tile::GetInstanceCount(), static_cast<int>(2 * resident));
+	EXPECT_EQ(static_cast<Color>(0), img.GetPixel({ 0, 0 }));
+	EXPECT_EQ(static_cast<Color>(3), img.GetPixel({ 64 * Tile::SIZE - 1, 64 * Tile::SIZE - 4 }));
+}
+
+TEST(ImagePagingTest, UniformTilesAreStoredAsColor)
+{
+	Image img({ 4 * Tile::SIZE, 4 * Tile::SIZE }, 0x010101, PagingOptions{ 4 });
+	img.FillRect({ 0, 0 }, { 2 * Tile::SIZE, 4 * Tile::SIZE }, 0x020202);
+	img.SetPixel({ 3 * Tile::SIZE, 0 }, 0x030303);
+	// Тайлы изменены, но остались однотонными.
+	for (int x = 2 * Tile::SIZE; x < 4 * Tile::SIZE; ++x)
+	{
+		img.SetPixel({ x, 4 * Tile::SIZE - 1 }, 0x010101);
+	}
+	// Два цвета и один тайл в файле.
+	EXPECT_EQ(3u, img.GetUniqueTileCount());
+
+	img.SetPixel({ 3 * Tile::SIZE, 0 }, 0x010101);
+	EXPECT_EQ(2u, img.GetUniqueTileCount());
+	EXPECT_EQ(0x020202u, img.GetPixel({ 0, 4 * Tile::SIZE - 1 }));
+	EXPECT_EQ(0x010101u, img.GetPixel({ 3 * Tile::SIZE, 0 }));
+
+	EXPECT_THROW(Image copy(img), std::logic_error);
+}
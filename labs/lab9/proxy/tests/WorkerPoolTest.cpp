@@ -0,0 +1,52 @@
+//
+// Created by smmm on 05.12.2025.
+//
+#include "../src/lib/WorkerPool.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(WorkerPoolTest, RunsEveryJobOnceAndReusesThreads)
+{
+	WorkerPool pool;
+	for (size_t batch = 0; batch < 50; ++batch)
+	{
+		std::vector<std::atomic<int>> calls(batch);
+		pool.Run(calls.size(), [&](size_t i) { ++calls[i]; }, 4);
+		for (const auto& count : calls)
+		{
+			EXPECT_EQ(1, count.load());
+		}
+	}
+	// Вызывающий поток работает сам, пулу хватает трёх.
+	EXPECT_EQ(3u, pool.GetThreadCount());
+
+	pool.Run(10, [](size_t) {}, 2);
+	EXPECT_EQ(3u, pool.GetThreadCount());
+}
+
+TEST(WorkerPoolTest, SingleThreadRunsOnCaller)
+{
+	WorkerPool pool;
+	const auto caller = std::this_thread::get_id();
+	pool.Run(20, [&](size_t) { EXPECT_EQ(caller, std::this_thread::get_id()); }, 1);
+	EXPECT_EQ(0u, pool.GetThreadCount());
+}
+
+TEST(WorkerPoolTest, RethrowsJobErrorAndStaysUsable)
+{
+	WorkerPool pool;
+	const auto failing = [](size_t i) {
+		if (i == 10)
+		{
+			throw std::runtime_error("job failed");
+		}
+	};
+	EXPECT_THROW(pool.Run(100, failing, 3), std::runtime_error);
+
+	std::atomic<size_t> sum = 0;
+	pool.Run(10, [&](size_t i) { sum += i; }, 3);
+	EXPECT_EQ(45u, sum.load());
+}